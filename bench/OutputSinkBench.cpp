@@ -0,0 +1,99 @@
+#include <OutputSink.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Writes the same bytes to a file through each way tike can, and prints how long each took:
+ *
+ *     tike_output_bench <directory> [MiB, 1024] [chunk KiB, 400] [rounds, 2]
+ *
+ * ofstream is what exports used before OutputSink. The others are OutputSink with plain write() calls, with
+ * io_uring, and with io_uring and O_DIRECT. The time ends when finish() returns, without an fsync, so the
+ * buffered methods can look fast until the page cache fills and writeback starts to throttle them. The first
+ * round pays for that more than the later ones, run at least two.
+ */
+namespace {
+	struct Method {
+		const char *name;
+		std::function<void(const std::string &path, const std::string &chunk, std::size_t chunks)> run;
+	};
+
+	void writeSink(tike::OutputSink &sink, const std::string &chunk, const std::size_t chunks) {
+		for (std::size_t index = 0; index < chunks; index++) {
+			sink.write(chunk);
+		}
+		sink.finish();
+	}
+
+	const Method methods[] = {
+		{
+			"ofstream", [](const std::string &path, const std::string &chunk, const std::size_t chunks) {
+				std::ofstream out(path, std::ios::binary | std::ios::trunc);
+				for (std::size_t index = 0; index < chunks; index++) {
+					out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+				}
+				out.flush();
+			}
+		},
+		{
+			"write()", [](const std::string &path, const std::string &chunk, const std::size_t chunks) {
+				writeSink(*tike::openOutputFile(path, {.uring = false}), chunk, chunks);
+			}
+		},
+		{
+			"io_uring", [](const std::string &path, const std::string &chunk, const std::size_t chunks) {
+				writeSink(*tike::openOutputFile(path), chunk, chunks);
+			}
+		},
+		{
+			"io_uring O_DIRECT", [](const std::string &path, const std::string &chunk, const std::size_t chunks) {
+				writeSink(*tike::openOutputFile(path, {.direct = true}), chunk, chunks);
+			}
+		},
+	};
+}
+
+int main(const int argc, const char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <directory> [MiB] [chunk KiB] [rounds]" << std::endl;
+		return 1;
+	}
+
+	try {
+		const std::filesystem::path directory = argv[1];
+		const std::size_t mebibytes = argc > 2 ? std::stoul(argv[2]) : 1024;
+		const std::size_t chunkSize = (argc > 3 ? std::stoul(argv[3]) : 400) * 1024;
+		const int rounds = argc > 4 ? std::stoi(argv[4]) : 2;
+		if (chunkSize == 0) {
+			throw std::invalid_argument("The chunk size must be at least 1 KiB");
+		}
+
+		const std::string chunk(chunkSize, 'x');
+		const std::size_t chunks = mebibytes * 1024 * 1024 / chunkSize;
+		const double megabytes = static_cast<double>(chunks * chunkSize) / 1e6;
+		const std::string path = (directory / "tike_output_bench.out").string();
+
+		// Says which methods really run here, the io_uring ones fall back to write() where it is missing
+		std::cout << "io_uring sinks use: " << tike::openOutputFile(path)->method() << std::endl;
+		for (int round = 1; round <= rounds; round++) {
+			std::cout << "Round " << round << std::endl;
+			for (const auto &[name, run]: methods) {
+				const auto start = std::chrono::steady_clock::now();
+				run(path, chunk, chunks);
+				const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				std::printf("  %-18s %7.3f s %8.0f MB/s\n", name, seconds, megabytes / seconds);
+				std::filesystem::remove(path);
+			}
+		}
+	} catch (const std::exception &error) {
+		std::cerr << "Error: " << error.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
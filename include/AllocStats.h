@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+/*
+ * Heap allocation counting for the instrumentation build, `cmake -DTIKE_ALLOC_STATS=ON`. It replaces the global
+ * operator new and delete with versions that count every call before passing it on to malloc and free, and
+ * `--perf-counters` then reports the allocations and bytes of each phase. SQLite allocates with malloc directly,
+ * its share is reported from its own memory statistics instead.
+ *
+ * Regular builds don't compile AllocStats.cpp and keep the standard operators. Not available on Windows, where
+ * aligned allocations need a matching free of their own.
+ */
+namespace tike {
+	/**
+	 * @brief Totals since the start of the process, over all threads.
+	 *
+	 * @param allocations Calls to operator new, of any form.
+	 * @param bytes The bytes those calls asked for.
+	 * @param frees Calls to operator delete with a pointer that wasn't null.
+	 */
+	struct AllocCounts {
+		std::uint64_t allocations = 0;
+		std::uint64_t bytes = 0;
+		std::uint64_t frees = 0;
+	};
+
+	/**
+	 * @brief The counts so far. Only defined in builds with TIKE_ALLOC_STATS.
+	 */
+	AllocCounts allocCounts();
+}
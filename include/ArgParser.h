@@ -1,138 +1,551 @@
 #pragma once
-#include <optional>
-#include <string>
-#include <utility>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <variant>
 #include <vector>
 
 /*
  * Everything is referred to as an arg.
  * Options, positional arguments, non-positional arguments. All arg/arguments
  *
+ * The options are declared once as a constexpr table (see makeArgTable). Everything the parser needs at
+ * runtime is derived from that table at compile time: a perfect hash for the long names, a direct lookup
+ * table for the short names and the help page text.
+ *
  * Comes with built-in help command. To use where ever you do your arg handling just handle this as well.
  */
 namespace tike {
+	/**
+	 * @brief The kind of value an argument carries.
+	 *
+	 * Flags take no value, Int values are parsed once with std::from_chars and String values are kept as
+	 * views into argv, so no argument value is ever copied. List arguments may be given more than once and
+	 * collect their String values in order.
+	 */
+	enum class ArgType : std::uint8_t {
+		Flag,
+		Int,
+		String,
+		List
+	};
+
 	/**
 	 * @struct Arg
 	 * @brief Represents a command-line argument definition.
 	 *
 	 * This structure is used to define the properties of a command-line argument
 	 * including its name, type, description, and whether it is required or optional.
-	 * It supports both long-form and short-form argument names and optionally allows
-	 * a value to be associated with the argument.
+	 * It supports both long-form and short-form argument names.
 	 *
-	 * The `Arg` structure is primarily used within argument-parsing utilities to
-	 * define and process command-line arguments.
+	 * The `Arg` structure is a literal type so that whole tables of arguments can be
+	 * declared as constexpr and processed at compile time by makeArgTable.
 	 *
 	 * @param name The long-form name of the argument. Used with a double dash (e.g., `--name`).
-	 * @param shortName An optional short-form name for the argument. Used with a single dash (e.g., `-n`).
-	 * @param value An optional value associated with the argument. May contain the argument's value after parsing.
-	 * @param type Specifies the type of the argument (e.g., "flag", "string"). Defines how the argument is processed.
+	 * @param shortName An optional one character short-form name for the argument. Used with a single dash (e.g., `-n`).
+	 *        Empty if the argument has no short form.
+	 * @param type Specifies the type of the argument. Defines how the argument is processed.
 	 * @param description A brief description of the argument, used for generating help or usage information.
 	 * @param required Indicates whether this argument is mandatory. Defaults to `false`.
+	 * @param optionalValue For Int arguments, whether the value may be left out (e.g. `--next` or `--next 5`).
+	 *        Read such arguments with ArgParser::getIntOr.
 	 */
 	struct Arg {
-		std::string name;
-		std::optional<std::string> shortName;
-		std::optional<std::string> value;
-		std::string type;
-		std::string description;
-		bool required;
-
-		explicit Arg(std::string name, std::optional<std::string> shortName, std::string type,
-					 std::string description = "Default argument description", const bool required = false) {
-			this->name = std::move(name);
-			this->shortName = std::move(shortName);
-			this->value = std::nullopt;
-			this->type = std::move(type);
-			this->description = std::move(description);
-			this->required = required;
+		std::string_view name;
+		std::string_view shortName;
+		ArgType type = ArgType::Flag;
+		std::string_view description = "Default argument description";
+		bool required = false;
+		bool optionalValue = false;
+	};
+
+	/**
+	 * @brief The parsed value of an argument.
+	 *
+	 * std::monostate means the argument was not supplied. The other alternatives match ArgType::Flag,
+	 * ArgType::Int, ArgType::String and ArgType::List. An Int argument with an optional value that was given
+	 * without one holds `true`.
+	 */
+	using ArgValue = std::variant<std::monostate, bool, std::int64_t, std::string_view, std::vector<std::string_view>>;
+
+	/**
+	 * @struct Subcommand
+	 * @brief A named command given as the first word on the command line, e.g. `tike add -t Title`.
+	 *
+	 * A subcommand is another way of spelling one of the options, so the rest of the program only ever has
+	 * to look at options. `tike list` sets `flagOption`, `tike list 3` passes 3 as the value of
+	 * `valueOption`. Either of the two may be empty.
+	 *
+	 * @param name The word that selects the subcommand.
+	 * @param flagOption Long name of the Flag option set when no value follows the subcommand.
+	 * @param valueOption Long name of the option that receives the value following the subcommand.
+	 * @param description A brief description of the subcommand, used for the help page.
+	 */
+	struct Subcommand {
+		std::string_view name;
+		std::string_view flagOption;
+		std::string_view valueOption;
+		std::string_view description;
+	};
+
+	namespace detail {
+		// Seeds makeArgTable tries before giving up. With the table a quarter full a few dozen are enough
+		inline constexpr std::uint32_t maxSeeds = 4096;
+
+		// Marks an empty slot in the lookup tables, slots otherwise hold an index into the argument table
+		inline constexpr std::uint8_t emptySlot = 0xFF;
+
+		/*
+		 * FNV-1a, salted with a seed so makeArgTable can search for a collision free one. Slots are picked
+		 * with the low bits, which FNV alone barely changes between seeds, so the result is mixed once more.
+		 */
+		constexpr std::uint32_t hashName(const std::string_view name, const std::uint32_t seed) {
+			std::uint32_t hash = 2166136261u ^ seed;
+			for (const char c: name) {
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 16777619u;
+			}
+			hash ^= hash >> 16;
+			hash *= 0x85EBCA6Bu;
+			hash ^= hash >> 13;
+			hash *= 0xC2B2AE35u;
+			hash ^= hash >> 16;
+			return hash;
+		}
+
+		/*
+		 * Smallest power of two that leaves the table at most a quarter full. The chance that a seed is collision
+		 * free falls quickly with the load, at a quarter it stays high enough for the seed search to finish in a
+		 * handful of tries with dozens of names
+		 */
+		constexpr std::size_t slotCount(const std::size_t count) {
+			std::size_t slots = 1;
+			while (slots < count * 4) {
+				slots <<= 1;
+			}
+			return slots;
+		}
+
+		/*
+		 * Tries seeds until every name hashes to its own slot, fills `slots` with the index of each name
+		 * and returns the seed. Throws if two names are the same, as no seed can separate those.
+		 */
+		template<std::size_t Slots, typename Items, typename Projection>
+		constexpr std::uint32_t buildPerfectHash(const Items &items, Projection name,
+		                                         std::array<std::uint8_t, Slots> &slots) {
+			for (std::uint32_t seed = 0; seed < maxSeeds; seed++) {
+				slots.fill(emptySlot);
+				bool collision = false;
+				for (std::size_t index = 0; index < items.size() && !collision; index++) {
+					auto &slot = slots[hashName(name(items[index]), seed) & (Slots - 1)];
+					if (slot != emptySlot) {
+						if (name(items[slot]) == name(items[index])) {
+							throw std::invalid_argument("Duplicate name in argument table");
+						}
+						collision = true;
+					}
+					slot = static_cast<std::uint8_t>(index);
+				}
+				if (!collision) {
+					return seed;
+				}
+			}
+			// Fails the build instead of letting the compiler loop forever
+			throw std::invalid_argument("No collision free hash seed found for the argument names");
+		}
+
+		// Looks a name up in a table built by buildPerfectHash, returns its index or -1
+		constexpr int lookup(const std::string_view name, const std::uint32_t seed,
+		                     const std::span<const std::uint8_t> slots, const auto &items) {
+			const std::uint8_t slot = slots[hashName(name, seed) & (slots.size() - 1)];
+			return slot != emptySlot && items[slot].name == name ? slot : -1;
+		}
+	} // namespace detail
+
+	/**
+	 * @brief A compile-time argument table together with its lookup structures.
+	 *
+	 * Built by makeArgTable. `longSlots` is a perfect hash over the long names: hashing a name with `seed`
+	 * lands on exactly one slot, so a lookup is one hash plus one string comparison. `shortSlots` is indexed
+	 * directly by the short name character. Subcommands get a perfect hash of their own, and the options
+	 * they stand for are resolved to indices up front.
+	 */
+	template<std::size_t N, std::size_t C = 0>
+	struct ArgTable {
+		static constexpr std::size_t slots = detail::slotCount(N);
+		static constexpr std::size_t subcommandSlotCount = detail::slotCount(C);
+
+		std::string_view program;
+		std::string_view description;
+		std::array<Arg, N> args{};
+		std::uint32_t seed = 0;
+		std::array<std::uint8_t, slots> longSlots{};
+		std::array<std::uint8_t, 128> shortSlots{};
+
+		std::array<Subcommand, C> subcommands{};
+		std::uint32_t subcommandSeed = 0;
+		std::array<std::uint8_t, subcommandSlotCount> subcommandSlots{};
+		std::array<std::uint8_t, C> subcommandFlags{};
+		std::array<std::uint8_t, C> subcommandValues{};
+
+		/**
+		 * @brief Finds the index of an argument by its long name.
+		 *
+		 * @param name The long name of the argument.
+		 * @return The index into `args`, or -1 if there is no argument with that name.
+		 */
+		[[nodiscard]] constexpr int find(const std::string_view name) const {
+			return detail::lookup(name, seed, longSlots, args);
 		}
 	};
 
+	/**
+	 * @brief Builds an argument table with subcommands at compile time.
+	 *
+	 * Adds the built-in `--help`/`-h` flag, validates the definitions and searches for hash seeds that map
+	 * every long name and every subcommand to its own slot. Any mistake in the table (duplicate names, short
+	 * names longer than one character, subcommands naming options that don't exist) fails the build instead
+	 * of showing up at runtime.
+	 *
+	 * @param program The name of the program. Typically displayed in usage/help information.
+	 * @param description A short description of what the program does.
+	 * @param args The arguments the program accepts.
+	 * @param subcommands The subcommands the program accepts.
+	 * @return The finished table, ready to be handed to ArgParser::fromTable.
+	 */
+	template<std::size_t N, std::size_t C>
+	consteval ArgTable<N + 1, C> makeArgTable(const std::string_view program, const std::string_view description,
+	                                          const std::array<Arg, N> &args,
+	                                          const std::array<Subcommand, C> &subcommands) {
+		static_assert(N + 1 < detail::emptySlot && C < detail::emptySlot, "Too many arguments for one table");
+
+		ArgTable<N + 1, C> table;
+		table.program = program;
+		table.description = description;
+		table.args[0] = Arg{"help", "h", ArgType::Flag, "Show this help page"};
+		std::ranges::copy(args, table.args.begin() + 1);
+
+		// Short names are a single character, so they index the lookup table directly
+		table.shortSlots.fill(detail::emptySlot);
+		for (std::size_t index = 0; index < table.args.size(); index++) {
+			const std::string_view shortName = table.args[index].shortName;
+			if (shortName.empty()) {
+				continue;
+			}
+			if (shortName.size() != 1 || static_cast<unsigned char>(shortName[0]) >= 128) {
+				throw std::invalid_argument("Short names must be a single ASCII character");
+			}
+			if (table.shortSlots[shortName[0]] != detail::emptySlot) {
+				throw std::invalid_argument("Duplicate short name");
+			}
+			table.shortSlots[shortName[0]] = static_cast<std::uint8_t>(index);
+		}
+
+		const auto name = [](const auto &item) { return item.name; };
+		table.seed = detail::buildPerfectHash(table.args, name, table.longSlots);
+
+		// Subcommands refer to options by name, resolve those to indices now
+		table.subcommands = subcommands;
+		table.subcommandSeed = detail::buildPerfectHash(table.subcommands, name, table.subcommandSlots);
+		const auto resolve = [&table](const std::string_view option, const ArgType type) {
+			if (option.empty()) {
+				return detail::emptySlot;
+			}
+			const int index = table.find(option);
+			if (index < 0 || (type == ArgType::Flag) != (table.args[index].type == ArgType::Flag)) {
+				throw std::invalid_argument("Subcommand refers to a missing option or one of the wrong type");
+			}
+			return static_cast<std::uint8_t>(index);
+		};
+		for (std::size_t index = 0; index < C; index++) {
+			table.subcommandFlags[index] = resolve(subcommands[index].flagOption, ArgType::Flag);
+			table.subcommandValues[index] = resolve(subcommands[index].valueOption, ArgType::Int);
+		}
+		return table;
+	}
+
+	/**
+	 * @brief Builds an argument table without subcommands at compile time.
+	 */
+	template<std::size_t N>
+	consteval ArgTable<N + 1> makeArgTable(const std::string_view program, const std::string_view description,
+	                                       const std::array<Arg, N> &args) {
+		return makeArgTable(program, description, args, std::array<Subcommand, 0>{});
+	}
+
+	namespace detail {
+		// Counts the characters the help page needs, so the buffer can be sized at compile time
+		struct CountingSink {
+			std::size_t size = 0;
+
+			constexpr void put(const std::string_view text) { size += text.size(); }
+			constexpr void pad(const std::size_t count) { size += count; }
+		};
+
+		template<std::size_t Size>
+		struct ArraySink {
+			std::array<char, Size> &buffer;
+			std::size_t position = 0;
+
+			constexpr void put(const std::string_view text) {
+				for (const char c: text) {
+					buffer[position++] = c;
+				}
+			}
+
+			constexpr void pad(const std::size_t count) {
+				for (std::size_t i = 0; i < count; i++) {
+					buffer[position++] = ' ';
+				}
+			}
+		};
+
+		// Width of "-s, --name" or "    --name", the option column without its indent
+		constexpr std::size_t optionWidth(const Arg &arg) {
+			return 4 + 2 + arg.name.size();
+		}
+
+		template<std::size_t N, std::size_t C, typename Sink>
+		constexpr void renderHelp(const ArgTable<N, C> &table, Sink &sink) {
+			// Display Usage
+			sink.put("Usage: ");
+			sink.put(table.program);
+			sink.put(C > 0 ? " [COMMAND] [OPTIONS]\n\n" : " [OPTIONS]\n\n");
+
+			// Display Description
+			if (!table.description.empty()) {
+				sink.put(table.description);
+				sink.put("\n\n");
+			}
+
+			// Sort arguments by name (long name, `name` field)
+			std::array<Arg, N> sortedArgs = table.args;
+			std::ranges::sort(sortedArgs, [](const Arg &a, const Arg &b) {
+				return a.name < b.name;
+			});
+
+			// Space between option and description
+			constexpr std::size_t padding = 6;
+			std::size_t maxOptionLength = 0;
+			for (const auto &arg: sortedArgs) {
+				maxOptionLength = std::max(maxOptionLength, optionWidth(arg));
+			}
+			for (const auto &subcommand: table.subcommands) {
+				maxOptionLength = std::max(maxOptionLength, subcommand.name.size());
+			}
+			const std::size_t descriptionStart = maxOptionLength + padding;
+
+			// Subcommands keep the order they were declared in
+			if constexpr (C > 0) {
+				sink.put("Commands:\n");
+				for (const auto &subcommand: table.subcommands) {
+					sink.put("    ");
+					sink.put(subcommand.name);
+					sink.pad(descriptionStart - 4 - subcommand.name.size());
+					sink.put(subcommand.description);
+					sink.put("\n");
+				}
+				sink.put("\n");
+			}
+
+			// Display Options Header
+			sink.put("Options:\n");
+
+			for (const auto &arg: sortedArgs) {
+				if (!arg.shortName.empty()) {
+					sink.put("    -");
+					sink.put(arg.shortName);
+					sink.put(", ");
+				} else {
+					sink.put("        ");
+				}
+				sink.put("--");
+				sink.put(arg.name);
+				sink.pad(descriptionStart - 4 - optionWidth(arg));
+				sink.put(arg.description);
+				sink.put("\n");
+			}
+		}
+
+		template<std::size_t Size>
+		struct HelpText {
+			std::array<char, Size> buffer{};
+
+			[[nodiscard]] constexpr std::string_view view() const { return {buffer.data(), Size}; }
+		};
+
+		template<const auto &Table>
+		consteval auto buildHelpText() {
+			constexpr std::size_t size = [] {
+				CountingSink sink;
+				renderHelp(Table, sink);
+				return sink.size;
+			}();
+
+			HelpText<size> text;
+			ArraySink<size> sink{text.buffer};
+			renderHelp(Table, sink);
+			return text;
+		}
+	} // namespace detail
+
+	/**
+	 * @brief The help page of an argument table, rendered at compile time.
+	 */
+	template<const auto &Table>
+	inline constexpr auto helpText = detail::buildHelpText<Table>();
+
 	class ArgParser {
 	public:
 		/**
 		 * @class ArgParser
 		 * @brief Parses and processes command-line arguments for a program.
 		 *
-		 * The ArgParser class provides a convenient interface to define, parse, and manage
-		 * command-line arguments for a program. It allows users to add custom arguments and
-		 * automatically handles a `--help` or `-h` flag to display usage information, unless disabled.
-		 *
-		 * This constructor initializes the parser with basic program information and
-		 * optionally adds a default help argument. If `customHelp` is set to `true`,
-		 * the help argument will not be automatically added, allowing custom help functionality.
+		 * The ArgParser class parses argv against a table built with makeArgTable and stores one typed
+		 * value per argument. The table and the help text live in static storage, the parser itself only
+		 * holds views of them plus the parsed values.
 		 *
-		 * @param program The name of the program. Typically displayed in usage/help information.
-		 * @param description A short description of what the program does.
-		 * @param customHelp If set to `true`, the default help argument is not added.
+		 * @tparam Table A constexpr ArgTable with static storage duration.
+		 * @return A parser for the given table.
 		 */
-		ArgParser(std::string program, std::string description, const bool customHelp = false)
-			: program(std::move(program)), description(std::move(description)) {
-			if (!customHelp) {
-				addArg(Arg("help", "h", "flag", "Show this help page"));
-			}
-		};
+		template<const auto &Table>
+		static ArgParser fromTable() {
+			return ArgParser(TableView{
+				.args = Table.args, .longSlots = Table.longSlots, .shortSlots = Table.shortSlots, .seed = Table.seed,
+				.subcommands = Table.subcommands, .subcommandSlots = Table.subcommandSlots,
+				.subcommandSeed = Table.subcommandSeed, .subcommandFlags = Table.subcommandFlags,
+				.subcommandValues = Table.subcommandValues, .help = helpText<Table>.view()
+			});
+		}
 
 		/**
 		 * @brief Parses the command-line arguments according to the defined argument specifications.
 		 *
-		 * This method interprets the provided `argc` and `argv[]` to match against the predefined
-		 * list of arguments stored in the `args` object. It supports both long-form (`--argument`)
-		 * and short-form (`-a`) argument styles, as well as flag-style arguments and those requiring
-		 * associated values.
+		 * This method interprets the provided `argc` and `argv[]` to match against the argument table.
+		 * It supports both long-form (`--argument`) and short-form (`-a`) argument styles, as well as
+		 * flag-style arguments and those requiring associated values.
+		 *
+		 * If the first argument is not an option it is looked up as a subcommand, which then sets the
+		 * option it stands for, optionally taking the next argument as that option's value.
 		 *
 		 * Key features include:
-		 * - Identification and handling of long-form and short-form argument names.
+		 * - Constant time lookup of long-form and short-form argument names.
+		 * - Parsing Int values once, with std::from_chars, so callers never re-parse them.
 		 * - Handling required arguments and ensuring they are provided by the user.
-		 * - Throwing exceptions for unknown arguments, missing values, or unexpected positional arguments.
-		 * - Associating parsed values with their respective argument definitions in the `args` list.
+		 * - Throwing exceptions for unknown arguments, missing or malformed values, or unexpected positional arguments.
 		 *
 		 * @param argc The count of arguments supplied to the program, including the program name itself.
 		 * @param argv An array of null-terminated character strings representing the arguments (including the program name).
+		 *        String values point into it, so it must outlive the parser.
 		 *
-		 * @throws std::invalid_argument If an unrecognized argument is encountered, or if required arguments or values are missing.
+		 * @throws std::invalid_argument If an unrecognized argument or subcommand is encountered, or if required
+		 *         arguments or values are missing.
 		 */
 		void parse(int argc, const char *argv[]);
 
 		/**
-		 * @brief Adds a command-line argument to the argument parser.
+		 * Checks if an argument with the specified name has a value.
 		 *
-		 * This method appends a new argument definition to the internal list of arguments
-		 * handled by the parser. The argument will be considered during parsing.
+		 * @param name The name of the argument to be checked.
+		 * @return True if an argument with the specified name exists and has a value; otherwise, false.
+		 */
+		[[nodiscard]] bool argHasValue(std::string_view name) const;
+
+		/**
+		 * @brief Retrieves the value of an Int argument.
 		 *
-		 * @param arg An object of type Arg representing the argument to be added.
-		 *            It includes the details such as name, shorthand, type, description,
-		 *            and whether it is required or optional.
+		 * @param name The name of the argument to retrieve.
+		 * @return The parsed value.
+		 * @throws std::invalid_argument If the argument doesn't exist, isn't an Int or has no value.
 		 */
-		void addArg(const Arg &arg);
+		[[nodiscard]] std::int64_t getInt(std::string_view name) const;
 
 		/**
-		 * Checks if an argument with the specified name has a specific value.
+		 * @brief Retrieves the value of an Int argument whose value may be left out.
 		 *
-		 * @param name The name of the argument to be checked.
-		 * @return True if an argument with the specified name exists, has a value; otherwise, false.
+		 * @param name The name of the argument to retrieve.
+		 * @param fallback Returned if the argument was given without a value, or not at all.
+		 * @throws std::invalid_argument If the argument doesn't exist or isn't an Int.
 		 */
-		bool argHasValue(const std::string &name);
+		[[nodiscard]] std::int64_t getIntOr(std::string_view name, std::int64_t fallback) const;
 
 		/**
-		 * @brief Retrieves an argument by its name.
+		 * @brief Retrieves the value of a String argument.
 		 *
-		 * This method retrieves a reference to the `Arg` object in the `args` vector
-		 * that matches the specified argument name. Throws an exception if no matching
-		 * argument is found.
+		 * @param name The name of the argument to retrieve.
+		 * @return A view into argv holding the value.
+		 * @throws std::invalid_argument If the argument doesn't exist, isn't a String or has no value.
+		 */
+		[[nodiscard]] std::string_view getString(std::string_view name) const;
+
+		/**
+		 * @brief Retrieves every value given for a List argument, in command line order.
 		 *
 		 * @param name The name of the argument to retrieve.
-		 * @return A reference to the matching `Arg` object.
-		 * @throws std::invalid_argument If the specified argument name doesn't exist.
+		 * @return Views into argv holding the values, empty if the argument wasn't given.
+		 * @throws std::invalid_argument If the argument doesn't exist or isn't a List.
 		 */
-		[[nodiscard]] const Arg &getArgByName(const std::string &name) const;
+		[[nodiscard]] std::span<const std::string_view> getList(std::string_view name) const;
 
+		/**
+		 * @brief Prints the help page that was rendered at compile time.
+		 */
 		void helpCommand() const;
 
 	private:
-		std::vector<Arg> args;
-		std::string program;
-		std::string description;
+		// Type erased view of an ArgTable, all of it lives in static storage
+		struct TableView {
+			std::span<const Arg> args;
+			std::span<const std::uint8_t> longSlots;
+			std::span<const std::uint8_t, 128> shortSlots;
+			std::uint32_t seed;
+			std::span<const Subcommand> subcommands;
+			std::span<const std::uint8_t> subcommandSlots;
+			std::uint32_t subcommandSeed;
+			std::span<const std::uint8_t> subcommandFlags;
+			std::span<const std::uint8_t> subcommandValues;
+			std::string_view help;
+		};
+
+		TableView table;
+		std::vector<ArgValue> values;
+
+		explicit ArgParser(const TableView &table) : table(table), values(table.args.size()) {
+		}
+
+		/**
+		 * @brief Stores the value given for an argument, parsing Int values and appending List values.
+		 *
+		 * @param argIndex The index of the argument in the table.
+		 * @param option The option as written on the command line, used in error messages.
+		 * @param value The value that was given.
+		 * @throws std::invalid_argument If an Int value is not a number.
+		 */
+		void storeValue(std::size_t argIndex, std::string_view option, std::string_view value);
+
+		/**
+		 * @brief Finds the index of a subcommand by its name using the table's perfect hash.
+		 *
+		 * @return The index into `subcommands`, or -1 if there is no subcommand with that name.
+		 */
+		[[nodiscard]] int findSubcommand(std::string_view name) const;
+
+		/**
+		 * @brief Finds the index of an argument by its long name using the table's perfect hash.
+		 *
+		 * @return The index into `args`, or -1 if there is no argument with that name.
+		 */
+		[[nodiscard]] int findLong(std::string_view name) const;
+
+		/**
+		 * @brief Looks up the value of an argument, checking that the argument exists and has the expected type.
+		 *
+		 * @throws std::invalid_argument If the specified argument name doesn't exist or has a different type.
+		 */
+		[[nodiscard]] const ArgValue &valueOf(std::string_view name, ArgType type) const;
 	};
 } // namespace tike
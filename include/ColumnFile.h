@@ -0,0 +1,136 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * tkc, a columnar file for exported tables, written by `tike --export tkc` and read without SQLite.
+ *
+ *   "TKC1" version:u32
+ *   block*          up to 65536 rows, one chunk per column, column after column
+ *   footer          the columns, the row count, and the offset and size of every chunk
+ *   footerOffset:u64 "TKC1"
+ *
+ * Integer and timestamp chunks hold the first value and then the differences between neighbours, zigzag
+ * encoded in the smallest fixed width (0, 1, 2, 4 or 8 bytes) the chunk needs. Ids and completion times grow
+ * slowly, so most chunks need one or two bytes per value. Text chunks hold a dictionary of their distinct
+ * values, with 4 byte end offsets or 8 byte ones past 4 GiB, and then one fixed width code per row. Chunks with NULLs start with a bitmap of them. Everything is
+ * little-endian.
+ *
+ * The footer makes the file self-describing, and lets a reader decode one column of one block without
+ * looking at anything else.
+ */
+namespace db {
+	enum class ColumnType : std::uint8_t {
+		Integer = 1,
+		Timestamp = 2, // Unix seconds
+		Text = 3
+	};
+
+	struct ColumnInfo {
+		std::string name;
+		ColumnType type;
+	};
+
+	/**
+	 * @brief Writes the rows of a query as a tkc file, one block at a time.
+	 *
+	 * @param cursor A prepared query with one result column per entry of `columns`, in the same order. Integer and
+	 * timestamp columns are read as 64-bit integers, so timestamps have to be selected as unix seconds.
+	 * @param columns The name and type of each result column.
+	 * @param out Receives the file, front to back.
+	 * @return The number of rows written.
+	 * @throw std::runtime_error If stepping the query fails.
+	 */
+	std::int64_t writeColumnFile(Statement &cursor, const std::vector<ColumnInfo> &columns,
+	                             const std::function<void(std::string_view)> &out);
+
+	/**
+	 * @brief One column of one block, decoded.
+	 *
+	 * @param nulls One flag per row, empty if the chunk has no NULLs.
+	 */
+	struct IntegerChunk {
+		std::vector<std::int64_t> values;
+		std::vector<bool> nulls;
+	};
+
+	/**
+	 * @brief One text column of one block. The dictionary points into the file mapping, nothing is copied.
+	 *
+	 * @param codes The dictionary index of every row's value.
+	 */
+	struct TextChunk {
+		std::vector<std::string_view> dictionary;
+		std::vector<std::uint32_t> codes;
+		std::vector<bool> nulls;
+
+		[[nodiscard]] std::string_view at(const std::size_t row) const { return dictionary[codes[row]]; }
+	};
+
+	/**
+	 * @class ColumnFile
+	 * @brief A tkc file mapped into memory, read one column chunk at a time.
+	 */
+	class ColumnFile {
+	public:
+		/**
+		 * @throw std::runtime_error If the file can't be read or is not a valid tkc file.
+		 */
+		explicit ColumnFile(const std::string &path);
+
+		~ColumnFile();
+
+		ColumnFile(const ColumnFile &) = delete;
+
+		ColumnFile &operator=(const ColumnFile &) = delete;
+
+		[[nodiscard]] const std::vector<ColumnInfo> &columns() const { return columnInfo; }
+
+		/**
+		 * @brief The position of a column by name.
+		 *
+		 * @throw std::invalid_argument If the file has no such column.
+		 */
+		[[nodiscard]] std::size_t column(std::string_view name) const;
+
+		[[nodiscard]] std::int64_t rows() const { return rowCount; }
+
+		[[nodiscard]] std::size_t blocks() const { return blockRows.size(); }
+
+		[[nodiscard]] std::size_t rowsIn(const std::size_t block) const { return blockRows[block]; }
+
+		/**
+		 * @brief Decodes an integer or timestamp column of a block.
+		 *
+		 * @throw std::runtime_error If the chunk is damaged or the column holds text.
+		 */
+		[[nodiscard]] IntegerChunk integers(std::size_t block, std::size_t column) const;
+
+		/**
+		 * @brief Decodes a text column of a block.
+		 *
+		 * @throw std::runtime_error If the chunk is damaged or the column doesn't hold text.
+		 */
+		[[nodiscard]] TextChunk text(std::size_t block, std::size_t column) const;
+
+	private:
+		struct ChunkRange {
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		const char *data = nullptr;
+		std::size_t size = 0;
+		std::string copy; // Holds the file where it can't be mapped
+		std::vector<ColumnInfo> columnInfo;
+		std::int64_t rowCount = 0;
+		std::vector<std::size_t> blockRows;
+		std::vector<ChunkRange> chunks; // Block after block, one per column
+
+		[[nodiscard]] std::string_view chunk(std::size_t block, std::size_t column, ColumnType expected) const;
+	};
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <ArgParser.h>
+#include <CounterCache.h>
+#include <Database.h>
+#include <array>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/*
+ * Every command tike can run, together with what each of them needs to run.
+ *
+ * main parses the command line, picks the command with findCommand and sets up only the resources that
+ * command declares before calling it. A command that needs no database never opens one.
+ */
+namespace tike {
+	/**
+	 * @brief Resources a command needs before it can run. Combine them with `|`.
+	 *
+	 * - ReadDb opens the database read-only. A missing database file is treated as an empty database.
+	 * - WriteDb opens the database read-write, creating the file if needed.
+	 * - SchemaCheck creates the tables when combined with WriteDb, and verifies they exist when combined with ReadDb.
+	 */
+	enum class Resource : unsigned {
+		None = 0,
+		ReadDb = 1 << 0,
+		WriteDb = 1 << 1,
+		SchemaCheck = 1 << 2
+	};
+
+	constexpr Resource operator|(const Resource a, const Resource b) {
+		return static_cast<Resource>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+	}
+
+	constexpr bool hasResource(const Resource set, const Resource resource) {
+		return (static_cast<unsigned>(set) & static_cast<unsigned>(resource)) != 0;
+	}
+
+	/**
+	 * @brief Everything a command gets handed when it runs.
+	 *
+	 * @param args The parsed command line.
+	 * @param db The database, or nullptr if the command didn't ask for ReadDb or WriteDb.
+	 * @param dbPath The path of the database file, for commands that manage their own connections.
+	 * @param countDelta How the command changed the number of open and completed tasks. Write commands fill this
+	 *        in so the counter sidecar can be updated without counting rows.
+	 */
+	struct CommandContext {
+		const ArgParser &args;
+		db::Database *db;
+		std::string dbPath;
+		db::TaskCounts countDelta{};
+	};
+
+	/**
+	 * @brief An entry of the dispatch table.
+	 *
+	 * @param option The long name of the option that selects the command.
+	 * @param resources What has to be set up before `run` is called.
+	 * @param run Runs the command and returns the exit code of the program.
+	 */
+	struct Command {
+		std::string_view option;
+		Resource resources;
+		int (*run)(CommandContext &context);
+	};
+
+	// Every option tike understands. Lookup structures and the help page are generated from this at compile time
+	inline constexpr auto argTable = makeArgTable("Tike", "TimeKeeper", std::array{
+		Arg{"add", "a", ArgType::Flag, "Add a new task"},
+		Arg{"apply", "", ArgType::Flag, "With --tune, switch the database to the recommended settings"},
+		Arg{"block", "", ArgType::Int, "Mark a task as blocked by the task given with --by"},
+		Arg{"by", "", ArgType::Int, "The blocking task for --block and --unblock"},
+		Arg{"complete", "c", ArgType::Int, "Mark a task as completed by id"},
+		Arg{"completed", "", ArgType::Flag, "Use completed tasks, e.g. with --count"},
+		Arg{"count", "", ArgType::Flag, "Prints the number of open tasks"},
+		Arg{"critical-path", "", ArgType::Flag, "Show the longest chain of tasks blocking each other"},
+		Arg{"description", "d", ArgType::String, "Description of the task"},
+		Arg{"direct", "", ArgType::Flag, "With --output, write around the page cache, for large archive files"},
+		Arg{"due", "", ArgType::String, "Due date of a new task (YYYY-MM-DD [HH:MM] or HH:MM)"},
+		Arg{"durability", "", ArgType::String, "What --tune has to keep: full (default), normal or off"},
+		Arg{"every", "", ArgType::String, "Repeat a new task: daily, weekly, monthly, yearly or e.g. \"3 days\""},
+		Arg{"export", "", ArgType::String, "Write all tasks to stdout as json, csv or tkc, completed ones with --completed"},
+		Arg{"from", "", ArgType::String, "Start of a time range (HH:MM or YYYY-MM-DD [HH:MM])"},
+		Arg{"http", "", ArgType::String, "Serve a JSON API for the tasks on HOST:PORT, e.g. 127.0.0.1:8080"},
+		Arg{"lead-time", "", ArgType::Flag, "Show lead time percentiles of completed tasks"},
+		Arg{"list", "l", ArgType::Int, "List a task by id"},
+		Arg{"list-all", "L", ArgType::Flag, "List all tasks"},
+		Arg{"list-all-completed", "", ArgType::Flag, "List all completed tasks"},
+		Arg{"list-completed", "", ArgType::Int, "List a completed task by id"},
+		Arg{"move", "", ArgType::Int, "Move a task and its subtasks below --parent, or to the top level"},
+		Arg{"next", "n", ArgType::Int, "List the tasks nothing blocks, most urgent first, optionally only the first N", false, true},
+		Arg{"output", "o", ArgType::String, "Write --export to this file instead of stdout"},
+		Arg{"parent", "p", ArgType::Int, "Parent task of a new or moved task"},
+		Arg{"perf-counters", "", ArgType::Flag, "Print CPU and OS counters per phase of the command to stderr"},
+		Arg{"recursive", "", ArgType::Flag, "Complete the open subtasks as well"},
+		Arg{"remind-hook", "", ArgType::String, "With --serve, run this command for each reminder (gets TIKE_TASK_ID, ...)"},
+		Arg{"remind-log", "", ArgType::String, "With --serve, append reminders to this file instead of printing them"},
+		Arg{"remove", "r", ArgType::Int, "Remove a task by id"},
+		Arg{"send-timeout", "", ArgType::Int, "With --http, close a connection whose client reads nothing for this many seconds"},
+		Arg{"serve", "", ArgType::Flag, "Keep running and send a reminder whenever a task falls due"},
+		Arg{"since", "", ArgType::String, "Only include tasks since this date (YYYY-MM-DD)"},
+		Arg{"start", "", ArgType::Int, "Start tracking time on a task by id"},
+		Arg{"stop", "", ArgType::Flag, "Stop tracking time"},
+		Arg{"stop-repeating", "", ArgType::Int, "Stop repeating a recurring task, open instances stay"},
+		Arg{"subtree", "", ArgType::Int, "List a task with all of its subtasks"},
+		Arg{"summary", "", ArgType::Flag, "Show totals, throughput and backlog age"},
+		Arg{"tag", "", ArgType::List, "Tag a new task, or filter --list-all (ops,!blocked; repeat for OR)"},
+		Arg{"time-log", "", ArgType::Flag, "List tracked time between --from and --to (default today)"},
+		Arg{"time-total", "", ArgType::Flag, "Total tracked time per task between --from and --to (default this week)"},
+		Arg{"title", "t", ArgType::String, "Title of the task"},
+		Arg{"to", "", ArgType::String, "End of a time range (HH:MM or YYYY-MM-DD [HH:MM])"},
+		Arg{"tune", "", ArgType::Flag, "Benchmark the disk and recommend storage settings, --apply uses them"},
+		Arg{"ui", "", ArgType::Flag, "Browse, search, complete and remove tasks interactively"},
+		Arg{"unblock", "", ArgType::Int, "Remove a dependency added with --block"},
+		Arg{"until", "", ArgType::String, "Also list recurring tasks due up to this date (YYYY-MM-DD [HH:MM])"},
+		Arg{"version", "v", ArgType::Flag, "Prints the version number"},
+		Arg{"watch", "", ArgType::Flag, "Keep the task list on screen and update it when tasks change"},
+		Arg{"weight", "", ArgType::String, "Set an urgency weight (age, due, blocking, tag.<name>), e.g. due=12; name= resets"}
+	}, std::array{
+		Subcommand{"add", "add", "", "Add a new task"},
+		Subcommand{"list", "list-all", "list", "List all tasks, or one task by id"},
+		Subcommand{"done", "", "complete", "Mark a task as completed by id"},
+		Subcommand{"remove", "", "remove", "Remove a task by id"},
+		Subcommand{"completed", "list-all-completed", "list-completed", "List completed tasks, or one by id"},
+		Subcommand{"next", "", "next", "List the most urgent tasks nothing blocks"},
+		Subcommand{"block", "", "block", "Mark a task as blocked, --by the blocking task"},
+		Subcommand{"tree", "", "subtree", "List a task with all of its subtasks"},
+		Subcommand{"move", "", "move", "Move a task and its subtasks"},
+		Subcommand{"count", "count", "", "Prints the number of open tasks"},
+		Subcommand{"export", "", "export", "Write all tasks as json, csv or tkc"},
+		Subcommand{"summary", "summary", "", "Show totals, throughput and backlog age"},
+		Subcommand{"lead-time", "lead-time", "", "Show lead time percentiles of completed tasks"},
+		Subcommand{"start", "", "start", "Start tracking time on a task by id"},
+		Subcommand{"stop", "stop", "", "Stop tracking time"},
+		Subcommand{"log", "time-log", "", "List tracked time"},
+		Subcommand{"time", "time-total", "", "Total tracked time per task"},
+		Subcommand{"watch", "watch", "", "Keep the task list on screen and update it as it changes"},
+		Subcommand{"ui", "ui", "", "Browse, search, complete and remove tasks interactively"},
+		Subcommand{"serve", "serve", "", "Keep running and send reminders for due tasks"},
+		Subcommand{"http", "", "http", "Serve a JSON API for the tasks on HOST:PORT"},
+		Subcommand{"tune", "tune", "", "Benchmark the disk and recommend storage settings"},
+		Subcommand{"version", "version", "", "Prints the version number"},
+		Subcommand{"help", "help", "", "Show this help page"}
+	});
+
+	/**
+	 * @brief Picks the command to run from the parsed command line.
+	 *
+	 * Commands are checked in dispatch table order and the first one whose option was given wins.
+	 * Without any command option the help command is returned.
+	 *
+	 * @param parser The parsed command line.
+	 * @return The command to run.
+	 */
+	const Command &findCommand(const ArgParser &parser);
+
+	/**
+	 * @brief Runs a command that writes to the database.
+	 *
+	 * The command runs inside a single write transaction. Once it is committed the counter sidecar is updated
+	 * with the command's countDelta, so the sidecar stays current without ever counting rows.
+	 *
+	 * @param command A command that declares Resource::WriteDb.
+	 * @param context The context, with the database already opened read-write.
+	 * @return The exit code of the command.
+	 */
+	int runWriteCommand(const Command &command, CommandContext &context);
+
+	/**
+	 * @brief Runs a function in a write transaction, the same way as a write command.
+	 *
+	 * For changes that don't come from the command line, like the keys of the interactive mode.
+	 */
+	int runWriteCommand(const std::function<int(CommandContext &)> &run, CommandContext &context);
+
+	/**
+	 * @brief Creates every table tike uses that doesn't exist yet.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureSchema(const db::Database &db);
+
+	/**
+	 * @brief Verifies that every table tike uses exists, without changing anything.
+	 *
+	 * @param db A database opened read-only.
+	 * @throw std::runtime_error If a table is missing.
+	 */
+	void checkSchema(const db::Database &db);
+} // namespace tike
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace db {
+	/**
+	 * @brief Identifies one committed state of a database file without opening it with SQLite.
+	 *
+	 * PRAGMA data_version only means something within a single connection, so the sidecar files use the on-disk
+	 * equivalent instead: the file change counter from the database header, together with size and
+	 * modification time of the database and its WAL file. Every committed write changes at least one of them.
+	 */
+	struct StorageStamp {
+		std::uint32_t changeCounter = 0;
+		std::int64_t dbSize = 0;
+		std::int64_t dbModified = 0;
+		std::int64_t walSize = 0;
+		std::int64_t walModified = 0;
+
+		bool operator==(const StorageStamp &) const = default;
+
+		/**
+		 * @brief Takes the stamp of a database file as it is right now.
+		 *
+		 * @param dbPath The path of the database file.
+		 * @return The stamp, or std::nullopt if the database file doesn't exist.
+		 */
+		static std::optional<StorageStamp> of(const std::string &dbPath);
+	};
+
+	/**
+	 * @brief Number of open and completed tasks.
+	 */
+	struct TaskCounts {
+		std::int64_t open = 0;
+		std::int64_t completed = 0;
+	};
+
+	/**
+	 * @brief A tiny sidecar file next to the database holding the task counts and the stamp they belong to.
+	 *
+	 * Reading it is one mmap, so answering "how many tasks are open" never has to load SQLite. The file is
+	 * replaced with an atomic rename, readers either see the old or the new counts but never a torn write.
+	 * Counts are only trusted while the stamp matches the database file.
+	 */
+	class CounterCache {
+	public:
+		explicit CounterCache(const std::string &dbPath) : dbPath(dbPath), cachePath(dbPath + ".count") {
+		};
+
+		/**
+		 * @brief Reads the counts, if they are still current.
+		 *
+		 * @return The counts, or std::nullopt if the sidecar is missing, damaged or older than the database.
+		 */
+		[[nodiscard]] std::optional<TaskCounts> load() const;
+
+		/**
+		 * @brief Replaces the sidecar with new counts.
+		 *
+		 * Failing to write the sidecar is not an error, readers simply fall back to counting in the database.
+		 *
+		 * @param counts The counts to store.
+		 * @param stamp The stamp of the database state the counts were taken from.
+		 */
+		void store(const TaskCounts &counts, const StorageStamp &stamp) const;
+
+	private:
+		std::string dbPath;
+		std::string cachePath;
+	};
+}
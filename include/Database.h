@@ -1,7 +1,10 @@
 #pragma once
 #include <sqlite3.h>
+#include <cstdint>
+#include <functional>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <optional>
@@ -55,13 +58,128 @@ namespace db {
 		std::optional<std::string> foreignKey = std::nullopt;
 	};
 
+	/**
+	 * @brief How a Database connection is opened.
+	 *
+	 * ReadWrite creates the database file if it doesn't exist yet. ReadOnly never writes to or creates the file,
+	 * and fails to open if it is missing.
+	 */
+	enum class OpenMode {
+		ReadWrite,
+		ReadOnly
+	};
+
+	/**
+	 * @brief A prepared SQLite statement, finalized when it goes out of scope.
+	 *
+	 * For queries that don't fit the Record helpers: aggregates, streaming over large results without
+	 * building a RecordData per row, or running the same statement many times with different parameters.
+	 * Created through Database::prepare.
+	 */
+	class Statement {
+	public:
+		Statement(const Statement &) = delete;
+
+		Statement &operator=(const Statement &) = delete;
+
+		Statement(Statement &&other) noexcept : db(other.db), stmt(other.stmt) {
+			other.stmt = nullptr;
+		};
+
+		~Statement() {
+			sqlite3_finalize(stmt);
+		};
+
+		/**
+		 * @brief Binds a value to a parameter. SQLite parameters are 1-indexed.
+		 *
+		 * Text is copied by SQLite, so the value doesn't have to outlive the statement.
+		 *
+		 * @throw std::runtime_error If binding fails.
+		 */
+		Statement &bind(int index, const Field &value);
+
+		/**
+		 * @brief Binds a 64-bit integer to a parameter.
+		 *
+		 * @throw std::runtime_error If binding fails.
+		 */
+		Statement &bindInt64(int index, std::int64_t value);
+
+		/**
+		 * @brief Binds a blob to a parameter. The bytes are copied by SQLite.
+		 *
+		 * @throw std::runtime_error If binding fails.
+		 */
+		Statement &bindBlob(int index, std::string_view bytes);
+
+		/**
+		 * @brief Binds NULL to a parameter.
+		 *
+		 * @throw std::runtime_error If binding fails.
+		 */
+		Statement &bindNull(int index);
+
+		/**
+		 * @brief Advances to the next row.
+		 *
+		 * @return True if a row is available, false once the statement is done.
+		 * @throw std::runtime_error If SQLite reports an error.
+		 */
+		bool step();
+
+		/**
+		 * @brief Resets the statement so it can run again. Bound values are kept.
+		 */
+		void reset();
+
+		[[nodiscard]] int columnCount() const;
+
+		[[nodiscard]] bool columnIsNull(int column) const;
+
+		/**
+		 * @brief The storage class of a column in the current row: SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT,
+		 * SQLITE_BLOB or SQLITE_NULL.
+		 */
+		[[nodiscard]] int columnType(int column) const;
+
+		[[nodiscard]] std::int64_t columnInt64(int column) const;
+
+		[[nodiscard]] double columnDouble(int column) const;
+
+		/**
+		 * @brief Reads a text column. The view is valid until the next call to step, reset or the destructor.
+		 */
+		[[nodiscard]] std::string_view columnText(int column) const;
+
+		/**
+		 * @brief Reads a blob column. The view is valid until the next call to step, reset or the destructor.
+		 */
+		[[nodiscard]] std::string_view columnBlob(int column) const;
+
+	private:
+		friend class Database;
+
+		sqlite3 *db;
+		sqlite3_stmt *stmt = nullptr;
+
+		Statement(sqlite3 *db, const std::string &sql);
+	};
+
 	class Database {
 	public:
-		explicit Database(std::string db_path) : db_path(std::move(db_path)) {
+		explicit Database(std::string db_path, const OpenMode mode = OpenMode::ReadWrite)
+			: db_path(std::move(db_path)), mode(mode) {
 			openDatabase();
 		};
 
+		Database(const Database &) = delete;
+
+		Database &operator=(const Database &) = delete;
+
 		~Database() {
+			// Cached statements have to be finalized before the connection can close
+			statementCache.clear();
 			closeDatabase();
 		};
 
@@ -85,6 +203,104 @@ namespace db {
 		 */
 		void createTable(const std::string &table, const std::vector<db::Column> &columns) const;
 
+		/**
+		 * @brief Checks whether a table exists in the database.
+		 *
+		 * @param table The name of the table to look for.
+		 * @return True if the table exists; otherwise, false.
+		 * @throw std::runtime_error Thrown if the SQLite statement preparation fails.
+		 */
+		bool hasTable(const std::string &table) const;
+
+		/**
+		 * @brief Checks whether a table has a column, e.g. before migrating an older database.
+		 *
+		 * @param table The name of the table.
+		 * @param column The name of the column to look for.
+		 * @return True if the column exists; otherwise, false.
+		 * @throw std::runtime_error Thrown if the SQLite statement preparation fails.
+		 */
+		bool hasColumn(const std::string &table, const std::string &column) const;
+
+		/**
+		 * @brief Executes one or more SQL statements that don't return rows.
+		 *
+		 * @param sql The SQL to execute, e.g. "BEGIN IMMEDIATE".
+		 * @throw std::runtime_error If SQLite reports an error.
+		 */
+		void execute(const std::string &sql) const;
+
+		/**
+		 * @brief Counts the rows of a table.
+		 *
+		 * @param table The name of the table to count.
+		 * @return The number of rows in the table.
+		 * @throw std::runtime_error If the SQL statement preparation or execution fails.
+		 */
+		std::int64_t countRecords(const std::string &table) const;
+
+		/**
+		 * @brief Returns PRAGMA data_version for this connection.
+		 *
+		 * The value changes whenever another connection commits to the database, writes made through this
+		 * connection don't change it.
+		 *
+		 * @throw std::runtime_error If the SQL statement preparation or execution fails.
+		 */
+		std::int64_t dataVersion() const;
+
+		/**
+		 * @brief Returns the rowid of the most recent successful INSERT on this connection.
+		 */
+		std::int64_t lastInsertId() const;
+
+		/**
+		 * @brief Returns the number of rows changed through this connection since it was opened.
+		 *
+		 * Together with dataVersion this tells whether the database changed at all, by any connection.
+		 */
+		std::int64_t totalChanges() const;
+
+		/**
+		 * @brief Whether a transaction is open on this connection.
+		 */
+		bool inTransaction() const;
+
+		/**
+		 * @brief Makes the statements running on this connection fail as soon as possible.
+		 *
+		 * The one call that is safe from another thread. A statement stepped after the running ones finished is
+		 * not affected, so interrupting while nothing runs does nothing.
+		 */
+		void interrupt() const;
+
+		/**
+		 * @brief Calls hook whenever this connection inserts, updates or deletes a row. An empty function removes it.
+		 *
+		 * SQLite has one update hook per connection, a later call replaces the hook set before.
+		 */
+		void setUpdateHook(std::function<void()> hook) const;
+
+		/**
+		 * @brief Prepares a statement for this connection.
+		 *
+		 * @param sql The SQL of the statement, with `?` placeholders for parameters.
+		 * @return The prepared statement.
+		 * @throw std::runtime_error If the SQL statement preparation fails.
+		 */
+		Statement prepare(const std::string &sql) const;
+
+		/**
+		 * @brief Returns a statement that is prepared once and kept for the life of the connection.
+		 *
+		 * For statements that run again and again, like the actions of the interactive mode. The statement comes
+		 * back reset, bind every parameter before stepping it. It stays owned by the connection.
+		 *
+		 * @param sql The SQL of the statement, with `?` placeholders for parameters.
+		 * @throw std::runtime_error If the SQL statement preparation fails.
+		 */
+		Statement &prepareCached(const std::string &sql) const;
+
 		/**
 		 * @brief Adds a new record to the database.
 		 *
@@ -177,19 +393,29 @@ namespace db {
 
 	private:
 		std::string db_path;
+		OpenMode mode;
 		sqlite3 *db{};
+		mutable std::unordered_map<std::string, Statement> statementCache;
+		mutable std::function<void()> updateHook;
 
 		/**
 		 * Opens a connection to the SQLite database using the file path stored in the `db_path` member.
 		 *
-		 * This method initializes the SQLite database handle and establishes a connection to the database file.
-		 * If the connection cannot be established, an exception is thrown with the error message provided
+		 * This method initializes the SQLite database handle and establishes a connection to the database file,
+		 * read-only or read-write depending on `mode`. If the connection cannot be established, an exception is thrown with the error message provided
 		 * by SQLite.
 		 *
 		 * @throws std::runtime_error If the database connection cannot be established.
 		 */
 		void openDatabase();
 
+		/**
+		 * Applies the storage settings `tike --tune --apply` kept in the storageSettings table, if there is one.
+		 *
+		 * Failures are ignored, the connection then runs with SQLite's defaults.
+		 */
+		void applyStoredSettings() const;
+
 		/**
 		 * Closes the connection to the currently opened SQLite database.
 		 *
@@ -210,4 +436,45 @@ namespace db {
 		 */
 		static std::string createSelectQuery(const std::string &table, const RecordData &data);
 	};
+
+	/**
+	 * @brief A write transaction that rolls back unless it is committed.
+	 *
+	 * Starts with BEGIN IMMEDIATE, so the write lock is taken up front and no other connection can commit
+	 * until this transaction ends.
+	 */
+	class Transaction {
+	public:
+		explicit Transaction(const Database &db) : db(db) {
+			db.execute("BEGIN IMMEDIATE");
+		};
+
+		Transaction(const Transaction &) = delete;
+
+		Transaction &operator=(const Transaction &) = delete;
+
+		~Transaction() {
+			if (!committed) {
+				try {
+					db.execute("ROLLBACK");
+				} catch (...) {
+					// Nothing sensible to do, the connection rolls back when it closes anyway
+				}
+			}
+		};
+
+		/**
+		 * @brief Commits the transaction.
+		 *
+		 * @throw std::runtime_error If the commit fails, the transaction is rolled back in that case.
+		 */
+		void commit() {
+			db.execute("COMMIT");
+			committed = true;
+		}
+
+	private:
+		const Database &db;
+		bool committed = false;
+	};
 }
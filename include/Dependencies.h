@@ -0,0 +1,133 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+ * Dependencies between tasks: "B is blocked by A".
+ *
+ * Edges live in taskDependencies. For analysis they are loaded into a DependencyGraph over the open tasks, in
+ * compressed sparse row form, with one scan of the open task ids and one scan of the edges. Edges to
+ * completed or removed tasks no longer block anything and are left out. The analysis is kept in a sidecar next to
+ * the database (see DependencyCache.h), so it is only computed again once the database has changed.
+ */
+namespace tike {
+	/**
+	 * @class DependencyGraph
+	 * @brief The open tasks and the edges between them, as a compressed sparse row graph.
+	 *
+	 * Nodes are the open tasks ordered by id, so node n is the task with pseudo id n + 1. Edges point from a
+	 * blocking task to the task it blocks.
+	 */
+	class DependencyGraph {
+	public:
+		using Node = std::uint32_t;
+
+		/**
+		 * @brief Loads the graph of the open tasks.
+		 *
+		 * @param db The database, may be opened read-only.
+		 */
+		static DependencyGraph load(const db::Database &db);
+
+		[[nodiscard]] std::size_t size() const { return taskIds.size(); }
+		[[nodiscard]] std::int64_t taskId(const Node node) const { return taskIds[node]; }
+		[[nodiscard]] std::int64_t pseudoId(const Node node) const { return static_cast<std::int64_t>(node) + 1; }
+
+		/**
+		 * @brief The node of an open task.
+		 *
+		 * @return The node, or std::nullopt if the task isn't open.
+		 */
+		[[nodiscard]] std::optional<Node> nodeOf(std::int64_t taskId) const;
+
+		/**
+		 * @brief How many open tasks block this one.
+		 */
+		[[nodiscard]] std::uint32_t blockerCount(const Node node) const { return inDegree[node]; }
+
+		/**
+		 * @brief How many open tasks this one blocks.
+		 */
+		[[nodiscard]] std::uint32_t blockedCount(const Node node) const { return offsets[node + 1] - offsets[node]; }
+
+		/**
+		 * @brief Whether `to` can be reached from `from` by following edges.
+		 */
+		[[nodiscard]] bool reaches(Node from, Node to) const;
+
+		/**
+		 * @brief Orders the nodes so every task comes after the tasks blocking it (Kahn's algorithm).
+		 *
+		 * Nodes on a cycle, which can only come from edges written outside tike, are left out.
+		 */
+		[[nodiscard]] std::vector<Node> topologicalOrder() const;
+
+	private:
+		std::vector<std::int64_t> taskIds;
+		// Edges of node n are targets[offsets[n]] to targets[offsets[n + 1]]
+		std::vector<std::uint32_t> offsets;
+		std::vector<Node> targets;
+		std::vector<std::uint32_t> inDegree;
+
+		friend struct DependencyAnalysis;
+	};
+
+	/**
+	 * @brief Everything --next and --critical-path need, computed in linear time from one graph.
+	 *
+	 * @param taskIds The ids of the open tasks by node, the nodes of the graph it was computed from.
+	 * @param order The open tasks in topological order.
+	 * @param ready The open tasks nothing open blocks, ordered by id.
+	 * @param criticalPath The longest chain of tasks blocking each other, first task first.
+	 */
+	struct DependencyAnalysis {
+		std::vector<std::int64_t> taskIds;
+		std::vector<DependencyGraph::Node> order;
+		std::vector<DependencyGraph::Node> ready;
+		std::vector<DependencyGraph::Node> criticalPath;
+
+		DependencyAnalysis() = default;
+
+		explicit DependencyAnalysis(DependencyGraph graph);
+
+		[[nodiscard]] std::int64_t taskId(const DependencyGraph::Node node) const { return taskIds[node]; }
+		[[nodiscard]] std::int64_t pseudoId(const DependencyGraph::Node node) const { return node + 1LL; }
+	};
+
+	/**
+	 * @brief Creates the dependency table if it doesn't exist yet.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureDependencies(const db::Database &db);
+
+	/**
+	 * @brief The analysis of the open tasks, from the sidecar while it is current, else from the graph.
+	 *
+	 * A fresh analysis replaces the sidecar, unless the database changed while it was computed.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param dbPath The path of the database file, the sidecar is next to it.
+	 */
+	DependencyAnalysis analyseDependencies(const db::Database &db, const std::string &dbPath);
+
+	/**
+	 * @brief Records that a task is blocked by another one.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the blocked task (not the pseudo id).
+	 * @param blockerId The id of the task blocking it.
+	 * @throw std::invalid_argument If the edge would create a cycle, or either task isn't open.
+	 */
+	void addDependency(const db::Database &db, std::int64_t taskId, std::int64_t blockerId);
+
+	/**
+	 * @brief Removes a dependency.
+	 *
+	 * @return Whether the dependency existed.
+	 */
+	bool removeDependency(const db::Database &db, std::int64_t taskId, std::int64_t blockerId);
+} // namespace tike
@@ -0,0 +1,49 @@
+#pragma once
+#include <CounterCache.h>
+#include <Dependencies.h>
+#include <optional>
+#include <string>
+
+/*
+ * The dependency analysis of the open tasks, kept next to the database so `tike --critical-path` only loads the
+ * graph and sorts it once per database state.
+ *
+ *   header       magic, version, the StorageStamp of the database state, the number of tasks and of each list
+ *   task ids     the id of every open task by node, as 64-bit integers
+ *   lists        the topological order, the ready set and the critical path, as 32-bit nodes
+ *
+ * Like the counter and snapshot sidecars, the file is replaced with an atomic rename and only trusted while its
+ * stamp matches the database.
+ */
+namespace tike {
+	/**
+	 * @class DependencyCache
+	 * @brief The dependency analysis sidecar of one database.
+	 */
+	class DependencyCache {
+	public:
+		explicit DependencyCache(const std::string &dbPath) : dbPath(dbPath), cachePath(dbPath + ".deps") {
+		}
+
+		/**
+		 * @brief Reads the analysis, if it is still current.
+		 *
+		 * @return The analysis, or std::nullopt if the sidecar is missing, damaged or older than the database.
+		 */
+		[[nodiscard]] std::optional<DependencyAnalysis> load() const;
+
+		/**
+		 * @brief Replaces the sidecar with a new analysis.
+		 *
+		 * Failing to write the sidecar is not an error, readers simply analyse the graph again.
+		 *
+		 * @param analysis The analysis to store.
+		 * @param stamp The stamp of the database state the analysis was computed from.
+		 */
+		void store(const DependencyAnalysis &analysis, const db::StorageStamp &stamp) const;
+
+	private:
+		std::string dbPath;
+		std::string cachePath;
+	};
+} // namespace tike
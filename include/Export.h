@@ -0,0 +1,56 @@
+#pragma once
+#include <ColumnFile.h>
+#include <Database.h>
+#include <OutputSink.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * Exporting the open or the completed tasks as JSON, CSV or tkc, `tike --export json|csv|tkc`.
+ *
+ * The export runs as a pipeline, so formatting and escaping don't wait on SQLite and the other way around:
+ *
+ *   reader     the calling thread, steps the query and copies rows into batches of raw values
+ *   formatters a pool of threads, each rendering whole batches into text
+ *   writer     one thread, handing the rendered batches to the OutputSink in the order they were read
+ *
+ * Batches are numbered as they are read and the writer only takes the next number, so the output is the same as
+ * a single threaded export. The number of batches between reader and writer is capped, which keeps memory flat
+ * when the output is slower than the database.
+ */
+namespace tike {
+	enum class ExportFormat {
+		Json,
+		Csv,
+		Tkc
+	};
+
+	/**
+	 * @brief Parses "json", "csv" or "tkc".
+	 *
+	 * @throw std::invalid_argument For any other format.
+	 */
+	ExportFormat parseExportFormat(std::string_view text);
+
+	/**
+	 * @brief Appends text as a quoted JSON string, escaping quotes, backslashes and control characters.
+	 */
+	void appendJsonString(std::string &out, std::string_view text);
+
+	/**
+	 * @brief Writes every row of the tasks or the completedTasks table, in id order.
+	 *
+	 * JSON is an array with one object per task. CSV has a header line, NULL is written as an empty field. tkc is
+	 * the columnar file described in ColumnFile.h, with the times as unix seconds, written without the pipeline.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param completed Export completedTasks instead of tasks.
+	 * @param formatters The number of formatter threads, 0 picks one per core left over by reader and writer.
+	 * @param out Where the export goes. Finishing it is up to the caller.
+	 * @return The number of rows written.
+	 * @throw std::runtime_error If reading fails, or writing to `out` does.
+	 */
+	std::int64_t exportTasks(const db::Database &db, bool completed, ExportFormat format, OutputSink &out,
+	                         unsigned formatters = 0);
+} // namespace tike
@@ -0,0 +1,70 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+/*
+ * A JSON API over HTTP/1.1 for dashboards and scripts, `tike --http 127.0.0.1:8080`.
+ *
+ *   GET    /tasks                   the open tasks in id order, ?search=text filters the titles, ?after=id and
+ *                                   ?limit=n page through them
+ *   GET    /tasks/{id}              one open task
+ *   POST   /tasks                   adds a task, the body is {"title": "...", "description": "..."}
+ *   POST   /tasks/{id}/complete     completes a task
+ *   DELETE /tasks/{id}              removes a task
+ *   GET    /stats                   hits, misses and size of the query caches
+ *
+ * Ids are the ids of the tasks table, which don't change when other tasks are completed, not the pseudo ids the
+ * command line numbers tasks with. Errors come back as {"error": "..."} with a 4xx or 5xx status.
+ *
+ * One thread runs an epoll loop over non-blocking sockets and never touches the database: it parses requests,
+ * hands them on and sends what comes back. Reads go to a pool of threads with a read-only connection each,
+ * writes to a single writer thread, so they queue up instead of fighting over SQLite's write lock. Task lists
+ * are streamed as chunked responses, read a page at a time with the cursor reset before each page is sent. The
+ * reader pauses when the client is slower than the database without holding a read lock meanwhile, so a stalled
+ * client never holds up writes, and a list of any length needs the same memory. A long list can include tasks
+ * added while it was being sent. A client that stops reading altogether is cut off once its response has made no
+ * progress for the send timeout, which frees the reader waiting on it. Each reader keeps a db::QueryCache, so a
+ * dashboard polling the same requests on an idle database is answered from memory. Connections are kept alive,
+ * requests sent back to back on one are answered in order.
+ */
+namespace tike {
+	inline constexpr auto defaultSendTimeout = std::chrono::seconds(30);
+
+	/**
+	 * @brief A task to add, as sent to POST /tasks.
+	 */
+	struct NewTask {
+		std::string title;
+		std::optional<std::string> description;
+	};
+
+	/**
+	 * @brief The changes the API can make, run on the writer thread one at a time.
+	 *
+	 * `complete` and `remove` take the id of a task and return false if no open task has it.
+	 */
+	struct HttpActions {
+		std::function<std::int64_t(const NewTask &)> add;
+		std::function<bool(std::int64_t)> complete;
+		std::function<bool(std::int64_t)> remove;
+	};
+
+	/**
+	 * @brief Serves the API until the process is stopped.
+	 *
+	 * @param address Where to listen, "host:port", e.g. "127.0.0.1:8080" or "[::1]:8080". Port 0 picks a free
+	 * port, the address actually used is printed on stdout.
+	 * @param dbPath The database file, it has to exist. Each reader thread opens it read-only.
+	 * @param actions Runs the writes, through a connection of its own.
+	 * @param readers The number of reader threads, 0 picks one per core with a minimum of two.
+	 * @param sendTimeout How long a response may wait for its client to read before the connection is closed.
+	 * @throw std::invalid_argument If the address can't be parsed.
+	 * @throw std::runtime_error If the address can't be bound, or the system has no epoll.
+	 */
+	[[noreturn]] void runHttpServer(const std::string &address, const std::string &dbPath,
+	                                const HttpActions &actions, unsigned readers = 0,
+	                                std::chrono::seconds sendTimeout = defaultSendTimeout);
+} // namespace tike
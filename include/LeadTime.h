@@ -0,0 +1,44 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/*
+ * Lead time is the time between creating and completing a task.
+ *
+ * Percentiles are estimated with t-digests. Each finished month gets a digest stored in leadTimeDigests,
+ * together with the month's generation in leadTimeGenerations, a counter triggers on completedTasks bump on
+ * every insert, delete or update in that month. A report merges a handful of stored digests and only scans
+ * the rows of months that are still running or changed since their digest was stored.
+ */
+namespace tike {
+	/**
+	 * @brief Lead time percentiles, in days.
+	 */
+	struct LeadTimeReport {
+		std::int64_t count = 0;
+		double p50 = 0;
+		double p90 = 0;
+		double p99 = 0;
+	};
+
+	/**
+	 * @brief Creates the sketch and generation tables, their triggers and the completion time index if missing.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureLeadTime(const db::Database &db);
+
+	/**
+	 * @brief Estimates lead time percentiles over completed tasks.
+	 *
+	 * Digests of finished months that are missing or out of date are rebuilt and stored, so the database has
+	 * to be writable.
+	 *
+	 * @param db The database, opened read-write.
+	 * @param since Only tasks completed on or after this date (YYYY-MM-DD) are included. All tasks if empty.
+	 * @throw std::invalid_argument If `since` is not a valid date.
+	 */
+	LeadTimeReport leadTimeReport(const db::Database &db, const std::optional<std::string> &since);
+} // namespace tike
@@ -0,0 +1,69 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+ * Where large outputs like exports go: stdout or a file.
+ *
+ * On Linux, files are written through io_uring. Output is copied into a few buffers registered with the kernel
+ * once, and every full buffer is queued as a write at its own file offset. The caller goes on filling the next
+ * buffer while earlier ones are still being written, and only waits when all of them are in flight.
+ *
+ * With `direct` the file is opened with O_DIRECT, so archive files that are written once and not read back
+ * don't push everything else out of the page cache. Buffers and offsets are page aligned for that, and the last
+ * block is padded and then truncated to the real size.
+ *
+ * Pipes, terminals, files opened for appending, and systems where io_uring is missing or blocked (old kernels,
+ * seccomp in containers) fall back to plain write() calls from a buffer.
+ */
+namespace tike {
+	/**
+	 * @class OutputSink
+	 * @brief A destination for bytes, written in order.
+	 */
+	class OutputSink {
+	public:
+		virtual ~OutputSink() = default;
+
+		/**
+		 * @brief Queues bytes after everything written before. They may not have reached the file yet on return.
+		 *
+		 * @throw std::runtime_error If an earlier write failed.
+		 */
+		virtual void write(std::string_view bytes) = 0;
+
+		/**
+		 * @brief Writes out everything still queued and waits for it, closing the file if the sink opened it.
+		 *
+		 * @throw std::runtime_error If any write failed.
+		 */
+		virtual void finish() = 0;
+
+		/**
+		 * @brief "io_uring" or "write", for diagnostics.
+		 */
+		[[nodiscard]] virtual std::string_view method() const = 0;
+	};
+
+	/**
+	 * @param direct Open files with O_DIRECT, where the filesystem supports it.
+	 * @param uring Use io_uring where it is available. Off forces plain write() calls.
+	 */
+	struct OutputOptions {
+		bool direct = false;
+		bool uring = true;
+	};
+
+	/**
+	 * @brief Creates or truncates a file and returns a sink writing to it.
+	 *
+	 * @throw std::runtime_error If the file can't be opened.
+	 */
+	std::unique_ptr<OutputSink> openOutputFile(const std::string &path, const OutputOptions &options = {});
+
+	/**
+	 * @brief A sink writing to stdout. std::cout is flushed first, so earlier output stays in front.
+	 */
+	std::unique_ptr<OutputSink> standardOutput(const OutputOptions &options = {});
+} // namespace tike
@@ -0,0 +1,70 @@
+#pragma once
+#include <ostream>
+#include <string_view>
+
+/*
+ * CPU and OS counters per phase of a command, `tike -L --perf-counters`, to tell whether a slow command spends its
+ * time on instructions, cache misses, page faults or waiting.
+ *
+ * Code marks its phases with a PerfPhase on the stack: parse, open, schema, query and render. Counts are read at
+ * every phase change and go to the innermost phase, whatever runs outside of one is counted as "other". Phases are
+ * kept coarse, a counter read is a system call.
+ *
+ * On Linux the counters come from perf_event_open: cycles, instructions, cache and branch misses in one group, page
+ * faults and context switches in another. Containers and VMs often have no hardware counters, and some block
+ * perf_event_open entirely, so the report falls back to the software counters, and then to getrusage. What
+ * isn't available shows as "-". Without --perf-counters a PerfPhase costs one branch.
+ *
+ * The report ends with the peak RSS and the peak of SQLite's heap. Builds with TIKE_ALLOC_STATS also count the
+ * heap allocations of each phase, see AllocStats.h.
+ */
+namespace tike {
+	/**
+	 * @brief Opens the counters and starts counting. Until this is called, phases count nothing.
+	 */
+	void startPerfCounters();
+
+	/**
+	 * @brief Writes a table of the counts per phase, if startPerfCounters was called.
+	 */
+	void reportPerfCounters(std::ostream &out);
+
+	/**
+	 * @brief Calls reportPerfCounters when it goes out of scope, so a command that fails is reported as well.
+	 */
+	class PerfReport {
+	public:
+		explicit PerfReport(std::ostream &out) : out(out) {
+		}
+
+		~PerfReport();
+
+		PerfReport(const PerfReport &) = delete;
+
+		PerfReport &operator=(const PerfReport &) = delete;
+
+	private:
+		std::ostream &out;
+	};
+
+	/**
+	 * @brief Counts everything until it goes out of scope to the phase `name`.
+	 *
+	 * Phases with the same name add up, a phase inside another pauses the outer one.
+	 *
+	 * @param name Has to outlive the report, string literals do.
+	 */
+	class PerfPhase {
+	public:
+		explicit PerfPhase(std::string_view name);
+
+		~PerfPhase();
+
+		PerfPhase(const PerfPhase &) = delete;
+
+		PerfPhase &operator=(const PerfPhase &) = delete;
+
+	private:
+		bool counting;
+	};
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <Database.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+/*
+ * Results of read queries kept in memory, for the modes that keep running and answer the same questions again
+ * and again (`--serve`, `--watch`, `--http`).
+ *
+ * A result is found by its statement, with runs of whitespace outside quotes collapsed so the same query
+ * written differently still matches, and its bound values. All results belong to one PRAGMA data_version of
+ * the connection. Once another connection commits, the version moves on and the whole cache is dropped; writes
+ * on the connection itself don't move the version, they are caught by its update hook instead. Only results
+ * read outside of a transaction are cached, so uncommitted rows never end up in the cache.
+ *
+ * Memory is bounded by a byte budget, the least recently used results go first. A result bigger than an eighth of
+ * the budget is passed through without keeping it, so one large listing can't push out everything else.
+ */
+namespace db {
+	/**
+	 * @brief A value bound to or read from a query. NULL is std::monostate, blobs are read as strings.
+	 */
+	using Value = std::variant<std::monostate, std::int64_t, double, std::string>;
+
+	/**
+	 * @brief Counters of a QueryCache, readable from any thread.
+	 *
+	 * @param invalidations How often the cache was dropped because the database changed.
+	 * @param bypassed Queries run without the cache, inside a transaction or with a result too big to keep.
+	 */
+	struct QueryCacheStats {
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t invalidations = 0;
+		std::uint64_t evictions = 0;
+		std::uint64_t bypassed = 0;
+		std::uint64_t entries = 0;
+		std::uint64_t bytes = 0;
+
+		[[nodiscard]] double hitRate() const {
+			return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+		}
+
+		QueryCacheStats &operator+=(const QueryCacheStats &other);
+	};
+
+	/**
+	 * @class QueryCache
+	 * @brief A result cache for one connection. Like the connection, it is used by one thread at a time.
+	 */
+	class QueryCache {
+	public:
+		/**
+		 * @param db The connection the queries run on. The cache sets its update hook.
+		 * @param byteBudget Roughly how much memory the cached results may take.
+		 */
+		explicit QueryCache(const Database &db, std::size_t byteBudget = 4 * 1024 * 1024);
+
+		~QueryCache();
+
+		QueryCache(const QueryCache &) = delete;
+
+		QueryCache &operator=(const QueryCache &) = delete;
+
+		/**
+		 * @brief Runs a query, or replays its rows from memory if the database hasn't changed since they were read.
+		 *
+		 * @param sql The statement, prepared once per connection.
+		 * @param parameters The values bound to ?1, ?2, ...
+		 * @param onRow Called with the values of each row. Returning false stops early, the rows are then not
+		 * cached.
+		 * @return False if onRow stopped early.
+		 * @throw std::runtime_error If preparing or stepping the query fails.
+		 */
+		bool forEach(std::string_view sql, std::span<const Value> parameters,
+		             const std::function<bool(std::span<const Value>)> &onRow);
+
+		/**
+		 * @brief The counters so far. Safe to call while another thread uses the cache.
+		 */
+		[[nodiscard]] QueryCacheStats stats() const;
+
+		/**
+		 * @brief Drops every cached result.
+		 */
+		void clear();
+
+	private:
+		struct Entry {
+			std::string key;
+			std::size_t columns;
+			std::shared_ptr<const std::vector<Value>> values; // Row after row
+			std::size_t bytes;
+		};
+
+		const Database &db;
+		std::size_t byteBudget;
+		std::int64_t dataVersion;
+		bool changed = false; // Set by the update hook
+
+		std::list<Entry> entries; // Most recently used first
+		std::unordered_map<std::string_view, std::list<Entry>::iterator> index; // Keys point into the entries
+		std::size_t bytes = 0;
+
+		std::atomic<std::uint64_t> hits = 0;
+		std::atomic<std::uint64_t> misses = 0;
+		std::atomic<std::uint64_t> invalidations = 0;
+		std::atomic<std::uint64_t> evictions = 0;
+		std::atomic<std::uint64_t> bypassed = 0;
+		std::atomic<std::uint64_t> entryCount = 0;
+		std::atomic<std::uint64_t> byteCount = 0;
+
+		void invalidateIfChanged();
+		void insert(Entry entry);
+	};
+
+	/**
+	 * @brief Collapses runs of whitespace outside of quotes into one space and trims both ends.
+	 */
+	std::string normalizeSql(std::string_view sql);
+}
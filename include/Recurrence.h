@@ -0,0 +1,119 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+ * Recurring tasks: a template stored once in the recurrences table, and tasks created from it as they are needed.
+ *
+ * Occurrence k of a template is due at its first due date plus k times the interval, counted in local time so
+ * a daily task stays at the same time of day across DST changes. A template remembers the next occurrence it
+ * hasn't created yet and when that one is due, indexed, so finding the templates a listing needs is a range scan.
+ *
+ * Instances are created lazily: listings create the ones due up to the end of the window they show, and
+ * completing an instance creates the next one in the same transaction. The tasks table never holds copies
+ * further ahead than that. recurrenceInstances links the open instances to their template.
+ */
+namespace tike {
+	/**
+	 * @brief How often a task repeats.
+	 *
+	 * @param unit "days", "weeks" or "months".
+	 * @param every The number of units between two occurrences.
+	 */
+	struct RecurrenceRule {
+		std::string unit;
+		std::int64_t every = 1;
+	};
+
+	/**
+	 * @brief Everything a new template needs.
+	 *
+	 * @param tags Tags every instance gets, comma separated.
+	 * @param firstDueAt When the first occurrence is due, in unix seconds.
+	 */
+	struct RecurringTask {
+		std::string title;
+		std::optional<std::string> description{};
+		std::string tags{};
+		RecurrenceRule rule;
+		std::int64_t firstDueAt = 0;
+	};
+
+	/**
+	 * @brief Parses a rule like "daily", "weekly", "monthly", "3 days" or "2 weeks".
+	 *
+	 * @throw std::invalid_argument If the text is not a rule.
+	 */
+	RecurrenceRule parseRecurrenceRule(std::string_view text);
+
+	/**
+	 * @brief Creates the template and instance tables if they don't exist yet.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureRecurrences(const db::Database &db);
+
+	/**
+	 * @brief Stores a new template. No instance is created.
+	 *
+	 * @param db A database opened read-write.
+	 * @return The id of the template.
+	 */
+	std::int64_t addRecurrence(const db::Database &db, const RecurringTask &task);
+
+	/**
+	 * @brief Creates the next occurrence of a template as a task.
+	 *
+	 * @param db A database opened read-write.
+	 * @param recurrenceId The template.
+	 * @return The id of the new task.
+	 */
+	std::int64_t materializeNext(const db::Database &db, std::int64_t recurrenceId);
+
+	/**
+	 * @brief Whether any template has an occurrence due by `until` that isn't a task yet.
+	 *
+	 * @param db The database, may be opened read-only.
+	 */
+	bool recurrencesDueBy(const db::Database &db, std::int64_t until);
+
+	/**
+	 * @brief When the earliest occurrence that isn't a task yet is due, in unix seconds.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @return The due time, or INT64_MAX if there are no templates.
+	 */
+	std::int64_t nextRecurrenceDue(const db::Database &db);
+
+	/**
+	 * @brief Creates every occurrence due by `until` that isn't a task yet.
+	 *
+	 * @param db A database opened read-write.
+	 * @return The number of tasks created.
+	 */
+	std::int64_t materializeDueBy(const db::Database &db, std::int64_t until);
+
+	/**
+	 * @brief Called before an open task is completed, creates the next instance if the task is a recurring one.
+	 *
+	 * The next instance is only created when no other instance of the template is open, so working through a
+	 * backlog of missed occurrences doesn't create one future task per missed one.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the task being completed (not the pseudo id).
+	 * @return The id of the new instance, if one was created.
+	 */
+	std::optional<std::int64_t> completeInstance(const db::Database &db, std::int64_t taskId);
+
+	/**
+	 * @brief Deletes the template of a recurring task. Its open instances stay as ordinary tasks.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of an instance (not the pseudo id).
+	 * @return Whether the task was an instance of a template.
+	 */
+	bool stopRecurrence(const db::Database &db, std::int64_t taskId);
+} // namespace tike
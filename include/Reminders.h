@@ -0,0 +1,59 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+/*
+ * Due dates and the reminders sent when they pass.
+ *
+ * A task's due date is tasks.dueAt in unix seconds, with a partial index over the tasks that have one.
+ * Triggers record every task whose due date is added, changed or removed (completing or removing the task
+ * included) in dueChanges.
+ *
+ * `tike --serve` loads the upcoming due dates once, with a range scan of the index, into a TimerWheel. After
+ * that it only watches PRAGMA data_version. When another connection commits, it reads the new dueChanges rows
+ * and cancels or reschedules only those tasks, so a second of waiting costs the same with ten reminders as with
+ * ten thousand. The loop registers itself in reminderLoops while it runs, and the triggers only record changes
+ * while a loop is registered, so dueChanges stays empty without one. A loop that was killed instead of stopped
+ * stays registered until the next one starts.
+ */
+namespace tike {
+	/**
+	 * @brief A task that just fell due.
+	 */
+	struct Reminder {
+		std::int64_t taskId = 0;
+		std::int64_t pseudoId = 0;
+		std::string title;
+		std::int64_t dueAt = 0;
+	};
+
+	/**
+	 * @brief Adds the dueAt column, its index, and the change log with its triggers.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureDueDates(const db::Database &db);
+
+	/**
+	 * @brief Sets or clears the due date of a task.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the task (not the pseudo id).
+	 * @param dueAt The due date in unix seconds, or std::nullopt to clear it.
+	 */
+	void setDueDate(const db::Database &db, std::int64_t taskId, std::optional<std::int64_t> dueAt);
+
+	/**
+	 * @brief Sends a reminder for every open task whose due date passes, until SIGINT or SIGTERM arrives.
+	 *
+	 * Due dates that had passed before the loop started are not reminded of. While it runs, the two signals only
+	 * stop the loop, which unregisters itself before it returns.
+	 *
+	 * @param db A database opened read-write, used by nothing else while the loop runs.
+	 * @param remind Called once per reminder, in due date order.
+	 */
+	void runReminders(const db::Database &db, const std::function<void(const Reminder &)> &remind);
+} // namespace tike
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tike {
+	/**
+	 * @class RoaringBitmap
+	 * @brief A compressed set of 32-bit integers (roaring bitmap).
+	 *
+	 * Values are split by their high 16 bits into containers. A container holding up to 4096 values is a sorted
+	 * array of their low 16 bits, a fuller one is a plain 65536-bit bitmap, so sparse and dense ranges both stay
+	 * small and AND/OR/NOT work container by container without decoding single values.
+	 */
+	class RoaringBitmap {
+	public:
+		void add(std::uint32_t value);
+		void remove(std::uint32_t value);
+		[[nodiscard]] bool contains(std::uint32_t value) const;
+
+		[[nodiscard]] bool empty() const;
+		[[nodiscard]] std::uint64_t cardinality() const;
+
+		/**
+		 * @brief Counts the values less than or equal to `value`.
+		 */
+		[[nodiscard]] std::uint64_t rank(std::uint32_t value) const;
+
+		/**
+		 * @brief All values in ascending order.
+		 */
+		[[nodiscard]] std::vector<std::uint32_t> values() const;
+
+		RoaringBitmap &operator&=(const RoaringBitmap &other);
+		RoaringBitmap &operator|=(const RoaringBitmap &other);
+		// Removes every value of `other` (AND NOT)
+		RoaringBitmap &operator-=(const RoaringBitmap &other);
+
+		friend RoaringBitmap operator&(RoaringBitmap a, const RoaringBitmap &b) { return a &= b; }
+		friend RoaringBitmap operator|(RoaringBitmap a, const RoaringBitmap &b) { return a |= b; }
+		friend RoaringBitmap operator-(RoaringBitmap a, const RoaringBitmap &b) { return a -= b; }
+
+		bool operator==(const RoaringBitmap &other) const = default;
+
+		/**
+		 * @brief Encodes the bitmap into a portable byte string, e.g. for storing it as a blob.
+		 */
+		[[nodiscard]] std::string serialize() const;
+
+		/**
+		 * @brief Decodes a bitmap written by serialize.
+		 *
+		 * @return The bitmap, or std::nullopt if the bytes are not a valid bitmap.
+		 */
+		static std::optional<RoaringBitmap> deserialize(std::string_view bytes);
+
+	private:
+		// Containers with more values than this are stored as bitmaps
+		static constexpr std::size_t arrayLimit = 4096;
+		static constexpr std::size_t bitmapWords = 65536 / 64;
+
+		struct Container {
+			std::uint16_t key = 0;
+			std::uint32_t cardinality = 0;
+			// Exactly one of these is in use, words is empty for array containers
+			std::vector<std::uint16_t> array{};
+			std::vector<std::uint64_t> words{};
+
+			[[nodiscard]] bool isBitmap() const { return !words.empty(); }
+			bool operator==(const Container &other) const = default;
+		};
+
+		// Sorted by key, never holds an empty container
+		std::vector<Container> containers;
+
+		[[nodiscard]] std::size_t lowerBound(std::uint16_t key) const;
+
+		static std::vector<std::uint64_t> toWords(const Container &container);
+
+		/**
+		 * @brief Recounts a bitmap container and turns it into an array container if it got sparse enough.
+		 */
+		static void normalize(Container &container);
+	};
+} // namespace tike
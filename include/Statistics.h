@@ -0,0 +1,57 @@
+#pragma once
+#include <CounterCache.h>
+#include <Database.h>
+#include <cstdint>
+
+/*
+ * Aggregate statistics about tasks, kept current by SQLite triggers.
+ *
+ * taskStats holds a single row of running totals and dailyStats one row per UTC day with the number of tasks
+ * created and completed on it. Triggers on tasks and completedTasks update both on every insert and delete,
+ * so reading a summary costs one row plus a range of days no matter how many tasks there are.
+ */
+namespace tike {
+	/**
+	 * @brief Everything `tike --summary` shows.
+	 *
+	 * Ages and lead times are in days.
+	 */
+	struct Summary {
+		std::int64_t open = 0;
+		std::int64_t completed = 0;
+		std::int64_t createdToday = 0;
+		std::int64_t completedToday = 0;
+		std::int64_t completedThisWeek = 0;
+		double completedPerDay = 0;
+		double completedPerWeek = 0;
+		double averageAge = 0;
+		double averageLeadTime = 0;
+	};
+
+	/**
+	 * @brief Creates the statistics tables and triggers if they don't exist yet.
+	 *
+	 * The first time this runs on an existing database the totals are seeded from the rows already there,
+	 * in the same transaction that creates the triggers.
+	 *
+	 * @param db A database opened read-write, with the task tables already created.
+	 */
+	void ensureStatistics(const db::Database &db);
+
+	/**
+	 * @brief Reads the number of open and completed tasks.
+	 *
+	 * Uses taskStats when it exists, which is a single row read, and counts the rows of both tables otherwise.
+	 *
+	 * @param db The database to read from.
+	 */
+	db::TaskCounts readTaskCounts(const db::Database &db);
+
+	/**
+	 * @brief Reads the summary from the statistics tables.
+	 *
+	 * @param db The database to read from. Must contain the statistics tables.
+	 * @param days How many days back throughput is averaged over.
+	 */
+	Summary readSummary(const db::Database &db, int days = 28);
+} // namespace tike
@@ -0,0 +1,112 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Storage tuning, `tike --tune`: measures how the disk under the database behaves and picks the SQLite settings
+ * that commit and read fastest without giving up more durability than asked for.
+ *
+ * The benchmark runs on a scratch copy next to the database, padded to a realistic size, and never touches the
+ * database itself. It goes in stages instead of trying every combination:
+ *
+ *   1. fsync latency of the disk, which bounds every durable commit
+ *   2. journal_mode and synchronous, the pairs the durability level allows, by commit latency and bytes written
+ *   3. page_size with the best journal, by commit latency and the cost of random and full reads
+ *   4. mmap_size, only kept if reads get clearly faster
+ *
+ * WAL is left out on network filesystems, where its shared memory index isn't safe. journal_mode=WAL and
+ * page_size are stored in the database file, synchronous, mmap_size and the other journal modes only last for a
+ * connection, so the chosen ones are kept in the storageSettings table and applied whenever the database is
+ * opened.
+ */
+namespace tike {
+	/**
+	 * @brief How much a commit has to survive.
+	 *
+	 * Full: a committed change survives a power loss. Normal: it survives a crash of tike, a power loss may undo
+	 * the last commits but never corrupts the database. Off: speed first, a power loss may corrupt the database.
+	 */
+	enum class Durability {
+		Full,
+		Normal,
+		Off
+	};
+
+	/**
+	 * @brief Reads a durability level, "full", "normal" or "off".
+	 *
+	 * @throw std::invalid_argument If the name isn't one of them.
+	 */
+	Durability parseDurability(std::string_view name);
+
+	/**
+	 * @brief The settings the tuner chooses between. Modes are upper case, as SQLite's pragmas take them.
+	 */
+	struct StorageSettings {
+		std::string journalMode = "DELETE";
+		std::string synchronous = "FULL";
+		std::int64_t pageSize = 4096;
+		std::int64_t mmapSize = 0;
+
+		bool operator==(const StorageSettings &) const = default;
+	};
+
+	/**
+	 * @brief One row of the benchmark. Values that weren't measured, or can't be on this system, are empty.
+	 *
+	 * @param commitMs Mean time of a small committed write.
+	 * @param bytesPerCommit Bytes written to disk per commit, checkpoints included.
+	 * @param readMs Time of a round of random lookups and full scans.
+	 */
+	struct TuneMeasurement {
+		std::string setting;
+		std::optional<double> commitMs;
+		std::optional<double> bytesPerCommit;
+		std::optional<double> readMs;
+	};
+
+	/**
+	 * @brief The outcome of tuneStorage.
+	 *
+	 * @param fsyncMs The median time to flush a small write to the disk.
+	 * @param writesMeasured Whether the bytes each commit writes could be measured. If not, the journal is chosen by
+	 * commit latency alone.
+	 */
+	struct TuneReport {
+		std::optional<double> fsyncMs;
+		bool networkFilesystem = false;
+		bool writesMeasured = false;
+		std::vector<TuneMeasurement> measurements;
+		StorageSettings current;
+		StorageSettings recommended;
+	};
+
+	/**
+	 * @brief The settings a connection to the database uses right now.
+	 */
+	StorageSettings currentStorageSettings(const db::Database &db);
+
+	/**
+	 * @brief Benchmarks the disk under the database and recommends settings. Takes a few seconds.
+	 *
+	 * @param db The database, only copied.
+	 * @param dbPath Its file, the scratch files are created next to it and removed again.
+	 * @param durability What the recommended settings have to guarantee.
+	 * @throw std::runtime_error If the scratch copy can't be made.
+	 */
+	TuneReport tuneStorage(const db::Database &db, const std::string &dbPath, Durability durability);
+
+	/**
+	 * @brief Switches the database to the settings and stores them for later connections.
+	 *
+	 * A different page size rewrites the whole file, which needs as much free space as the database takes.
+	 *
+	 * @param db A database opened read-write, outside of a transaction, with no other connection open.
+	 * @throw std::runtime_error If a setting can't be applied.
+	 */
+	void applyStorageSettings(const db::Database &db, const StorageSettings &settings);
+}
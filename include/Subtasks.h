@@ -0,0 +1,92 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * Subtasks, stored as a closure table.
+ *
+ * taskClosure has a row for every (ancestor, descendant) pair with the distance between them, including a
+ * row of depth 0 linking every task to itself. Subtrees, ancestors and roll-ups are then a single indexed
+ * lookup on either column instead of a recursive walk, and moving a subtree is one delete and one insert.
+ * Rows stay in place when a task is completed, completed tasks keep their id in completedTasks.taskId.
+ */
+namespace tike {
+	/**
+	 * @brief A task within a subtree, with the completion counts rolled up from below it.
+	 *
+	 * @param parentId The id of the parent, 0 for the root of the subtree.
+	 * @param depth The distance from the root of the subtree.
+	 * @param open Whether the task is still open.
+	 * @param total The number of tasks below this one.
+	 * @param completed How many of those are completed.
+	 */
+	struct SubtreeNode {
+		std::int64_t taskId = 0;
+		std::int64_t parentId = 0;
+		std::int64_t depth = 0;
+		std::string title;
+		bool open = false;
+		std::int64_t total = 0;
+		std::int64_t completed = 0;
+	};
+
+	/**
+	 * @brief Creates the closure table and the trigger adding new tasks to it, indexing existing tasks as roots.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureSubtasks(const db::Database &db);
+
+	/**
+	 * @brief Makes a freshly added task a child of another task.
+	 *
+	 * @param db A database opened read-write.
+	 * @param parentId The id of the parent (not the pseudo id).
+	 * @param childId The id of the new task, which must not have subtasks yet.
+	 */
+	void addSubtask(const db::Database &db, std::int64_t parentId, std::int64_t childId);
+
+	/**
+	 * @brief Moves a task and everything below it under another task.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the task to move.
+	 * @param parentId The id of the new parent, or std::nullopt to make the task a top level task.
+	 * @throw std::invalid_argument If the new parent is the task itself or one of its descendants.
+	 */
+	void moveSubtree(const db::Database &db, std::int64_t taskId, std::optional<std::int64_t> parentId);
+
+	/**
+	 * @brief Lists a task and everything below it, depth first with children ordered by id.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param rootId The id of the task.
+	 * @return The nodes, the root first. Empty if the task isn't in the closure table.
+	 */
+	std::vector<SubtreeNode> subtree(const db::Database &db, std::int64_t rootId);
+
+	/**
+	 * @brief Looks up the pseudo ids of tasks, using the bitmap of open tasks from the tag index.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param taskIds Task ids (not pseudo ids).
+	 * @return The pseudo id of each task, 0 for tasks that aren't open.
+	 */
+	std::vector<std::int64_t> pseudoIds(const db::Database &db, std::span<const std::int64_t> taskIds);
+
+	/**
+	 * @brief The ids of the open tasks below a task, deepest first.
+	 */
+	std::vector<std::int64_t> openDescendants(const db::Database &db, std::int64_t taskId);
+
+	/**
+	 * @brief Removes a task from the hierarchy, before the task itself is removed.
+	 *
+	 * @throw std::invalid_argument If the task still has open subtasks.
+	 */
+	void detachTask(const db::Database &db, std::int64_t taskId);
+} // namespace tike
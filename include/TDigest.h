@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tike {
+	/**
+	 * @class TDigest
+	 * @brief A mergeable streaming quantile sketch (merging t-digest).
+	 *
+	 * Values are summarised by a bounded number of centroids, which are small near the tails and large in the
+	 * middle, so extreme quantiles like p99 stay accurate while memory stays around `compression` centroids no
+	 * matter how many values were added. Two digests merge into a digest of the combined values, which is what
+	 * makes precomputed per-period sketches useful.
+	 */
+	class TDigest {
+	public:
+		/**
+		 * @param compression Bounds the number of centroids. Higher is more accurate and larger.
+		 */
+		explicit TDigest(double compression = 100);
+
+		/**
+		 * @brief Adds a value to the digest.
+		 *
+		 * @param value The value.
+		 * @param weight How many times the value occurred.
+		 */
+		void add(double value, double weight = 1);
+
+		/**
+		 * @brief Adds all values summarised by another digest.
+		 */
+		void merge(const TDigest &other);
+
+		/**
+		 * @brief Estimates a quantile.
+		 *
+		 * @param q The quantile, between 0 and 1.
+		 * @return The estimated value, or NaN if the digest is empty.
+		 */
+		[[nodiscard]] double quantile(double q) const;
+
+		/**
+		 * @brief Total weight of all values added.
+		 */
+		[[nodiscard]] double count() const;
+
+		/**
+		 * @brief Encodes the digest into a portable byte string, e.g. for storing it as a blob.
+		 */
+		[[nodiscard]] std::string serialize() const;
+
+		/**
+		 * @brief Decodes a digest written by serialize.
+		 *
+		 * @return The digest, or std::nullopt if the bytes are not a valid digest.
+		 */
+		static std::optional<TDigest> deserialize(std::string_view bytes);
+
+	private:
+		struct Centroid {
+			double mean;
+			double weight;
+		};
+
+		double compression;
+		double minimum;
+		double maximum;
+		// Centroids sorted by mean, new values wait in the buffer until the next compression
+		mutable std::vector<Centroid> centroids;
+		mutable std::vector<Centroid> buffer;
+
+		/**
+		 * @brief Merges the buffered values into the centroids.
+		 */
+		void compress() const;
+	};
+} // namespace tike
@@ -0,0 +1,92 @@
+#pragma once
+#include <Database.h>
+#include <RoaringBitmap.h>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/*
+ * Tags: a normalized many-to-many model (tags, taskTags) with a bitmap index.
+ *
+ * tagBitmaps holds one roaring bitmap per tag with the ids of the open tasks carrying it, plus the bitmap of
+ * all open tasks under tagId 0. Filters are answered by combining bitmaps, and since pseudo ids number the
+ * open tasks by id, the rank of a task in the open bitmap is its pseudo id. Task rows are only read for the
+ * tasks that match.
+ *
+ * Triggers on tasks and taskTags record the (task, tag) pairs whose membership changed in tagBitmapChanges.
+ * Every write applies those changes to the stored bitmaps it touches, readers apply whatever is left in
+ * memory, so the index stays correct even after writes that didn't go through tike.
+ */
+namespace tike {
+	/**
+	 * @brief A task that matched a tag filter.
+	 */
+	struct TaggedTask {
+		std::int64_t pseudoId;
+		std::int64_t taskId;
+	};
+
+	/**
+	 * @brief Creates the tag tables and triggers, and indexes the existing tasks if they are new.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureTags(const db::Database &db);
+
+	/**
+	 * @brief Adds tags to a task, creating tags that don't exist yet.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the task (not the pseudo id).
+	 * @param tags Tag names, each may also be a comma separated list.
+	 * @throw std::invalid_argument If a tag name is empty or starts with '!'.
+	 */
+	void tagTask(const db::Database &db, std::int64_t taskId, std::span<const std::string_view> tags);
+
+	/**
+	 * @brief Removes every tag from a task, for tasks that are removed rather than completed.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the task (not the pseudo id).
+	 */
+	void untagTask(const db::Database &db, std::int64_t taskId);
+
+	/**
+	 * @brief Applies the recorded membership changes to the stored bitmaps.
+	 *
+	 * Only the bitmaps of the tags the changed tasks carry or carried are loaded and rewritten, and it is cheap
+	 * when nothing changed. Write commands call it before committing.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void syncTagBitmaps(const db::Database &db);
+
+	/**
+	 * @brief Finds the open tasks matching a tag filter, ordered by id.
+	 *
+	 * Each filter is a comma separated list of tags that all have to match, a leading '!' excludes a tag.
+	 * A task matches if it matches any of the filters, e.g. {"ops,!blocked", "urgent"}.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param filters The filters, as given with --tag.
+	 * @throw std::invalid_argument If a filter contains an empty tag.
+	 */
+	std::vector<TaggedTask> filterOpenTasks(const db::Database &db, std::span<const std::string_view> filters);
+
+	/**
+	 * @brief The ids of the open tasks carrying a tag.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param tag The name of the tag.
+	 * @return The bitmap, empty if no open task has the tag.
+	 */
+	RoaringBitmap openTasksTagged(const db::Database &db, std::string_view tag);
+
+	/**
+	 * @brief The ids of all open tasks. The rank of a task in the bitmap is its pseudo id.
+	 *
+	 * @param db The database, may be opened read-only.
+	 */
+	RoaringBitmap openTaskIds(const db::Database &db);
+} // namespace tike
@@ -0,0 +1,88 @@
+#pragma once
+#include <CounterCache.h>
+#include <Database.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * A read-optimized copy of the open tasks next to the database, so `tike --list` and `--list-all` can answer from
+ * one mmap without opening SQLite.
+ *
+ *   header       magic, version, the StorageStamp of the database state, row count, next recurrence due
+ *   records      one fixed size record per task in id order: the id and where its strings are in the heap
+ *   heap         title, description and creation time of every task, back to back
+ *
+ * Pseudo ids count tasks in id order, so the record of pseudo id n is simply record n - 1. Strings are handed
+ * out as views into the mapping, nothing is copied or parsed. Like the counter sidecar, the file is replaced
+ * with an atomic rename and only trusted while its stamp matches the database.
+ */
+namespace db {
+	/**
+	 * @brief One open task, pointing into the snapshot mapping. NULL text reads as "", like in db::Record.
+	 */
+	struct SnapshotTask {
+		std::int64_t id;
+		std::string_view title;
+		std::string_view description;
+		std::string_view timeCreated;
+	};
+
+	/**
+	 * @class TaskSnapshot
+	 * @brief The snapshot sidecar of one database, mapped into memory once it is loaded.
+	 */
+	class TaskSnapshot {
+	public:
+		explicit TaskSnapshot(const std::string &dbPath) : dbPath(dbPath), snapshotPath(dbPath + ".tasks") {
+		}
+
+		~TaskSnapshot();
+
+		TaskSnapshot(const TaskSnapshot &) = delete;
+
+		TaskSnapshot &operator=(const TaskSnapshot &) = delete;
+
+		/**
+		 * @brief Maps the snapshot, if it is still current.
+		 *
+		 * @return false if the sidecar is missing, damaged or older than the database.
+		 */
+		bool load();
+
+		/**
+		 * @brief Replaces the sidecar with the rows of a query.
+		 *
+		 * Failing to write the sidecar is not an error, readers simply fall back to the database.
+		 *
+		 * @param tasks A prepared query returning id, title, description and timeCreated of the open tasks, in id
+		 * order.
+		 * @param nextRecurrenceDue When the next recurring task is due in unix seconds, INT64_MAX if there is none.
+		 * @param stamp The stamp of the database state the rows are read from.
+		 * @throw std::runtime_error If stepping the query fails.
+		 */
+		void store(Statement &tasks, std::int64_t nextRecurrenceDue, const StorageStamp &stamp) const;
+
+		/**
+		 * @brief The number of tasks in the loaded snapshot.
+		 */
+		[[nodiscard]] std::size_t size() const;
+
+		/**
+		 * @brief The task at a position, 0 based in id order.
+		 */
+		[[nodiscard]] SnapshotTask operator[](std::size_t index) const;
+
+		/**
+		 * @brief When the next recurring task was due at the time of the snapshot, listings up to then need no new
+		 * instances.
+		 */
+		[[nodiscard]] std::int64_t nextRecurrenceDue() const;
+
+	private:
+		std::string dbPath;
+		std::string snapshotPath;
+		const char *data = nullptr;
+		std::size_t mappedSize = 0;
+	};
+}
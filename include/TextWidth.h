@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Measuring UTF-8 text in terminal columns, for the tables tike prints.
+ *
+ * std::setw pads to a number of bytes, so a title with an accent or a CJK character is off by a column or more.
+ * Here a character takes the columns a terminal gives it: two for East Asian wide and fullwidth characters and
+ * emoji, none for combining marks and other zero width characters, one for everything else.
+ *
+ * Text is cut between grapheme clusters only, so a base character keeps its combining marks, emoji ZWJ sequences,
+ * modifiers and flags stay whole. Clusters follow the common cases of UAX #29, not every rule.
+ *
+ * Most titles are plain ASCII. Runs of printable ASCII are checked 16 bytes at a time with SSE2 or NEON (32 with
+ * AVX2), and only what follows such a run goes through the decoder and the width tables.
+ */
+namespace tike {
+	/**
+	 * @brief The number of terminal columns the text takes.
+	 */
+	std::size_t displayWidth(std::string_view text);
+
+	/**
+	 * @brief The longest start of a text that fits into a number of columns.
+	 *
+	 * @param bytes The length of the start, always at the end of a grapheme cluster.
+	 * @param width The columns it takes.
+	 */
+	struct TextFit {
+		std::size_t bytes = 0;
+		std::size_t width = 0;
+	};
+
+	/**
+	 * @brief Finds how much of the text fits into `columns` without splitting a grapheme cluster.
+	 */
+	TextFit fitToWidth(std::string_view text, std::size_t columns);
+
+	/**
+	 * @brief The text as a table cell of exactly `columns` columns.
+	 *
+	 * Shorter text is padded with spaces. Longer text is cut and ends in "…".
+	 */
+	std::string fitCell(std::string_view text, std::size_t columns);
+} // namespace tike
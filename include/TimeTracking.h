@@ -0,0 +1,89 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Time tracking: work intervals linked to tasks.
+ *
+ * Intervals live in the intervals table, times are unix seconds and a running interval has no stop time.
+ * Every finished interval is mirrored into an R*Tree (intervalIndex) by triggers, so overlap and range
+ * queries only visit the intervals that touch the range, however many years of history there are.
+ * The R*Tree stores 32-bit floats, which it rounds outwards, so it is used as a filter and the exact times
+ * are checked against the intervals table.
+ */
+namespace tike {
+	/**
+	 * @brief One work interval, clipped to the range that was queried.
+	 */
+	struct TrackedInterval {
+		std::int64_t taskId = 0;
+		std::string title;
+		std::int64_t startedAt = 0;
+		std::int64_t stoppedAt = 0;
+		bool running = false;
+	};
+
+	/**
+	 * @brief Total time spent on one task.
+	 */
+	struct TrackedTotal {
+		std::int64_t taskId = 0;
+		std::string title;
+		std::int64_t seconds = 0;
+	};
+
+	/**
+	 * @brief Creates the interval table, the R*Tree and the triggers keeping it current.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureTimeTracking(const db::Database &db);
+
+	/**
+	 * @brief Converts a local time to unix seconds.
+	 *
+	 * @param db Any open database, SQLite does the date handling.
+	 * @param text "HH:MM" for today, or "YYYY-MM-DD HH:MM", or "YYYY-MM-DD" for midnight.
+	 * @throw std::invalid_argument If the text is not a valid time.
+	 */
+	std::int64_t parseLocalTime(const db::Database &db, std::string_view text);
+
+	/**
+	 * @brief Starts tracking time on a task, stopping whatever interval is running.
+	 *
+	 * @param db A database opened read-write.
+	 * @param taskId The id of the task (not the pseudo id).
+	 * @param now The current time in unix seconds.
+	 * @return The interval that was stopped, if one was running.
+	 */
+	std::optional<TrackedInterval> startInterval(const db::Database &db, std::int64_t taskId, std::int64_t now);
+
+	/**
+	 * @brief Stops the running interval.
+	 *
+	 * @param db A database opened read-write.
+	 * @param now The current time in unix seconds.
+	 * @return The interval that was stopped, or std::nullopt if none was running.
+	 */
+	std::optional<TrackedInterval> stopInterval(const db::Database &db, std::int64_t now);
+
+	/**
+	 * @brief Lists the intervals overlapping [from, to), clipped to that range and ordered by start.
+	 *
+	 * @param now The current time, used as the end of a running interval.
+	 */
+	std::vector<TrackedInterval> intervalsBetween(const db::Database &db, std::int64_t from, std::int64_t to,
+	                                              std::int64_t now);
+
+	/**
+	 * @brief Sums the time spent per task within [from, to), largest first.
+	 *
+	 * @param now The current time, used as the end of a running interval.
+	 */
+	std::vector<TrackedTotal> totalsBetween(const db::Database &db, std::int64_t from, std::int64_t to,
+	                                        std::int64_t now);
+} // namespace tike
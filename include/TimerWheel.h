@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace tike {
+	/**
+	 * @class TimerWheel
+	 * @brief A hierarchical timing wheel with a resolution of one tick (a second for tike).
+	 *
+	 * Six levels of 64 slots each cover 2^36 ticks. A timer sits in the slot of the coarsest level its deadline
+	 * still differs from the current tick in, and moves down a level each time the wheel reaches that slot, so
+	 * a timer is touched at most once per level. Slots are intrusive doubly linked lists over a pool of timers,
+	 * which makes scheduling and cancelling O(1).
+	 */
+	class TimerWheel {
+	public:
+		using Handle = std::uint32_t;
+
+		/**
+		 * @param now The current tick. Only ticks after it can fire.
+		 */
+		explicit TimerWheel(std::int64_t now);
+
+		/**
+		 * @brief Schedules a timer.
+		 *
+		 * @param deadline The tick it fires at. A deadline that passed already fires on the next advance.
+		 * @param key Handed back when the timer fires.
+		 * @return A handle for cancel, valid until the timer fires or is cancelled.
+		 */
+		Handle schedule(std::int64_t deadline, std::int64_t key);
+
+		/**
+		 * @brief Cancels a timer that hasn't fired yet.
+		 */
+		void cancel(Handle handle);
+
+		/**
+		 * @brief Moves the wheel forward and fires every timer that falls due on the way.
+		 *
+		 * @param now The new current tick. Moving backwards does nothing.
+		 * @return The keys of the fired timers, earliest deadline first.
+		 */
+		std::vector<std::int64_t> advance(std::int64_t now);
+
+		/**
+		 * @brief The number of pending timers.
+		 */
+		[[nodiscard]] std::size_t size() const { return pending; }
+
+	private:
+		static constexpr int levelBits = 6;
+		static constexpr int slotCount = 1 << levelBits;
+		static constexpr int levelCount = 6;
+		static constexpr Handle none = static_cast<Handle>(-1);
+
+		struct Timer {
+			std::int64_t deadline = 0;
+			std::int64_t key = 0;
+			Handle previous = none;
+			Handle next = none;
+			std::uint32_t slot = 0;
+		};
+
+		// Fired and cancelled timers are reused through a free list threaded through `next`
+		std::vector<Timer> timers;
+		std::array<Handle, levelCount * slotCount> slots;
+		Handle freeList = none;
+		std::int64_t current;
+		std::size_t pending = 0;
+
+		void place(Handle handle);
+		void unlink(Handle handle);
+		void release(Handle handle);
+	};
+} // namespace tike
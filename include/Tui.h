@@ -0,0 +1,166 @@
+#pragma once
+#include <Database.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ * The interactive mode, `tike ui`.
+ *
+ * Only the rows on screen are ever loaded. Pages are fetched with keyset queries on the task id ("the next 40
+ * tasks after id 1234"), which cost the same on the first page as on the last of ten million rows, unlike
+ * OFFSET. A background thread with its own read-only connection loads the pages before and after the visible
+ * one, so scrolling past the edge usually finds its rows in memory already. Searches run on that thread as well,
+ * a title scan over a large table never blocks the keyboard, and a search for text that has been typed over since is
+ * interrupted instead of finishing first.
+ */
+namespace tike {
+	/**
+	 * @brief One open task as the interactive mode shows it.
+	 */
+	struct TaskRow {
+		std::int64_t id = 0;
+		std::string title;
+		std::string timeCreated;
+	};
+
+	/**
+	 * @class TaskPager
+	 * @brief Pages through the open tasks in id order, optionally only those whose title contains a search text.
+	 */
+	class TaskPager {
+	public:
+		/**
+		 * @param dbPath The database file, opened read-only twice: for the caller and for the prefetch thread.
+		 * @param pageSize The number of rows a prefetched page holds, normally the height of the screen.
+		 */
+		TaskPager(const std::string &dbPath, std::size_t pageSize);
+
+		~TaskPager();
+
+		TaskPager(const TaskPager &) = delete;
+
+		TaskPager &operator=(const TaskPager &) = delete;
+
+		/**
+		 * @brief The first `count` tasks with an id greater than `id`, in id order.
+		 */
+		std::vector<TaskRow> after(std::int64_t id, std::size_t count);
+
+		/**
+		 * @brief The last `count` tasks with an id less than `id`, in id order.
+		 */
+		std::vector<TaskRow> before(std::int64_t id, std::size_t count);
+
+		/**
+		 * @brief Only show tasks whose title contains the text, ignoring ASCII case. Empty shows all tasks.
+		 */
+		void setFilter(std::string text);
+
+		[[nodiscard]] const std::string &filter() const { return filterText; }
+
+		/**
+		 * @brief Starts looking for the first `count` tasks whose title contains the text, on the prefetch thread.
+		 *
+		 * Only the latest search counts, one still running for an earlier text is interrupted. The filter stays as
+		 * it is, setFilter switches to the text once its rows are taken.
+		 */
+		void search(std::string text, std::size_t count);
+
+		/**
+		 * @brief The rows of the latest search once it is done, empty while it runs. Hands them out only once.
+		 *
+		 * @throw std::runtime_error If the search failed.
+		 */
+		std::optional<std::vector<TaskRow>> searchResult();
+
+		/**
+		 * @brief Interrupts and forgets the latest search.
+		 */
+		void cancelSearch();
+
+		/**
+		 * @brief Checks whether any connection committed since the last call, and drops the prefetched pages if so.
+		 */
+		bool changed();
+
+		/**
+		 * @brief Asks the prefetch thread for the pages right before and right after the given rows.
+		 */
+		void prefetch(std::int64_t firstId, std::int64_t lastId);
+
+	private:
+		// A page is identified by its direction and the id it starts from
+		using PageKey = std::pair<bool, std::int64_t>;
+
+		// A connection with the two keyset queries, prepared once
+		struct Reader {
+			db::Database db;
+			db::Statement forward;
+			db::Statement backward;
+
+			explicit Reader(const std::string &dbPath);
+
+			std::vector<TaskRow> read(bool forwards, std::int64_t id, const std::string &filter, std::size_t count);
+		};
+
+		Reader reader;
+		std::size_t pageSize;
+		std::string filterText;
+		std::int64_t dataVersion;
+
+		// Shared with the prefetch thread, guarded by mutex
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<PageKey> requests;
+		std::map<PageKey, std::vector<TaskRow>> pages;
+		std::string sharedFilter;
+		std::uint64_t generation = 0;
+		bool stopping = false;
+		bool workerStopped = false;
+
+		// The latest search has this number. It waits in pendingSearch until the thread takes it, the connection
+		// running it is only set meanwhile, and searchDone says its rows or its error are ready
+		std::uint64_t searchNumber = 0;
+		std::optional<std::string> pendingSearch;
+		std::size_t searchCount = 0;
+		std::uint64_t runningSearch = 0;
+		const db::Database *searchDb = nullptr;
+		bool searchDone = false;
+		std::vector<TaskRow> searchRows;
+		std::exception_ptr searchError;
+		std::thread worker;
+
+		void prefetchLoop(std::string dbPath);
+		void runSearch(Reader &own, std::unique_lock<std::mutex> &lock);
+		void forgetSearch();
+		void dropPages();
+		std::vector<TaskRow> page(bool forwards, std::int64_t id, std::size_t count);
+	};
+
+	/**
+	 * @brief What the keys of the interactive mode do to a task. Each returns the message for the status line.
+	 */
+	struct TuiActions {
+		std::function<std::string(const TaskRow &)> complete;
+		std::function<std::string(const TaskRow &)> remove;
+	};
+
+	/**
+	 * @brief Runs the interactive mode until the user quits.
+	 *
+	 * @param pager The open tasks.
+	 * @param actions Runs the changes, through a connection of its own.
+	 * @throw std::runtime_error If stdin is not a terminal.
+	 */
+	void runTui(TaskPager &pager, const TuiActions &actions);
+} // namespace tike
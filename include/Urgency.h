@@ -0,0 +1,75 @@
+#pragma once
+#include <Database.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * Urgency: a score saying how pressing an open task is, used to pick what to work on next.
+ *
+ *   urgency = age * min(days open / 365, 1)
+ *           + due * (0.2 at 14 days before the due date, rising linearly to 1 at 7 days past it, 0 without one)
+ *           + blocking * number of open tasks waiting for this one
+ *           + the weight of every weighted tag the task carries
+ *
+ * Weights are stored in urgencyWeights and changed with --weight. Scores are computed over the open tasks in
+ * chunks laid out as one array per input, so the scoring loop is a straight run over arrays the compiler
+ * vectorizes, and only the best K tasks are kept in a bounded heap.
+ */
+namespace tike {
+	/**
+	 * @brief The weights of the urgency terms.
+	 *
+	 * @param tags Extra urgency per tag, by tag name.
+	 */
+	struct UrgencyWeights {
+		double age = 2.0;
+		double due = 12.0;
+		double blocking = 8.0;
+		std::vector<std::pair<std::string, double>> tags;
+	};
+
+	/**
+	 * @brief An open task and its urgency.
+	 */
+	struct RankedTask {
+		std::int64_t taskId = 0;
+		std::int64_t pseudoId = 0;
+		double urgency = 0;
+	};
+
+	/**
+	 * @brief Creates the weights table if it doesn't exist yet.
+	 *
+	 * @param db A database opened read-write.
+	 */
+	void ensureUrgency(const db::Database &db);
+
+	/**
+	 * @brief Reads the weights, using the defaults for those that were never set.
+	 */
+	UrgencyWeights loadUrgencyWeights(const db::Database &db);
+
+	/**
+	 * @brief Sets or resets a weight.
+	 *
+	 * @param db A database opened read-write.
+	 * @param name "age", "due", "blocking" or "tag.<name>".
+	 * @param weight The new weight, or std::nullopt to go back to the default.
+	 * @throw std::invalid_argument If the name is not a weight.
+	 */
+	void setUrgencyWeight(const db::Database &db, std::string_view name, std::optional<double> weight);
+
+	/**
+	 * @brief Finds the most urgent open tasks that nothing blocks.
+	 *
+	 * @param db The database, may be opened read-only.
+	 * @param count How many tasks to return at most.
+	 * @param now The current time in unix seconds.
+	 * @return The tasks, most urgent first. Ties go to the older task.
+	 */
+	std::vector<RankedTask> mostUrgent(const db::Database &db, std::size_t count, std::int64_t now);
+} // namespace tike
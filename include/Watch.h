@@ -0,0 +1,101 @@
+#pragma once
+#include <CounterCache.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+ * Building blocks of `tike --watch`: noticing that the database was written, and redrawing the terminal
+ * without repainting what didn't change.
+ *
+ * On Linux the watcher sleeps in inotify on the directory of the database, so an idle database costs no
+ * CPU at all. The directory is watched instead of the file because SQLite creates and deletes the journal
+ * and WAL files next to it. Elsewhere it falls back to comparing the StorageStamp once a second. Either way a
+ * wakeup only means something might have changed, PRAGMA data_version tells whether a commit happened.
+ */
+namespace tike {
+	/**
+	 * @brief The size of the terminal, in characters.
+	 */
+	struct TerminalSize {
+		std::size_t columns = 80;
+		std::size_t rows = 24;
+	};
+
+	/**
+	 * @brief The size of the terminal on stdout, or 80x24 if stdout isn't a terminal.
+	 */
+	TerminalSize terminalSize();
+
+	/**
+	 * @brief Why DatabaseWatcher::wait returned.
+	 */
+	enum class WatchEvent {
+		Written,
+		Resized
+	};
+
+	/**
+	 * @class DatabaseWatcher
+	 * @brief Waits for writes to a database file, its journal or its WAL, and for the terminal to be resized.
+	 *
+	 * SIGWINCH is taken over while a watcher exists. On Linux it is blocked and read from a signalfd next to
+	 * the inotify descriptor, elsewhere a handler sets a flag that is checked once a second.
+	 */
+	class DatabaseWatcher {
+	public:
+		/**
+		 * @param dbPath The database file. It doesn't have to exist yet.
+		 * @throw std::runtime_error If the directory can't be watched.
+		 */
+		explicit DatabaseWatcher(const std::string &dbPath);
+
+		~DatabaseWatcher();
+
+		DatabaseWatcher(const DatabaseWatcher &) = delete;
+
+		DatabaseWatcher &operator=(const DatabaseWatcher &) = delete;
+
+		/**
+		 * @brief Blocks until one of the files was written, created or removed, or the terminal was resized.
+		 */
+		WatchEvent wait();
+
+	private:
+		std::string dbPath;
+		std::string fileName;
+		int fd = -1;
+		int signalFd = -1;
+		std::optional<db::StorageStamp> lastStamp;
+	};
+
+	/**
+	 * @class TerminalDiff
+	 * @brief Turns a sequence of frames into the escape sequences that redraw only the lines that changed.
+	 */
+	class TerminalDiff {
+	public:
+		/**
+		 * @brief The output that changes the screen from the previous frame to this one.
+		 *
+		 * The first frame clears the screen. Lines are cut to the terminal width, so none of them wraps and
+		 * moves the lines below it. A frame taller than the terminal is cut as well, its last row then says
+		 * how many lines didn't fit, so the screen never scrolls.
+		 *
+		 * @param lines The new frame, one string per screen line, without line breaks.
+		 * @return The escape sequences and text to write, empty if the frame didn't change.
+		 */
+		std::string update(const std::vector<std::string> &lines);
+
+		/**
+		 * @brief Forgets what is on the screen, so the next update clears it and draws every line.
+		 *
+		 * Needed after the terminal was resized, which may have wrapped or scrolled what was shown.
+		 */
+		void reset();
+
+	private:
+		std::vector<std::string> shown;
+		bool cleared = false;
+	};
+} // namespace tike
@@ -0,0 +1,130 @@
+#include "AllocStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	// Relaxed is enough, the counts are statistics and don't order any other memory access
+	std::atomic<std::uint64_t> allocations = 0;
+	std::atomic<std::uint64_t> bytes = 0;
+	std::atomic<std::uint64_t> frees = 0;
+
+	void *countedAllocate(std::size_t size) noexcept {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(size, std::memory_order_relaxed);
+		// malloc(0) may return null, new has to return a unique pointer
+		return std::malloc(size ? size : 1);
+	}
+
+	void *countedAllocateAligned(std::size_t size, const std::align_val_t alignment) noexcept {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(size, std::memory_order_relaxed);
+		// aligned_alloc wants the size to be a multiple of the alignment
+		const auto align = static_cast<std::size_t>(alignment);
+		return std::aligned_alloc(align, (size + align - 1) / align * align);
+	}
+
+	void *throwIfNull(void *pointer) {
+		if (!pointer) {
+			throw std::bad_alloc();
+		}
+		return pointer;
+	}
+
+	void countedFree(void *pointer) noexcept {
+		if (pointer) {
+			frees.fetch_add(1, std::memory_order_relaxed);
+			std::free(pointer);
+		}
+	}
+}
+
+tike::AllocCounts tike::allocCounts() {
+	return {
+		allocations.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed),
+		frees.load(std::memory_order_relaxed)
+	};
+}
+
+// Every replaceable form of the global operators, so no allocation goes past the counters
+
+void *operator new(const std::size_t size) {
+	return throwIfNull(countedAllocate(size));
+}
+
+void *operator new[](const std::size_t size) {
+	return throwIfNull(countedAllocate(size));
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
+	return countedAllocate(size);
+}
+
+void *operator new[](const std::size_t size, const std::nothrow_t &) noexcept {
+	return countedAllocate(size);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+	return throwIfNull(countedAllocateAligned(size, alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment) {
+	return throwIfNull(countedAllocateAligned(size, alignment));
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+	return countedAllocateAligned(size, alignment);
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+	return countedAllocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept {
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept {
+	countedFree(pointer);
+}
@@ -1,164 +1,160 @@
 #include "ArgParser.h"
 
+#include <charconv>
 #include <stdexcept>
 #include <iostream>
-#include <iomanip>
-#include <bits/ranges_algo.h>
-
-void tike::ArgParser::addArg(const Arg &arg) {
-	args.push_back(arg);
-}
+#include <string>
 
 void tike::ArgParser::parse(const int argc, const char *argv[]) {
+	int index = 1;
+
+	// A leading word selects a subcommand, which stands for one of the options
+	if (!table.subcommands.empty() && argc > 1 && argv[1][0] != '-' && argv[1][0] != '\0') {
+		const std::string_view name = argv[1];
+		const int subcommand = findSubcommand(name);
+		if (subcommand < 0) {
+			throw std::invalid_argument("Unknown command: " + std::string(name));
+		}
+		index++;
+
+		const std::uint8_t valueOption = table.subcommandValues[subcommand];
+		const std::uint8_t flagOption = table.subcommandFlags[subcommand];
+		if (valueOption != detail::emptySlot && index < argc && argv[index][0] != '-') {
+			storeValue(valueOption, name, argv[index++]);
+		} else if (valueOption != detail::emptySlot && table.args[valueOption].optionalValue) {
+			values[valueOption] = true;
+		} else if (flagOption != detail::emptySlot) {
+			values[flagOption] = true;
+		} else {
+			throw std::invalid_argument("Missing value for command: " + std::string(name));
+		}
+	}
+
 	// Loop through the arguments
-	for (int index = 1; index < argc; index++) {
-		std::string currentArg = argv[index];
+	for (; index < argc; index++) {
+		const std::string_view currentArg = argv[index];
 
 		// First checks if it has the -
-		if (currentArg[0] == '-') {
-			bool matched = false;
+		if (currentArg.empty() || currentArg[0] != '-') {
+			throw std::invalid_argument("Unexpected positional argument: " + std::string(currentArg));
+		}
 
-			// Checks if it is -- with no argument name
-			if (currentArg == "--") {
-				throw std::invalid_argument("Unexpected `--` without argument.");
-			}
-			// Checks if it is --, but has a name
-			if (currentArg[1] == '-') {
-				// The 3rd char and beyond in the currentArg string
-				const std::string longName = currentArg.substr(2);
-				// Loop through the list of args in the object
-				for (auto &arg: args) {
-					// If the .name parameter matches the arg name
-					if (arg.name == longName) {
-						matched = true;
-						if (arg.type == "flag") {
-							arg.value = "true";
-						} else if (index + 1 < argc) {
-							arg.value = argv[++index];
-						} else {
-							throw std::invalid_argument("Missing value for argument: --" + longName);
-						}
-						break;
-					}
-				}
-			} else {
-				// If not -- then it's just -
-				// The 2nd char and beyond in currentArg string
-				const std::string shortName = currentArg.substr(1);
-				// Loop through the list of args in the object
-				for (auto &arg: args) {
-					// If the .name parameter matches the arg name
-					if (arg.shortName == shortName) {
-						matched = true;
-						if (arg.type == "flag") {
-							arg.value = "true";
-						} else if (index + 1 < argc) {
-							arg.value = argv[++index];
-						} else {
-							throw std::invalid_argument("Missing value for argument: -" + shortName);
-						}
-						break;
-					}
-				}
-			}
+		// Checks if it is -- with no argument name
+		if (currentArg == "--") {
+			throw std::invalid_argument("Unexpected `--` without argument.");
+		}
 
-			if (!matched) {
-				throw std::invalid_argument("Unknown argument: " + currentArg);
+		int argIndex = -1;
+		if (currentArg.size() > 1 && currentArg[1] == '-') {
+			// Checks if it is --, but has a name. The 3rd char and beyond is the long name
+			argIndex = findLong(currentArg.substr(2));
+		} else if (currentArg.size() == 2) {
+			// If not -- then it's just -, short names are a single character
+			const auto shortName = static_cast<unsigned char>(currentArg[1]);
+			if (shortName < table.shortSlots.size() && table.shortSlots[shortName] != detail::emptySlot) {
+				argIndex = table.shortSlots[shortName];
 			}
+		}
+
+		if (argIndex < 0) {
+			throw std::invalid_argument("Unknown argument: " + std::string(currentArg));
+		}
+
+		const bool valueFollows = index + 1 < argc && argv[index + 1][0] != '-';
+		if (table.args[argIndex].type == ArgType::Flag || (table.args[argIndex].optionalValue && !valueFollows)) {
+			values[argIndex] = true;
+		} else if (index + 1 < argc) {
+			storeValue(argIndex, currentArg, argv[++index]);
 		} else {
-			throw std::invalid_argument("Unexpected positional argument: " + currentArg);
+			throw std::invalid_argument("Missing value for argument: " + std::string(currentArg));
 		}
 	}
+
 	// Checks if any required args were not supplied
-	for (const auto &arg: args) {
-		if (arg.required && !arg.value) {
-			throw std::invalid_argument("Missing required argument: --" + arg.name);
+	for (std::size_t argIndex = 0; argIndex < table.args.size(); argIndex++) {
+		if (table.args[argIndex].required && std::holds_alternative<std::monostate>(values[argIndex])) {
+			throw std::invalid_argument("Missing required argument: --" + std::string(table.args[argIndex].name));
+		}
+	}
+}
+
+void tike::ArgParser::storeValue(const std::size_t argIndex, const std::string_view option,
+                                 const std::string_view value) {
+	if (table.args[argIndex].type == ArgType::String) {
+		values[argIndex] = value;
+		return;
+	}
+	if (table.args[argIndex].type == ArgType::List) {
+		if (!std::holds_alternative<std::vector<std::string_view>>(values[argIndex])) {
+			values[argIndex] = std::vector<std::string_view>();
 		}
+		std::get<std::vector<std::string_view>>(values[argIndex]).push_back(value);
+		return;
 	}
+
+	// Int values are parsed here once, the whole token has to be a number
+	std::int64_t number = 0;
+	const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+	if (error != std::errc() || end != value.data() + value.size()) {
+		throw std::invalid_argument("Invalid number for argument " + std::string(option) + ": " + std::string(value));
+	}
+	values[argIndex] = number;
 }
 
-bool tike::ArgParser::argHasValue(const std::string &name) {
-	return std::ranges::any_of(args, [&](const Arg &arg) {
-		return arg.name == name && arg.value.has_value();
-	});
+int tike::ArgParser::findSubcommand(const std::string_view name) const {
+	return detail::lookup(name, table.subcommandSeed, table.subcommandSlots, table.subcommands);
 }
 
-const tike::Arg &tike::ArgParser::getArgByName(const std::string &name) const {
-	// Use std::ranges::find_if to find the argument by name
-	const auto it = std::ranges::find_if(args, [&](const Arg &arg) {
-		return arg.name == name;
-	});
+int tike::ArgParser::findLong(const std::string_view name) const {
+	return detail::lookup(name, table.seed, table.longSlots, table.args);
+}
 
-	// Check if the iterator reached the end (no matching argument found)
-	if (it == args.end()) {
-		throw std::invalid_argument("Argument not found with name: --" + name);
+const tike::ArgValue &tike::ArgParser::valueOf(const std::string_view name, const ArgType type) const {
+	const int index = findLong(name);
+	if (index < 0) {
+		throw std::invalid_argument("Argument not found with name: --" + std::string(name));
 	}
+	if (table.args[index].type != type) {
+		throw std::invalid_argument("Argument has a different type: --" + std::string(name));
+	}
+	return values[index];
+}
 
-	// Return a valid reference to the Arg object
-	return *it;
+bool tike::ArgParser::argHasValue(const std::string_view name) const {
+	const int index = findLong(name);
+	return index >= 0 && !std::holds_alternative<std::monostate>(values[index]);
+}
+
+std::int64_t tike::ArgParser::getInt(const std::string_view name) const {
+	const ArgValue &value = valueOf(name, ArgType::Int);
+	if (!std::holds_alternative<std::int64_t>(value)) {
+		throw std::invalid_argument("Missing required argument: --" + std::string(name));
+	}
+	return std::get<std::int64_t>(value);
+}
+
+std::int64_t tike::ArgParser::getIntOr(const std::string_view name, const std::int64_t fallback) const {
+	const ArgValue &value = valueOf(name, ArgType::Int);
+	return std::holds_alternative<std::int64_t>(value) ? std::get<std::int64_t>(value) : fallback;
+}
+
+std::string_view tike::ArgParser::getString(const std::string_view name) const {
+	const ArgValue &value = valueOf(name, ArgType::String);
+	if (!std::holds_alternative<std::string_view>(value)) {
+		throw std::invalid_argument("Missing required argument: --" + std::string(name));
+	}
+	return std::get<std::string_view>(value);
+}
+
+std::span<const std::string_view> tike::ArgParser::getList(const std::string_view name) const {
+	const ArgValue &value = valueOf(name, ArgType::List);
+	if (!std::holds_alternative<std::vector<std::string_view>>(value)) {
+		return {};
+	}
+	return std::get<std::vector<std::string_view>>(value);
 }
 
 void tike::ArgParser::helpCommand() const {
-    // Display Usage
-    std::cout << "Usage: " << program << " [OPTIONS]" << std::endl;
-    std::cout << std::endl;
-
-    // Display Description
-    if (!description.empty()) {
-        std::cout << description << std::endl << std::endl;
-    }
-
-    // Display Options Header
-    std::cout << "Options:" << std::endl;
-
-    // Sort arguments by name (long name, `name` field)
-    std::vector<Arg> sortedArgs = args; // Copy args to avoid modifying the original vector
-    std::ranges::sort(sortedArgs.begin(), sortedArgs.end(), [](const Arg &a, const Arg &b) {
-        return a.name < b.name; // Sort lexicographically by `name`
-    });
-
-    // Find the longest option name (for alignment)
-    int maxOptionLength = 0;
-    for (const auto &arg : sortedArgs) {
-        std::ostringstream optionStream;
-
-        // Short name
-        if (arg.shortName.has_value()) {
-            optionStream << "-" << arg.shortName.value() << ", ";
-        } else {
-            optionStream << "    "; // Spaces if short name is absent
-        }
-
-        // Long name
-        optionStream << "--" << arg.name;
-
-        // Update the maximum length
-        maxOptionLength = std::max(maxOptionLength, static_cast<int>(optionStream.str().length()));
-    }
-
-    // Adjust spacing for descriptions
-	constexpr int padding = 6; // Space between option and description
-    const int descriptionStart = maxOptionLength + padding;
-
-    // Display sorted arguments
-    for (const auto &arg : sortedArgs) {
-        std::ostringstream optionStream;
-
-        // Short name
-        if (arg.shortName.has_value()) {
-            optionStream << "    -" << arg.shortName.value() << ", ";
-        } else {
-            optionStream << "        "; // Spaces if short name is absent;
-        }
-
-        // Long name
-        optionStream << "--" << arg.name;
-
-        // Print the option names and align description
-        std::cout << std::left << std::setw(descriptionStart)
-                  << optionStream.str();
-
-        // Print the description
-        std::cout << arg.description << std::endl;
-    }
-}
\ No newline at end of file
+	// The whole page was rendered at compile time, see tike::helpText
+	std::cout << table.help << std::flush;
+}
@@ -0,0 +1,421 @@
+#include "ColumnFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+	constexpr char magic[] = {'T', 'K', 'C', '1'};
+	constexpr std::uint32_t formatVersion = 2;
+	constexpr std::size_t rowsPerBlock = 65536;
+	constexpr std::uint8_t hasNulls = 1;
+
+	void putUnsigned(std::string &out, std::uint64_t value, const unsigned bytes) {
+		for (unsigned index = 0; index < bytes; index++, value >>= 8) {
+			out += static_cast<char>(value & 0xFF);
+		}
+	}
+
+	// Moves small deltas of either sign close to zero: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+	std::uint64_t zigzag(const std::uint64_t delta) {
+		return delta << 1 ^ (0 - (delta >> 63));
+	}
+
+	std::uint64_t unzigzag(const std::uint64_t value) {
+		return value >> 1 ^ (0 - (value & 1));
+	}
+
+	unsigned widthFor(const std::uint64_t largest) {
+		return largest == 0 ? 0 : largest <= 0xFF ? 1 : largest <= 0xFFFF ? 2 : largest <= 0xFFFFFFFF ? 4 : 8;
+	}
+
+	void putNulls(std::string &out, const std::vector<bool> &nulls) {
+		std::string bitmap((nulls.size() + 7) / 8, '\0');
+		for (std::size_t row = 0; row < nulls.size(); row++) {
+			if (nulls[row]) {
+				bitmap[row / 8] = static_cast<char>(bitmap[row / 8] | 1 << row % 8);
+			}
+		}
+		out += bitmap;
+	}
+
+	// The values of one column for the block being collected
+	struct PendingColumn {
+		std::vector<std::int64_t> integers;
+		std::vector<std::uint32_t> codes;
+		std::unordered_map<std::string, std::uint32_t> dictionary;
+		std::vector<const std::string *> entries; // Dictionary keys by code, the map's nodes don't move
+		std::vector<bool> nulls;
+		bool anyNull = false;
+
+		void clear() {
+			integers.clear();
+			codes.clear();
+			dictionary.clear();
+			entries.clear();
+			nulls.clear();
+			anyNull = false;
+		}
+	};
+
+	std::string encodeIntegers(const PendingColumn &column) {
+		std::string out;
+		out += static_cast<char>(column.anyNull ? hasNulls : 0);
+		if (column.anyNull) {
+			putNulls(out, column.nulls);
+		}
+		const std::vector<std::int64_t> &values = column.integers;
+		std::uint64_t largest = 0;
+		for (std::size_t row = 1; row < values.size(); row++) {
+			largest |= zigzag(static_cast<std::uint64_t>(values[row]) - static_cast<std::uint64_t>(values[row - 1]));
+		}
+		const unsigned width = widthFor(largest);
+		putUnsigned(out, static_cast<std::uint64_t>(values.front()), 8);
+		out += static_cast<char>(width);
+		for (std::size_t row = 1; row < values.size(); row++) {
+			putUnsigned(out, zigzag(static_cast<std::uint64_t>(values[row]) - static_cast<std::uint64_t>(values[row - 1])),
+			            width);
+		}
+		return out;
+	}
+
+	std::string encodeText(const PendingColumn &column) {
+		std::string out;
+		out += static_cast<char>(column.anyNull ? hasNulls : 0);
+		if (column.anyNull) {
+			putNulls(out, column.nulls);
+		}
+		putUnsigned(out, column.entries.size(), 4);
+		std::uint64_t total = 0;
+		for (const std::string *entry: column.entries) {
+			total += entry->size();
+		}
+		// The end of each entry in the text after them, 8 bytes only for a block with over 4 GiB of it
+		const unsigned offsetWidth = total > 0xFFFFFFFF ? 8 : 4;
+		out += static_cast<char>(offsetWidth);
+		std::uint64_t end = 0;
+		for (const std::string *entry: column.entries) {
+			end += entry->size();
+			putUnsigned(out, end, offsetWidth);
+		}
+		for (const std::string *entry: column.entries) {
+			out += *entry;
+		}
+		const unsigned width = std::max(widthFor(column.entries.size() - 1), 1u);
+		out += static_cast<char>(width);
+		for (const std::uint32_t code: column.codes) {
+			putUnsigned(out, code, width);
+		}
+		return out;
+	}
+
+	// Reads little-endian values from a chunk or the footer, failing on anything that runs past its end
+	class ByteReader {
+	public:
+		explicit ByteReader(const std::string_view bytes) : bytes(bytes) {
+		}
+
+		std::uint64_t get(const unsigned width) {
+			const std::string_view field = take(width);
+			std::uint64_t value = 0;
+			for (unsigned index = width; index > 0; index--) {
+				value = value << 8 | static_cast<unsigned char>(field[index - 1]);
+			}
+			return value;
+		}
+
+		std::string_view take(const std::size_t count) {
+			if (count > bytes.size()) {
+				throw std::runtime_error("Damaged tkc file");
+			}
+			const std::string_view field = bytes.substr(0, count);
+			bytes.remove_prefix(count);
+			return field;
+		}
+
+	private:
+		std::string_view bytes;
+	};
+
+	std::vector<bool> readNulls(ByteReader &reader, const std::size_t rows) {
+		const std::string_view bitmap = reader.take((rows + 7) / 8);
+		std::vector<bool> nulls(rows);
+		for (std::size_t row = 0; row < rows; row++) {
+			nulls[row] = bitmap[row / 8] >> row % 8 & 1;
+		}
+		return nulls;
+	}
+}
+
+std::int64_t db::writeColumnFile(Statement &cursor, const std::vector<ColumnInfo> &columns,
+                                 const std::function<void(std::string_view)> &out) {
+	std::uint64_t offset = 0;
+	const auto emit = [&](const std::string_view bytes) {
+		out(bytes);
+		offset += bytes.size();
+	};
+
+	std::string header(magic, sizeof(magic));
+	putUnsigned(header, formatVersion, 4);
+	emit(header);
+
+	std::vector<PendingColumn> pending(columns.size());
+	std::vector<std::size_t> blockRows;
+	std::string index; // The chunk ranges for the footer
+	std::size_t rows = 0;
+
+	const auto flushBlock = [&] {
+		for (std::size_t column = 0; column < columns.size(); column++) {
+			const std::string chunk = columns[column].type == ColumnType::Text
+				                          ? encodeText(pending[column])
+				                          : encodeIntegers(pending[column]);
+			putUnsigned(index, offset, 8);
+			putUnsigned(index, chunk.size(), 8);
+			emit(chunk);
+			pending[column].clear();
+		}
+		blockRows.push_back(rows);
+		rows = 0;
+	};
+
+	std::int64_t total = 0;
+	while (cursor.step()) {
+		for (std::size_t column = 0; column < columns.size(); column++) {
+			PendingColumn &values = pending[column];
+			const int result = static_cast<int>(column);
+			const bool null = cursor.columnIsNull(result);
+			values.nulls.push_back(null);
+			values.anyNull |= null;
+			if (columns[column].type != ColumnType::Text) {
+				// A NULL repeats the value before it, which keeps its delta at zero
+				values.integers.push_back(null ? values.integers.empty() ? 0 : values.integers.back()
+				                               : cursor.columnInt64(result));
+				continue;
+			}
+			const auto [entry, added] = values.dictionary.try_emplace(
+				std::string(null ? std::string_view() : cursor.columnText(result)),
+				static_cast<std::uint32_t>(values.entries.size()));
+			if (added) {
+				values.entries.push_back(&entry->first);
+			}
+			values.codes.push_back(entry->second);
+		}
+		total++;
+		if (++rows == rowsPerBlock) {
+			flushBlock();
+		}
+	}
+	cursor.reset();
+	if (rows > 0) {
+		flushBlock();
+	}
+
+	const std::uint64_t footerOffset = offset;
+	std::string footer;
+	putUnsigned(footer, columns.size(), 4);
+	for (const ColumnInfo &column: columns) {
+		footer += static_cast<char>(column.type);
+		putUnsigned(footer, column.name.size(), 2);
+		footer += column.name;
+	}
+	putUnsigned(footer, static_cast<std::uint64_t>(total), 8);
+	putUnsigned(footer, blockRows.size(), 4);
+	for (const std::size_t count: blockRows) {
+		putUnsigned(footer, count, 4);
+	}
+	footer += index;
+	putUnsigned(footer, footerOffset, 8);
+	footer.append(magic, sizeof(magic));
+	emit(footer);
+	return total;
+}
+
+db::ColumnFile::ColumnFile(const std::string &path) {
+#ifdef _WIN32
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open " + path);
+	}
+	copy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	data = copy.data();
+	size = copy.size();
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat info{};
+	if (fd < 0 || ::fstat(fd, &info) != 0) {
+		const std::string error = std::strerror(errno);
+		if (fd >= 0) {
+			::close(fd);
+		}
+		throw std::runtime_error("Failed to open " + path + ": " + error);
+	}
+	size = static_cast<std::size_t>(info.st_size);
+	if (size > 0) {
+		void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			::close(fd);
+			throw std::runtime_error("Failed to map " + path + ": " + std::strerror(errno));
+		}
+		data = static_cast<const char *>(mapping);
+	}
+	::close(fd);
+#endif
+
+	try {
+		const std::string_view file(data, size);
+		constexpr std::size_t tailSize = 8 + sizeof(magic);
+		if (size < 8 + tailSize || file.substr(0, 4) != std::string_view(magic, 4) ||
+		    file.substr(size - 4) != std::string_view(magic, 4)) {
+			throw std::runtime_error(path + " is not a tkc file");
+		}
+		if (ByteReader(file.substr(4, 4)).get(4) != formatVersion) {
+			throw std::runtime_error(path + " is a tkc file of an unknown version");
+		}
+
+		const std::uint64_t footerOffset = ByteReader(file.substr(size - tailSize, 8)).get(8);
+		if (footerOffset < 8 || footerOffset > size - tailSize) {
+			throw std::runtime_error("Damaged tkc file");
+		}
+		ByteReader footer(file.substr(footerOffset, size - tailSize - footerOffset));
+		const std::uint64_t columnCount = footer.get(4);
+		for (std::uint64_t column = 0; column < columnCount; column++) {
+			const auto type = static_cast<ColumnType>(footer.get(1));
+			if (type != ColumnType::Integer && type != ColumnType::Timestamp && type != ColumnType::Text) {
+				throw std::runtime_error("Damaged tkc file");
+			}
+			const std::string_view name = footer.take(footer.get(2));
+			columnInfo.push_back(ColumnInfo{std::string(name), type});
+		}
+		rowCount = static_cast<std::int64_t>(footer.get(8));
+		const std::uint64_t blockCount = footer.get(4);
+		for (std::uint64_t block = 0; block < blockCount; block++) {
+			blockRows.push_back(footer.get(4));
+			if (blockRows.back() == 0 || blockRows.back() > rowsPerBlock) {
+				throw std::runtime_error("Damaged tkc file");
+			}
+		}
+		for (std::uint64_t chunk = 0; chunk < blockCount * columnCount; chunk++) {
+			const ChunkRange range{footer.get(8), footer.get(8)};
+			if (range.offset < 8 || range.offset > footerOffset || range.size > footerOffset - range.offset) {
+				throw std::runtime_error("Damaged tkc file");
+			}
+			chunks.push_back(range);
+		}
+	} catch (...) {
+#ifndef _WIN32
+		if (data && copy.empty()) {
+			::munmap(const_cast<char *>(data), size);
+		}
+#endif
+		throw;
+	}
+}
+
+db::ColumnFile::~ColumnFile() {
+#ifndef _WIN32
+	if (data && copy.empty()) {
+		::munmap(const_cast<char *>(data), size);
+	}
+#endif
+	data = nullptr;
+}
+
+std::size_t db::ColumnFile::column(const std::string_view name) const {
+	for (std::size_t index = 0; index < columnInfo.size(); index++) {
+		if (columnInfo[index].name == name) {
+			return index;
+		}
+	}
+	throw std::invalid_argument("The tkc file has no column " + std::string(name));
+}
+
+std::string_view db::ColumnFile::chunk(const std::size_t block, const std::size_t column,
+                                       const ColumnType expected) const {
+	if (block >= blockRows.size() || column >= columnInfo.size()) {
+		throw std::out_of_range("No such tkc chunk");
+	}
+	const bool text = columnInfo[column].type == ColumnType::Text;
+	if (text != (expected == ColumnType::Text)) {
+		throw std::runtime_error("Column " + columnInfo[column].name + (text ? " holds text" : " doesn't hold text"));
+	}
+	const ChunkRange &range = chunks[block * columnInfo.size() + column];
+	return {data + range.offset, range.size};
+}
+
+db::IntegerChunk db::ColumnFile::integers(const std::size_t block, const std::size_t column) const {
+	ByteReader reader(chunk(block, column, ColumnType::Integer));
+	const std::size_t rows = blockRows[block];
+	IntegerChunk result;
+	if (reader.get(1) & hasNulls) {
+		result.nulls = readNulls(reader, rows);
+	}
+	result.values.resize(rows);
+	auto value = reader.get(8);
+	const auto width = static_cast<unsigned>(reader.get(1));
+	if (width != 0 && width != 1 && width != 2 && width != 4 && width != 8) {
+		throw std::runtime_error("Damaged tkc file");
+	}
+	const std::string_view deltas = reader.take((rows - 1) * width);
+	result.values[0] = static_cast<std::int64_t>(value);
+	for (std::size_t row = 1; row < rows; row++) {
+		std::uint64_t delta = 0;
+		std::memcpy(&delta, deltas.data() + (row - 1) * width, width);
+		if constexpr (std::endian::native == std::endian::big) {
+			delta = std::byteswap(delta) >> (64 - 8 * width);
+		}
+		value += unzigzag(delta);
+		result.values[row] = static_cast<std::int64_t>(value);
+	}
+	return result;
+}
+
+db::TextChunk db::ColumnFile::text(const std::size_t block, const std::size_t column) const {
+	ByteReader reader(chunk(block, column, ColumnType::Text));
+	const std::size_t rows = blockRows[block];
+	TextChunk result;
+	if (reader.get(1) & hasNulls) {
+		result.nulls = readNulls(reader, rows);
+	}
+	const std::uint64_t entries = reader.get(4);
+	const auto offsetWidth = static_cast<unsigned>(reader.get(1));
+	if (offsetWidth != 4 && offsetWidth != 8) {
+		throw std::runtime_error("Damaged tkc file");
+	}
+	std::vector<std::uint64_t> ends(entries);
+	for (std::uint64_t &end: ends) {
+		end = reader.get(offsetWidth);
+	}
+	const std::string_view bytes = reader.take(entries == 0 ? 0 : ends.back());
+	std::uint64_t start = 0;
+	for (const std::uint64_t end: ends) {
+		if (end < start) {
+			throw std::runtime_error("Damaged tkc file");
+		}
+		result.dictionary.push_back(bytes.substr(start, end - start));
+		start = end;
+	}
+	const auto width = static_cast<unsigned>(reader.get(1));
+	if (width != 1 && width != 2 && width != 4) {
+		throw std::runtime_error("Damaged tkc file");
+	}
+	result.codes.resize(rows);
+	for (std::size_t row = 0; row < rows; row++) {
+		const std::uint64_t code = reader.get(width);
+		if (code >= entries) {
+			throw std::runtime_error("Damaged tkc file");
+		}
+		result.codes[row] = static_cast<std::uint32_t>(code);
+	}
+	return result;
+}
@@ -0,0 +1,1236 @@
+#include "Commands.h"
+
+#include "Dependencies.h"
+#include "Export.h"
+#include "HttpServer.h"
+#include "LeadTime.h"
+#include "OutputSink.h"
+#include "PerfCounters.h"
+#include "Recurrence.h"
+#include "Reminders.h"
+#include "Statistics.h"
+#include "StorageTuner.h"
+#include "Subtasks.h"
+#include "Tags.h"
+#include "TaskSnapshot.h"
+#include "TextWidth.h"
+#include "TimeTracking.h"
+#include "Tui.h"
+#include "Urgency.h"
+#include "Watch.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#define VERSION_NUMBER "1.0.0"
+#define VERSION_NAME "Ymir"
+
+namespace {
+	struct TableDefinition {
+		std::string name;
+		std::vector<db::Column> columns;
+	};
+
+	const std::vector<TableDefinition> &schema() {
+		static const std::vector<TableDefinition> tables = {
+			{
+				"tasks", {
+					db::Column{.name = "id", .type = "INTEGER", .primaryKey = true, .autoIncrement = true},
+					db::Column{.name = "title", .type = "TEXT"},
+					db::Column{.name = "description", .type = "TEXT"},
+					db::Column{.name = "timeCreated", .type = "DATETIME", .defaultVal = "CURRENT_TIMESTAMP"}
+				}
+			},
+			{
+				"completedTasks", {
+					db::Column{.name = "id", .type = "INTEGER", .primaryKey = true},
+					db::Column{.name = "title", .type = "TEXT"},
+					db::Column{.name = "description", .type = "TEXT"},
+					db::Column{.name = "timeCreated", .type = "DATETIME"},
+					db::Column{.name = "timeCompleted", .type = "DATETIME", .defaultVal = "CURRENT_TIMESTAMP"},
+					// The id the task had while open, so rows linked to it (like tracked time) can still find it
+					db::Column{.name = "taskId", .type = "INTEGER"}
+				}
+			}
+		};
+		return tables;
+	}
+
+	// The cells of one row of a task table
+	struct TaskRow {
+		std::string_view title;
+		std::string_view description;
+		std::string_view timeCreated;
+	};
+
+	/*
+	 * Writes rows as a table with columns lined up.
+	 * Row index is given by row(index) and numbered with number(index), the pseudo id of its task.
+	 */
+	void writeTaskRows(std::ostream &out, const std::string &heading, const std::size_t count,
+	                   const std::function<TaskRow(std::size_t)> &row,
+	                   const std::function<std::int64_t(std::size_t)> &number) {
+		// Print header row with columns lined up. Cells are measured in terminal columns, longer text is cut
+		constexpr std::size_t columnWidth = 20;
+		const auto cell = [](const std::string_view text) {
+			return tike::fitCell(text, columnWidth - 1) + " ";
+		};
+		out << heading << "\n";
+		out << std::left << std::setw(5) << "#" // Task Number
+				<< cell("Task Title") << cell("Task Description") << cell("Time Created (UTC)") << "\n";
+		out << std::string(5 + 3 * columnWidth, '-') << "\n"; // Divider
+
+		for (std::size_t index = 0; index < count; index++) {
+			const TaskRow cells = row(index);
+
+			// Print task row with columns aligned
+			out << std::left << std::setw(5) << number(index) // Task Number
+					<< cell(cells.title) << cell(cells.description) << cell(cells.timeCreated) << "\n";
+		}
+		out << std::flush;
+	}
+
+	/*
+	 * Writes records as a table with columns lined up.
+	 * Each row is numbered with the pseudo id of its record, given in numbers.
+	 */
+	void writeTasks(std::ostream &out, const std::string &heading, const std::vector<db::Record> &records,
+	                const std::vector<std::int64_t> &numbers) {
+		writeTaskRows(out, heading, records.size(), [&](const std::size_t index) {
+			// Extract columns (title, description, timeCreated)
+			const db::Record &record = records[index];
+			return TaskRow{
+				std::get<std::string>(record.data.at("title")),
+				std::get<std::string>(record.data.at("description")),
+				std::get<std::string>(record.data.at("timeCreated"))
+			};
+		}, [&](const std::size_t index) { return numbers[index]; });
+	}
+
+	void printTasks(const std::string &heading, const std::vector<db::Record> &records,
+	                const std::vector<std::int64_t> &numbers) {
+		writeTasks(std::cout, heading, records, numbers);
+	}
+
+	std::invalid_argument noTaskWithId(const std::string &table, const std::int64_t pseudoId) {
+		return std::invalid_argument((table == "tasks" ? "No task with id " : "No completed task with id ") +
+		                             std::to_string(pseudoId));
+	}
+
+	// The id of an open task, from its pseudo id. Throws if there is no such task
+	std::int64_t taskIdOf(const db::Database &db, const std::int64_t pseudoId) {
+		// Pseudo ids number the open tasks by id from 1, so the task is the one at offset pseudoId - 1
+		db::Statement &lookup = db.prepareCached("SELECT id FROM tasks ORDER BY id LIMIT 1 OFFSET ?");
+		lookup.bindInt64(1, pseudoId - 1);
+		const bool found = pseudoId > 0 && lookup.step();
+		const std::int64_t taskId = found ? lookup.columnInt64(0) : 0;
+		lookup.reset();
+		if (!found) {
+			throw noTaskWithId("tasks", pseudoId);
+		}
+		return taskId;
+	}
+
+	int printTaskById(const db::Database &db, const std::string &table, const std::int64_t pseudoId) {
+		const db::Record record = [&] {
+			const tike::PerfPhase phase("query");
+			// Found the same way as taskIdOf finds an id, in one query so a concurrent change can't come between
+			db::Statement lookup = db.prepare(
+				"SELECT title, description, timeCreated FROM " + table + " ORDER BY id LIMIT 1 OFFSET ?");
+			lookup.bindInt64(1, pseudoId - 1);
+			if (pseudoId < 1 || !lookup.step()) {
+				throw noTaskWithId(table, pseudoId);
+			}
+			return db::Record(db::RecordData{
+				{"title", std::string(lookup.columnText(0))},
+				{"description", std::string(lookup.columnText(1))},
+				{"timeCreated", std::string(lookup.columnText(2))}
+			}, table);
+		}();
+
+		const tike::PerfPhase phase("render");
+		printTasks("Task:", {record}, {pseudoId});
+		return 0;
+	}
+
+	int printAllTasks(const db::Database &db, const std::string &table) {
+		// Get all records from the table
+		const std::vector<db::Record> records = [&] {
+			const tike::PerfPhase phase("query");
+			return db.getAllRecords(table);
+		}();
+
+		// Check if there are no records
+		if (records.empty()) {
+			std::cout << "No tasks found in table: " << table << "\n";
+			return 1;
+		}
+
+		std::vector<std::int64_t> numbers(records.size());
+		std::iota(numbers.begin(), numbers.end(), 1);
+		const tike::PerfPhase phase("render");
+		printTasks("Tasks:", records, numbers);
+		return 0;
+	}
+
+	// Prints open tasks given by id, numbered with their pseudo ids. Only the rows of these tasks are read
+	void printTasksByIds(const db::Database &db, const std::string &heading, const std::vector<std::int64_t> &taskIds,
+	                     const std::vector<std::int64_t> &pseudoIds) {
+		std::optional<tike::PerfPhase> phase(std::in_place, "query");
+		db::Statement taskById = db.prepare("SELECT title, description, timeCreated FROM tasks WHERE id = ?");
+		std::vector<db::Record> records;
+		std::vector<std::int64_t> numbers;
+		records.reserve(taskIds.size());
+		numbers.reserve(taskIds.size());
+		for (std::size_t index = 0; index < taskIds.size(); index++) {
+			taskById.reset();
+			taskById.bindInt64(1, taskIds[index]);
+			if (!taskById.step()) {
+				continue;
+			}
+			records.emplace_back(db::RecordData{
+				{"title", std::string(taskById.columnText(0))},
+				{"description", std::string(taskById.columnText(1))},
+				{"timeCreated", std::string(taskById.columnText(2))}
+			}, "tasks");
+			numbers.push_back(pseudoIds[index]);
+		}
+		phase.emplace("render");
+		printTasks(heading, records, numbers);
+	}
+
+	// Prints the open tasks matching the --tag filters
+	int printTaggedTasks(const db::Database &db, const std::span<const std::string_view> filters) {
+		const std::vector<tike::TaggedTask> matches = [&] {
+			const tike::PerfPhase phase("query");
+			return tike::filterOpenTasks(db, filters);
+		}();
+		if (matches.empty()) {
+			std::cout << "No tasks found with these tags\n";
+			return 1;
+		}
+
+		std::vector<std::int64_t> taskIds;
+		std::vector<std::int64_t> numbers;
+		for (const auto &[pseudoId, taskId]: matches) {
+			taskIds.push_back(taskId);
+			numbers.push_back(pseudoId);
+		}
+		printTasksByIds(db, "Tasks:", taskIds, numbers);
+		return 0;
+	}
+
+	std::int64_t unixNow() {
+		return std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	int helpCommand(tike::CommandContext &context) {
+		context.args.helpCommand();
+		return 0;
+	}
+
+	int versionCommand(tike::CommandContext &) {
+		std::cout << "TimeKeeper version " << VERSION_NAME << " (" << VERSION_NUMBER << ")" << std::endl;
+		return 0;
+	}
+
+	int addCommand(tike::CommandContext &context) {
+		if (!context.args.argHasValue("title")) {
+			throw std::invalid_argument("Missing required argument: --title");
+		}
+
+		db::RecordData data = {
+			{"title", std::string(context.args.getString("title"))}
+		};
+		if (context.args.argHasValue("description")) {
+			data["description"] = std::string(context.args.getString("description"));
+		}
+		// Look the parent and the due date up first, a missing parent or a bad date fails before anything is added
+		std::optional<std::int64_t> parentId;
+		if (context.args.argHasValue("parent")) {
+			parentId = taskIdOf(*context.db, context.args.getInt("parent"));
+		}
+		std::optional<std::int64_t> dueAt;
+		if (context.args.argHasValue("due")) {
+			dueAt = tike::parseLocalTime(*context.db, context.args.getString("due"));
+		}
+
+		// A recurring task is stored as a template, only its first occurrence becomes a task right away
+		if (context.args.argHasValue("every")) {
+			if (parentId) {
+				throw std::invalid_argument("Recurring tasks can't be subtasks");
+			}
+			tike::RecurringTask task{
+				.title = std::string(context.args.getString("title")),
+				.rule = tike::parseRecurrenceRule(context.args.getString("every")),
+				.firstDueAt = dueAt.value_or(unixNow())
+			};
+			if (context.args.argHasValue("description")) {
+				task.description = std::string(context.args.getString("description"));
+			}
+			for (const std::string_view tag: context.args.getList("tag")) {
+				task.tags += (task.tags.empty() ? "" : ",") + std::string(tag);
+			}
+			tike::materializeNext(*context.db, tike::addRecurrence(*context.db, task));
+			context.countDelta.open++;
+
+			std::cout << "Recurring task added successfully" << std::endl;
+			return 0;
+		}
+
+		context.db->addRecord(db::Record(data, "tasks"));
+		const std::int64_t taskId = context.db->lastInsertId();
+		context.countDelta.open++;
+		tike::tagTask(*context.db, taskId, context.args.getList("tag"));
+		if (parentId) {
+			tike::addSubtask(*context.db, *parentId, taskId);
+		}
+		if (dueAt) {
+			tike::setDueDate(*context.db, taskId, dueAt);
+		}
+
+		std::cout << "Task added successfully" << std::endl;
+		return 0;
+	}
+
+	// The end of the window a listing shows, --until or now
+	std::int64_t listingWindowEnd(const tike::CommandContext &context) {
+		return context.args.argHasValue("until") ? tike::parseLocalTime(*context.db, context.args.getString("until"))
+		                                         : unixNow();
+	}
+
+	int materializeCommand(tike::CommandContext &context) {
+		context.countDelta.open += tike::materializeDueBy(*context.db, listingWindowEnd(context));
+		return 0;
+	}
+
+	/*
+	 * Creates the instances of recurring tasks that fall into the window of a listing. Listings open the database
+	 * read-only, so the instances are written through a connection of their own, and only when the read-only
+	 * check finds something due
+	 */
+	void materializeRecurring(const tike::CommandContext &context) {
+		if (!tike::recurrencesDueBy(*context.db, listingWindowEnd(context))) {
+			return;
+		}
+		db::Database db(context.dbPath);
+		tike::CommandContext writeContext{context.args, &db, context.dbPath};
+		tike::runWriteCommand(tike::Command{"list-all", tike::Resource::WriteDb, materializeCommand}, writeContext);
+	}
+
+	// Counts rows in the database and refreshes the sidecar, used when the sidecar is missing or stale
+	db::TaskCounts recountTasks(const std::string &dbPath, const db::CounterCache &cache) {
+		const std::optional<db::StorageStamp> before = db::StorageStamp::of(dbPath);
+		if (!before) {
+			return {};
+		}
+
+		db::TaskCounts counts;
+		{
+			const db::Database db(dbPath, db::OpenMode::ReadOnly);
+			if (!db.hasTable("tasks") || !db.hasTable("completedTasks")) {
+				return {};
+			}
+			db.execute("BEGIN");
+			counts = tike::readTaskCounts(db);
+			db.execute("COMMIT");
+		}
+
+		// Only store the counts if nothing was written while counting
+		if (db::StorageStamp::of(dbPath) == before) {
+			cache.store(counts, *before);
+		}
+		return counts;
+	}
+
+	// Open task lists longer than this get no snapshot, rewriting it would slow down every write more than it saves
+	constexpr std::int64_t snapshotTaskLimit = 100'000;
+
+	// Writes the task snapshot from the database as it is now, stamp has to be taken before reading
+	void storeTaskSnapshot(const db::Database &db, const std::string &dbPath, const db::StorageStamp &stamp) {
+		db::Statement tasks = db.prepare("SELECT id, title, description, timeCreated FROM tasks ORDER BY id");
+		const std::int64_t nextRecurrenceDue = tike::nextRecurrenceDue(db);
+		db::TaskSnapshot(dbPath).store(tasks, nextRecurrenceDue, stamp);
+	}
+
+	/*
+	 * Maps the task snapshot, rebuilding it first if it is stale. Rebuilding goes by the task counts, so a list too
+	 * long for a snapshot doesn't get one written on every listing
+	 */
+	bool loadTaskSnapshot(const std::string &dbPath, db::TaskSnapshot &snapshot) {
+		const tike::PerfPhase phase("query");
+		if (snapshot.load()) {
+			return true;
+		}
+
+		const db::CounterCache cache(dbPath);
+		std::optional<db::TaskCounts> counts = cache.load();
+		if (!counts) {
+			counts = recountTasks(dbPath, cache);
+		}
+		const std::optional<db::StorageStamp> stamp = db::StorageStamp::of(dbPath);
+		if (counts->open > snapshotTaskLimit || !stamp) {
+			return false;
+		}
+		{
+			const db::Database db(dbPath, db::OpenMode::ReadOnly);
+			if (!db.hasTable("tasks")) {
+				return false;
+			}
+			db.execute("BEGIN");
+			storeTaskSnapshot(db, dbPath, *stamp);
+			db.execute("COMMIT");
+		}
+		return snapshot.load();
+	}
+
+	// Prints count tasks of the snapshot starting at position first, numbered with their pseudo ids
+	void printSnapshotTasks(const db::TaskSnapshot &snapshot, const std::string &heading, const std::size_t first,
+	                        const std::size_t count) {
+		writeTaskRows(std::cout, heading, count, [&](const std::size_t index) {
+			const db::SnapshotTask task = snapshot[first + index];
+			return TaskRow{task.title, task.description, task.timeCreated};
+		}, [&](const std::size_t index) { return static_cast<std::int64_t>(first + index + 1); });
+	}
+
+	// Opens the database the way main does for Resource::ReadDb | Resource::SchemaCheck, for commands that only
+	// need it when their fast path can't answer
+	int runOnDatabase(tike::CommandContext &context, int (*run)(tike::CommandContext &)) {
+		std::optional<db::Database> db;
+		std::optional<tike::PerfPhase> phase(std::in_place, "open");
+		if (std::filesystem::exists(context.dbPath)) {
+			db.emplace(context.dbPath, db::OpenMode::ReadOnly);
+			phase.emplace("schema");
+			tike::checkSchema(*db);
+		} else {
+			// Nothing was ever written, read from an empty database instead of creating the file
+			db.emplace(":memory:");
+			phase.emplace("schema");
+			tike::ensureSchema(*db);
+		}
+		phase.reset();
+		context.db = &*db;
+		const int result = run(context);
+		context.db = nullptr;
+		return result;
+	}
+
+	int listCommand(tike::CommandContext &context) {
+		// Fast path: answer from the snapshot, SQLite is only opened when it is stale
+		if (db::TaskSnapshot snapshot(context.dbPath); loadTaskSnapshot(context.dbPath, snapshot)) {
+			const std::int64_t pseudoId = context.args.getInt("list");
+			if (pseudoId < 1 || static_cast<std::uint64_t>(pseudoId) > snapshot.size()) {
+				// The same error as looking the task up in the database
+				throw noTaskWithId("tasks", pseudoId);
+			}
+			const tike::PerfPhase phase("render");
+			printSnapshotTasks(snapshot, "Task:", static_cast<std::size_t>(pseudoId - 1), 1);
+			return 0;
+		}
+
+		return runOnDatabase(context, [](tike::CommandContext &readContext) {
+			return printTaskById(*readContext.db, "tasks", readContext.args.getInt("list"));
+		});
+	}
+
+	int listAllCommand(tike::CommandContext &context) {
+		// Fast path for the plain listing, as long as no recurring task has come due since the snapshot was taken
+		const bool plain = context.args.getList("tag").empty() && !context.args.argHasValue("until");
+		if (db::TaskSnapshot snapshot(context.dbPath);
+			plain && loadTaskSnapshot(context.dbPath, snapshot) && unixNow() < snapshot.nextRecurrenceDue()) {
+			if (snapshot.size() == 0) {
+				std::cout << "No tasks found in table: tasks\n";
+				return 1;
+			}
+			const tike::PerfPhase phase("render");
+			printSnapshotTasks(snapshot, "Tasks:", 0, snapshot.size());
+			return 0;
+		}
+
+		return runOnDatabase(context, [](tike::CommandContext &readContext) {
+			materializeRecurring(readContext);
+			if (const auto filters = readContext.args.getList("tag"); !filters.empty()) {
+				return printTaggedTasks(*readContext.db, filters);
+			}
+			return printAllTasks(*readContext.db, "tasks");
+		});
+	}
+
+	// Deletes an open task, after unlinking it from its parent and subtasks and dropping its tags
+	void removeTask(tike::CommandContext &context, const std::int64_t taskId) {
+		tike::detachTask(*context.db, taskId);
+		tike::untagTask(*context.db, taskId);
+		db::Statement &remove = context.db->prepareCached("DELETE FROM tasks WHERE id = ?");
+		remove.bindInt64(1, taskId);
+		remove.step();
+		remove.reset();
+		context.countDelta.open--;
+	}
+
+	int removeCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("remove");
+		// Look the task up first, so removing a task that doesn't exist fails instead of doing nothing
+		removeTask(context, taskIdOf(*context.db, id));
+
+		std::cout << "Task " << id << " removed successfully" << std::endl;
+		return 0;
+	}
+
+	// Moves an open task to completedTasks, keeping its id so rows linked to it can still find it
+	void completeTask(tike::CommandContext &context, const std::int64_t taskId) {
+		// The next instance of a recurring task is created in the same transaction
+		if (tike::completeInstance(*context.db, taskId)) {
+			context.countDelta.open++;
+		}
+
+		db::Statement &copy = context.db->prepareCached(R"(
+			INSERT INTO completedTasks (title, description, timeCreated, taskId)
+			SELECT title, description, timeCreated, id FROM tasks WHERE id = ?
+		)");
+		copy.bindInt64(1, taskId);
+		copy.step();
+		copy.reset();
+
+		db::Statement &remove = context.db->prepareCached("DELETE FROM tasks WHERE id = ?");
+		remove.bindInt64(1, taskId);
+		remove.step();
+		remove.reset();
+		context.countDelta.open--;
+		context.countDelta.completed++;
+	}
+
+	int completeCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("complete");
+		const std::int64_t taskId = taskIdOf(*context.db, id);
+
+		// With --recursive the open subtasks go first, all within the command's transaction
+		if (context.args.argHasValue("recursive")) {
+			const std::vector<std::int64_t> subtasks = tike::openDescendants(*context.db, taskId);
+			for (const std::int64_t subtaskId: subtasks) {
+				completeTask(context, subtaskId);
+			}
+			std::cout << "Completed task " << id << " and " << subtasks.size() << " subtasks" << std::endl;
+		}
+
+		completeTask(context, taskId);
+		return 0;
+	}
+
+	int exportCommand(tike::CommandContext &context) {
+		const tike::ExportFormat format = tike::parseExportFormat(context.args.getString("export"));
+		const tike::OutputOptions options{.direct = context.args.argHasValue("direct")};
+		const std::unique_ptr<tike::OutputSink> out = context.args.argHasValue("output")
+			                                              ? tike::openOutputFile(
+				                                              std::string(context.args.getString("output")), options)
+			                                              : tike::standardOutput(options);
+		tike::exportTasks(*context.db, context.args.argHasValue("completed"), format, *out);
+		out->finish();
+		return 0;
+	}
+
+	int listCompletedCommand(tike::CommandContext &context) {
+		return printTaskById(*context.db, "completedTasks", context.args.getInt("list-completed"));
+	}
+
+	int listAllCompletedCommand(tike::CommandContext &context) {
+		return printAllTasks(*context.db, "completedTasks");
+	}
+
+	int countCommand(tike::CommandContext &context) {
+		// Fast path: a single mmap of the sidecar, SQLite is only loaded when the sidecar is stale
+		const db::CounterCache cache(context.dbPath);
+		std::optional<db::TaskCounts> counts = cache.load();
+		if (!counts) {
+			counts = recountTasks(context.dbPath, cache);
+		}
+
+		std::cout << (context.args.argHasValue("completed") ? counts->completed : counts->open) << "\n";
+		return 0;
+	}
+
+	int summaryCommand(tike::CommandContext &context) {
+		if (!context.db->hasTable("taskStats")) {
+			throw std::runtime_error("No statistics yet, they are set up by the next command that writes");
+		}
+
+		const tike::Summary summary = tike::readSummary(*context.db);
+		std::cout << std::fixed << std::setprecision(1)
+				<< "Open tasks:          " << summary.open << "\n"
+				<< "Completed tasks:     " << summary.completed << "\n"
+				<< "Created today:       " << summary.createdToday << "\n"
+				<< "Completed today:     " << summary.completedToday << "\n"
+				<< "Completed this week: " << summary.completedThisWeek << "\n"
+				<< "Throughput:          " << summary.completedPerDay << " per day, "
+				<< summary.completedPerWeek << " per week (last 28 days)\n"
+				<< "Average backlog age: " << summary.averageAge << " days\n"
+				<< "Average lead time:   " << summary.averageLeadTime << " days" << std::endl;
+		return 0;
+	}
+
+	// Durations are given in days, short ones read better in hours
+	std::string formatDays(const double days) {
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(1);
+		if (days < 1) {
+			stream << days * 24 << " hours";
+		} else {
+			stream << days << " days";
+		}
+		return stream.str();
+	}
+
+	int leadTimeCommand(tike::CommandContext &context) {
+		std::optional<std::string> since;
+		if (context.args.argHasValue("since")) {
+			since = std::string(context.args.getString("since"));
+		}
+
+		const tike::LeadTimeReport report = tike::leadTimeReport(*context.db, since);
+		if (report.count == 0) {
+			std::cout << "No completed tasks" << (since ? " since " + *since : "") << "\n";
+			return 1;
+		}
+
+		std::cout << "Lead time of " << report.count << " completed tasks\n"
+				<< "p50: " << formatDays(report.p50) << "\n"
+				<< "p90: " << formatDays(report.p90) << "\n"
+				<< "p99: " << formatDays(report.p99) << std::endl;
+		return 0;
+	}
+
+	std::string formatDuration(const std::int64_t seconds) {
+		std::ostringstream stream;
+		stream << seconds / 3600 << "h " << std::setw(2) << std::setfill('0') << seconds / 60 % 60 << "m";
+		return stream.str();
+	}
+
+	// The range given with --from and --to. Without --from it starts at defaultFrom, without --to it ends now
+	std::pair<std::int64_t, std::int64_t> timeRange(const tike::CommandContext &context, const std::string &defaultFrom) {
+		const db::Database &db = *context.db;
+		const std::int64_t from = tike::parseLocalTime(
+			db, context.args.argHasValue("from") ? context.args.getString("from") : std::string_view(defaultFrom));
+		const std::int64_t to = context.args.argHasValue("to") ? tike::parseLocalTime(db, context.args.getString("to"))
+		                                                       : unixNow();
+		if (to <= from) {
+			throw std::invalid_argument("The end of the time range has to be after its start");
+		}
+		return {from, to};
+	}
+
+	int startCommand(tike::CommandContext &context) {
+		const std::int64_t taskId = taskIdOf(*context.db, context.args.getInt("start"));
+		db::Statement &title = context.db->prepareCached("SELECT title FROM tasks WHERE id = ?");
+		title.bindInt64(1, taskId);
+		title.step();
+		const std::string taskTitle(title.columnText(0));
+		title.reset();
+		if (const auto stopped = tike::startInterval(*context.db, taskId, unixNow())) {
+			std::cout << "Stopped " << stopped->title << " after "
+					<< formatDuration(stopped->stoppedAt - stopped->startedAt) << "\n";
+		}
+		std::cout << "Started " << taskTitle << std::endl;
+		return 0;
+	}
+
+	int stopCommand(tike::CommandContext &context) {
+		const auto stopped = tike::stopInterval(*context.db, unixNow());
+		if (!stopped) {
+			std::cout << "No time is being tracked\n";
+			return 1;
+		}
+		std::cout << "Stopped " << stopped->title << " after "
+				<< formatDuration(stopped->stoppedAt - stopped->startedAt) << std::endl;
+		return 0;
+	}
+
+	int timeLogCommand(tike::CommandContext &context) {
+		const auto [from, to] = timeRange(context, "00:00");
+		const std::vector<tike::TrackedInterval> intervals = tike::intervalsBetween(*context.db, from, to, unixNow());
+		if (intervals.empty()) {
+			std::cout << "No tracked time in this range\n";
+			return 1;
+		}
+
+		db::Statement localTime = context.db->prepare("SELECT datetime(?, 'unixepoch', 'localtime')");
+		const auto format = [&localTime](const std::int64_t time) {
+			localTime.reset();
+			localTime.bindInt64(1, time);
+			localTime.step();
+			return std::string(localTime.columnText(0));
+		};
+
+		constexpr int columnWidth = 20;
+		std::cout << std::left << std::setw(columnWidth) << "Started"
+				<< std::setw(columnWidth) << "Stopped"
+				<< std::setw(10) << "Time"
+				<< "Task" << "\n";
+		std::cout << std::string(2 * columnWidth + 10 + columnWidth, '-') << "\n";
+		for (const auto &interval: intervals) {
+			std::cout << std::left << std::setw(columnWidth) << format(interval.startedAt)
+					<< std::setw(columnWidth) << (interval.running ? "running" : format(interval.stoppedAt))
+					<< std::setw(10) << formatDuration(interval.stoppedAt - interval.startedAt)
+					<< interval.title << "\n";
+		}
+		std::cout << std::flush;
+		return 0;
+	}
+
+	int timeTotalCommand(tike::CommandContext &context) {
+		// Weeks start on Monday: the coming Sunday, or today if it is one, minus six days
+		db::Statement monday = context.db->prepare("SELECT date('now', 'localtime', 'weekday 0', '-6 days')");
+		monday.step();
+
+		const auto [from, to] = timeRange(context, std::string(monday.columnText(0)));
+		const std::vector<tike::TrackedTotal> totals = tike::totalsBetween(*context.db, from, to, unixNow());
+		if (totals.empty()) {
+			std::cout << "No tracked time in this range\n";
+			return 1;
+		}
+
+		std::int64_t sum = 0;
+		for (const auto &[taskId, title, seconds]: totals) {
+			std::cout << std::left << std::setw(10) << formatDuration(seconds) << title << "\n";
+			sum += seconds;
+		}
+		std::cout << std::left << std::setw(10) << formatDuration(sum) << "Total" << std::endl;
+		return 0;
+	}
+
+	int stopRepeatingCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("stop-repeating");
+		if (!tike::stopRecurrence(*context.db, taskIdOf(*context.db, id))) {
+			std::cout << "Task " << id << " isn't a recurring task\n";
+			return 1;
+		}
+		std::cout << "Task " << id << " won't repeat any more" << std::endl;
+		return 0;
+	}
+
+	int moveCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("move");
+		std::optional<std::int64_t> parentId;
+		if (context.args.argHasValue("parent")) {
+			parentId = taskIdOf(*context.db, context.args.getInt("parent"));
+		}
+		tike::moveSubtree(*context.db, taskIdOf(*context.db, id), parentId);
+
+		if (parentId) {
+			std::cout << "Task " << id << " moved below task " << context.args.getInt("parent") << std::endl;
+		} else {
+			std::cout << "Task " << id << " is now a top level task" << std::endl;
+		}
+		return 0;
+	}
+
+	int subtreeCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("subtree");
+		const std::vector<tike::SubtreeNode> nodes = tike::subtree(*context.db, taskIdOf(*context.db, id));
+		if (nodes.empty()) {
+			std::cout << "Task not found: " << id << "\n";
+			return 1;
+		}
+
+		std::vector<std::int64_t> taskIds;
+		for (const auto &node: nodes) {
+			taskIds.push_back(node.taskId);
+		}
+		const std::vector<std::int64_t> numbers = tike::pseudoIds(*context.db, taskIds);
+
+		// Completed subtasks have no pseudo id, they are shown with a dash
+		std::cout << std::left << std::setw(5) << "#" << "Task" << "\n";
+		std::cout << std::string(45, '-') << "\n";
+		for (std::size_t index = 0; index < nodes.size(); index++) {
+			const tike::SubtreeNode &node = nodes[index];
+			std::cout << std::left << std::setw(5) << (node.open ? std::to_string(numbers[index]) : "-")
+					<< std::string(2 * node.depth, ' ') << node.title;
+			if (!node.open) {
+				std::cout << " (done)";
+			} else if (node.total > 0) {
+				std::cout << " (" << node.completed << "/" << node.total << " done)";
+			}
+			std::cout << "\n";
+		}
+		std::cout << std::flush;
+		return 0;
+	}
+
+	// Prints the given nodes of the dependency graph, in the given order
+	void printNodes(const db::Database &db, const std::string &heading, const tike::DependencyAnalysis &analysis,
+	                const std::span<const tike::DependencyGraph::Node> nodes) {
+		std::vector<std::int64_t> taskIds;
+		std::vector<std::int64_t> numbers;
+		for (const tike::DependencyGraph::Node node: nodes) {
+			taskIds.push_back(analysis.taskId(node));
+			numbers.push_back(analysis.pseudoId(node));
+		}
+		printTasksByIds(db, heading, taskIds, numbers);
+	}
+
+	int blockCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("block");
+		const std::int64_t blocker = context.args.getInt("by");
+		tike::addDependency(*context.db, taskIdOf(*context.db, id), taskIdOf(*context.db, blocker));
+		std::cout << "Task " << id << " is blocked by task " << blocker << std::endl;
+		return 0;
+	}
+
+	int unblockCommand(tike::CommandContext &context) {
+		const std::int64_t id = context.args.getInt("unblock");
+		const std::int64_t blocker = context.args.getInt("by");
+		if (!tike::removeDependency(*context.db, taskIdOf(*context.db, id), taskIdOf(*context.db, blocker))) {
+			std::cout << "Task " << id << " isn't blocked by task " << blocker << "\n";
+			return 1;
+		}
+		std::cout << "Task " << id << " is no longer blocked by task " << blocker << std::endl;
+		return 0;
+	}
+
+	int nextCommand(tike::CommandContext &context) {
+		materializeRecurring(context);
+		const auto count = static_cast<std::size_t>(std::max<std::int64_t>(
+			0, context.args.getIntOr("next", std::numeric_limits<std::int32_t>::max())));
+		const std::vector<tike::RankedTask> ranked = tike::mostUrgent(*context.db, count, unixNow());
+		if (ranked.empty()) {
+			std::cout << "No open tasks\n";
+			return 1;
+		}
+
+		std::vector<std::int64_t> taskIds;
+		for (const auto &task: ranked) {
+			taskIds.push_back(task.taskId);
+		}
+		db::Statement titleById = context.db->prepare("SELECT title FROM tasks WHERE id = ?");
+
+		std::cout << std::left << std::setw(5) << "#" << std::setw(10) << "Urgency" << "Task Title" << "\n";
+		std::cout << std::string(45, '-') << "\n";
+		for (const auto &[taskId, pseudoId, urgency]: ranked) {
+			titleById.reset();
+			titleById.bindInt64(1, taskId);
+			if (!titleById.step()) {
+				continue;
+			}
+			std::ostringstream score;
+			score << std::fixed << std::setprecision(2) << urgency;
+			std::cout << std::left << std::setw(5) << pseudoId << std::setw(10) << score.str()
+					<< titleById.columnText(0) << "\n";
+		}
+		std::cout << std::flush;
+		return 0;
+	}
+
+	int weightCommand(tike::CommandContext &context) {
+		const std::string_view setting = context.args.getString("weight");
+		const std::size_t equals = setting.find('=');
+		if (equals == std::string_view::npos) {
+			throw std::invalid_argument("Expected --weight name=value, e.g. due=12 or tag.ops=3");
+		}
+		const std::string_view name = setting.substr(0, equals);
+		const std::string_view value = setting.substr(equals + 1);
+
+		// An empty value goes back to the default
+		if (value.empty()) {
+			tike::setUrgencyWeight(*context.db, name, std::nullopt);
+			std::cout << "Weight " << name << " reset" << std::endl;
+			return 0;
+		}
+		double weight = 0;
+		const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), weight);
+		if (error != std::errc() || end != value.data() + value.size()) {
+			throw std::invalid_argument("Invalid weight: " + std::string(value));
+		}
+		tike::setUrgencyWeight(*context.db, name, weight);
+		std::cout << "Weight " << name << " set to " << weight << std::endl;
+		return 0;
+	}
+
+	int criticalPathCommand(tike::CommandContext &context) {
+		const tike::DependencyAnalysis analysis = tike::analyseDependencies(*context.db, context.dbPath);
+		if (analysis.criticalPath.size() < 2) {
+			std::cout << "No open task is blocked by another one\n";
+			return 1;
+		}
+		printNodes(*context.db, "Critical path, " + std::to_string(analysis.criticalPath.size()) + " tasks in order:",
+		           analysis, analysis.criticalPath);
+		return 0;
+	}
+
+	// Runs the --remind-hook command, the reminder is handed over in environment variables
+	void runReminderHook(const std::string &command, const tike::Reminder &reminder) {
+		const auto setVariable = [](const char *name, const std::string &value) {
+#ifdef _WIN32
+			_putenv_s(name, value.c_str());
+#else
+			setenv(name, value.c_str(), 1);
+#endif
+		};
+		setVariable("TIKE_TASK_ID", std::to_string(reminder.pseudoId));
+		setVariable("TIKE_TASK_TITLE", reminder.title);
+		setVariable("TIKE_DUE_AT", std::to_string(reminder.dueAt));
+		if (std::system(command.c_str()) != 0) {
+			std::cerr << "Reminder hook failed for task " << reminder.pseudoId << std::endl;
+		}
+	}
+
+	int serveCommand(tike::CommandContext &context) {
+		// The loop outlives any single transaction, so it opens its own connection instead of going through main
+		const db::Database db(context.dbPath);
+		tike::ensureSchema(db);
+
+		std::ofstream log;
+		if (context.args.argHasValue("remind-log")) {
+			const std::string path(context.args.getString("remind-log"));
+			log.open(path, std::ios::app);
+			if (!log) {
+				throw std::invalid_argument("Can't open the reminder log: " + path);
+			}
+		}
+		std::optional<std::string> hook;
+		if (context.args.argHasValue("remind-hook")) {
+			hook = std::string(context.args.getString("remind-hook"));
+		}
+
+		db::Statement localTime = db.prepare("SELECT datetime(?, 'unixepoch', 'localtime')");
+		std::cout << "Waiting for due dates, stop with Ctrl+C" << std::endl;
+		tike::runReminders(db, [&](const tike::Reminder &reminder) {
+			localTime.bindInt64(1, reminder.dueAt);
+			localTime.step();
+			const std::string line = std::string(localTime.columnText(0)) + "  Task " +
+			                         std::to_string(reminder.pseudoId) + " is due: " + reminder.title;
+			localTime.reset();
+			if (log.is_open()) {
+				log << line << std::endl;
+			} else {
+				std::cout << line << std::endl;
+			}
+			if (hook) {
+				runReminderHook(*hook, reminder);
+			}
+		});
+		return 0;
+	}
+
+	int watchCommand(tike::CommandContext &context) {
+		// Stays resident, so it opens its own connection, once the database exists
+		tike::DatabaseWatcher watcher(context.dbPath);
+		tike::TerminalDiff screen;
+		std::optional<db::Database> db;
+		std::optional<std::int64_t> shownVersion;
+		for (bool redraw = true;;) {
+			if (!db && std::filesystem::exists(context.dbPath)) {
+				db.emplace(context.dbPath, db::OpenMode::ReadOnly);
+			}
+
+			// Wakeups also come from writes that didn't commit yet, only a new data_version means new rows
+			const std::optional<std::int64_t> version = db ? std::optional(db->dataVersion()) : std::nullopt;
+			if (redraw || version != shownVersion) {
+				shownVersion = version;
+				std::stringstream frame;
+				if (db && db->hasTable("tasks")) {
+					const std::vector<db::Record> records = db->getAllRecords("tasks");
+					std::vector<std::int64_t> numbers(records.size());
+					std::iota(numbers.begin(), numbers.end(), 1);
+					writeTasks(frame, "Tasks (watching, Ctrl+C to quit):", records, numbers);
+				} else {
+					frame << "No tasks yet (watching, Ctrl+C to quit)\n";
+				}
+
+				std::vector<std::string> lines;
+				for (std::string line; std::getline(frame, line);) {
+					lines.push_back(std::move(line));
+				}
+				std::cout << screen.update(lines) << std::flush;
+			}
+
+			// A resized terminal may have wrapped or scrolled the old frame, so it is drawn again from scratch
+			redraw = watcher.wait() == tike::WatchEvent::Resized;
+			if (redraw) {
+				screen.reset();
+			}
+		}
+	}
+
+	int uiCommand(tike::CommandContext &context) {
+		if (!std::filesystem::exists(context.dbPath)) {
+			std::cout << "No tasks yet" << std::endl;
+			return 1;
+		}
+		// The pager reads through read-only connections of its own, changes go through this one
+		db::Database db(context.dbPath);
+		tike::ensureSchema(db);
+		tike::TaskPager pager(context.dbPath, std::max<std::size_t>(tike::terminalSize().rows, 3) - 2);
+
+		// Each key runs as a write command of its own, so the counter sidecar stays current
+		const auto runOnTask = [&](const std::function<void(tike::CommandContext &)> &change) {
+			tike::CommandContext writeContext{context.args, &db, context.dbPath};
+			tike::runWriteCommand([&](tike::CommandContext &runContext) {
+				change(runContext);
+				return 0;
+			}, writeContext);
+		};
+		tike::runTui(pager, tike::TuiActions{
+			.complete = [&](const tike::TaskRow &row) {
+				runOnTask([&](tike::CommandContext &runContext) { completeTask(runContext, row.id); });
+				return "Completed " + row.title;
+			},
+			.remove = [&](const tike::TaskRow &row) {
+				runOnTask([&](tike::CommandContext &runContext) { removeTask(runContext, row.id); });
+				return "Removed " + row.title;
+			}
+		});
+		return 0;
+	}
+
+	bool isOpenTask(const db::Database &db, const std::int64_t taskId) {
+		db::Statement &find = db.prepareCached("SELECT 1 FROM tasks WHERE id = ?");
+		find.bindInt64(1, taskId);
+		const bool found = find.step();
+		find.reset();
+		return found;
+	}
+
+	int httpCommand(tike::CommandContext &context) {
+		// The readers of the server open read-only connections of their own, writes go through this one
+		db::Database db(context.dbPath);
+		tike::ensureSchema(db);
+
+		// Each request runs as a write command of its own, so the sidecars stay current
+		const auto runChange = [&](const std::function<int(tike::CommandContext &)> &change) {
+			tike::CommandContext writeContext{context.args, &db, context.dbPath};
+			return tike::runWriteCommand(change, writeContext);
+		};
+		std::chrono::seconds sendTimeout = tike::defaultSendTimeout;
+		if (context.args.argHasValue("send-timeout")) {
+			sendTimeout = std::chrono::seconds(context.args.getInt("send-timeout"));
+			if (sendTimeout.count() < 1) {
+				throw std::invalid_argument("The send timeout has to be at least a second");
+			}
+		}
+
+		tike::runHttpServer(std::string(context.args.getString("http")), context.dbPath, tike::HttpActions{
+			.add = [&](const tike::NewTask &task) {
+				std::int64_t taskId = 0;
+				runChange([&](tike::CommandContext &runContext) {
+					db::RecordData data = {{"title", task.title}};
+					if (task.description) {
+						data["description"] = *task.description;
+					}
+					runContext.db->addRecord(db::Record(data, "tasks"));
+					taskId = runContext.db->lastInsertId();
+					runContext.countDelta.open++;
+					return 0;
+				});
+				return taskId;
+			},
+			.complete = [&](const std::int64_t taskId) {
+				return runChange([&](tike::CommandContext &runContext) {
+					if (!isOpenTask(*runContext.db, taskId)) {
+						return 1;
+					}
+					completeTask(runContext, taskId);
+					return 0;
+				}) == 0;
+			},
+			.remove = [&](const std::int64_t taskId) {
+				return runChange([&](tike::CommandContext &runContext) {
+					if (!isOpenTask(*runContext.db, taskId)) {
+						return 1;
+					}
+					removeTask(runContext, taskId);
+					return 0;
+				}) == 0;
+			}
+		}, 0, sendTimeout);
+	}
+
+	std::string describeSettings(const tike::StorageSettings &settings) {
+		std::ostringstream stream;
+		stream << "journal_mode=" << settings.journalMode << " synchronous=" << settings.synchronous
+				<< " page_size=" << settings.pageSize << " mmap_size=" << settings.mmapSize;
+		return stream.str();
+	}
+
+	int tuneCommand(tike::CommandContext &context) {
+		const tike::Durability durability = tike::parseDurability(
+			context.args.argHasValue("durability") ? context.args.getString("durability") : "full");
+
+		// Opened here instead of by main, changing the page size has to run outside of a transaction
+		const db::Database db(context.dbPath);
+		tike::ensureSchema(db);
+		std::cout << "Benchmarking the disk under " << context.dbPath << ", this takes a few seconds" << std::endl;
+		const tike::TuneReport report = tike::tuneStorage(db, context.dbPath, durability);
+
+		if (report.fsyncMs) {
+			std::cout << std::fixed << std::setprecision(2) << "fsync: " << *report.fsyncMs << " ms\n";
+		}
+		if (report.networkFilesystem) {
+			std::cout << "The database is on a network filesystem, WAL is left out\n";
+		}
+		if (!report.writesMeasured) {
+			std::cout << "This system doesn't report the bytes written to the disk, the journal is chosen by commit "
+					"time alone\n";
+		}
+		const auto printValue = [](const std::optional<double> value, const std::string_view unit) {
+			std::ostringstream cell;
+			if (value) {
+				cell << std::fixed << std::setprecision(unit == "KiB" ? 1 : 2) << *value << " " << unit;
+			} else {
+				cell << "-";
+			}
+			std::cout << std::setw(16) << cell.str();
+		};
+		std::cout << "\n" << std::left << std::setw(40) << "Setting" << std::right << std::setw(16) << "Commit"
+				<< std::setw(16) << "Written" << std::setw(16) << "Reads" << "\n";
+		for (const tike::TuneMeasurement &measurement: report.measurements) {
+			std::cout << std::left << std::setw(40) << measurement.setting << std::right;
+			printValue(measurement.commitMs, "ms");
+			printValue(measurement.bytesPerCommit ? std::optional(*measurement.bytesPerCommit / 1024) : std::nullopt,
+			           "KiB");
+			printValue(measurement.readMs, "ms");
+			std::cout << "\n";
+		}
+		std::cout << "\nCurrent:     " << describeSettings(report.current)
+				<< "\nRecommended: " << describeSettings(report.recommended) << std::endl;
+
+		if (report.recommended == report.current) {
+			std::cout << "The database already uses these settings" << std::endl;
+		} else if (context.args.argHasValue("apply")) {
+			tike::applyStorageSettings(db, report.recommended);
+			std::cout << "Applied the recommended settings" << std::endl;
+		} else {
+			std::cout << "Run tike --tune --apply to use them" << std::endl;
+		}
+		return 0;
+	}
+
+	using tike::Resource;
+
+	// The dispatch table. Order matters, the first command whose option was given runs
+	constexpr std::array commands = {
+		tike::Command{"help", Resource::None, helpCommand},
+		tike::Command{"version", Resource::None, versionCommand},
+		tike::Command{"count", Resource::None, countCommand},
+		tike::Command{"add", Resource::WriteDb | Resource::SchemaCheck, addCommand},
+		tike::Command{"list", Resource::None, listCommand},
+		tike::Command{"list-all", Resource::None, listAllCommand},
+		tike::Command{"remove", Resource::WriteDb | Resource::SchemaCheck, removeCommand},
+		tike::Command{"complete", Resource::WriteDb | Resource::SchemaCheck, completeCommand},
+		tike::Command{"block", Resource::WriteDb | Resource::SchemaCheck, blockCommand},
+		tike::Command{"unblock", Resource::WriteDb | Resource::SchemaCheck, unblockCommand},
+		tike::Command{"next", Resource::ReadDb | Resource::SchemaCheck, nextCommand},
+		tike::Command{"critical-path", Resource::ReadDb | Resource::SchemaCheck, criticalPathCommand},
+		tike::Command{"move", Resource::WriteDb | Resource::SchemaCheck, moveCommand},
+		tike::Command{"subtree", Resource::ReadDb | Resource::SchemaCheck, subtreeCommand},
+		tike::Command{"list-completed", Resource::ReadDb | Resource::SchemaCheck, listCompletedCommand},
+		tike::Command{"list-all-completed", Resource::ReadDb | Resource::SchemaCheck, listAllCompletedCommand},
+		tike::Command{"export", Resource::ReadDb | Resource::SchemaCheck, exportCommand},
+		tike::Command{"summary", Resource::ReadDb | Resource::SchemaCheck, summaryCommand},
+		tike::Command{"lead-time", Resource::WriteDb | Resource::SchemaCheck, leadTimeCommand},
+		tike::Command{"start", Resource::WriteDb | Resource::SchemaCheck, startCommand},
+		tike::Command{"stop", Resource::WriteDb | Resource::SchemaCheck, stopCommand},
+		tike::Command{"stop-repeating", Resource::WriteDb | Resource::SchemaCheck, stopRepeatingCommand},
+		tike::Command{"time-log", Resource::ReadDb | Resource::SchemaCheck, timeLogCommand},
+		tike::Command{"time-total", Resource::ReadDb | Resource::SchemaCheck, timeTotalCommand},
+		tike::Command{"weight", Resource::WriteDb | Resource::SchemaCheck, weightCommand},
+		tike::Command{"serve", Resource::None, serveCommand},
+		tike::Command{"watch", Resource::None, watchCommand},
+		tike::Command{"ui", Resource::None, uiCommand},
+		tike::Command{"http", Resource::None, httpCommand},
+		tike::Command{"tune", Resource::None, tuneCommand},
+	};
+
+	static_assert(std::ranges::all_of(commands, [](const tike::Command &command) {
+		return tike::argTable.find(command.option) >= 0;
+	}), "Every command has to be selected by an option in argTable");
+}
+
+const tike::Command &tike::findCommand(const ArgParser &parser) {
+	for (const auto &command: commands) {
+		if (parser.argHasValue(command.option)) {
+			return command;
+		}
+	}
+	return commands.front();
+}
+
+void tike::ensureSchema(const db::Database &db) {
+	for (const auto &[name, columns]: schema()) {
+		db.createTable(name, columns);
+	}
+
+	// Databases from before tracked time don't remember the id a completed task had
+	if (!db.hasColumn("completedTasks", "taskId")) {
+		db.execute("ALTER TABLE completedTasks ADD COLUMN taskId INTEGER");
+	}
+	db.execute("CREATE INDEX IF NOT EXISTS completedTasksTaskId ON completedTasks (taskId)");
+
+	ensureStatistics(db);
+	ensureLeadTime(db);
+	ensureTimeTracking(db);
+	ensureTags(db);
+	ensureSubtasks(db);
+	ensureDependencies(db);
+	ensureUrgency(db);
+	ensureDueDates(db);
+	ensureRecurrences(db);
+}
+
+void tike::checkSchema(const db::Database &db) {
+	for (const auto &table: schema()) {
+		if (!db.hasTable(table.name)) {
+			throw std::runtime_error("Database is missing the table: " + table.name);
+		}
+	}
+}
+
+int tike::runWriteCommand(const Command &command, CommandContext &context) {
+	return runWriteCommand(std::function(command.run), context);
+}
+
+int tike::runWriteCommand(const std::function<int(CommandContext &)> &run, CommandContext &context) {
+	const db::Database &db = *context.db;
+	const db::CounterCache cache(context.dbPath);
+
+	db::Transaction transaction(db);
+
+	// No other connection can commit while the write lock is held, so these are the counts the command starts from
+	const std::int64_t dataVersion = db.dataVersion();
+	std::optional<db::TaskCounts> counts = cache.load();
+	if (!counts) {
+		counts = readTaskCounts(db);
+	}
+
+	const int result = run(context);
+	syncTagBitmaps(db);
+	transaction.commit();
+
+	// Stamp first, then make sure no other connection committed since ours. If one did, leave the sidecar stale
+	const std::optional<db::StorageStamp> stamp = db::StorageStamp::of(context.dbPath);
+	if (stamp && db.dataVersion() == dataVersion) {
+		counts->open += context.countDelta.open;
+		counts->completed += context.countDelta.completed;
+		cache.store(*counts, *stamp);
+
+		// Like the counters, a snapshot that can't be written is left stale and listings read the database
+		if (counts->open <= snapshotTaskLimit) {
+			try {
+				storeTaskSnapshot(db, context.dbPath, *stamp);
+			} catch (const std::runtime_error &) {
+			}
+		}
+	}
+	return result;
+}
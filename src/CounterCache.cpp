@@ -0,0 +1,111 @@
+#include "CounterCache.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstdio>
+
+namespace {
+	// "TKCT", followed by a layout version so a future change can't be misread
+	constexpr std::uint32_t sidecarMagic = 0x54434B54;
+	constexpr std::uint32_t sidecarVersion = 1;
+
+	struct SidecarData {
+		std::uint32_t magic;
+		std::uint32_t version;
+		db::StorageStamp stamp;
+		db::TaskCounts counts;
+	};
+
+#ifndef _WIN32
+	std::int64_t modifiedNs(const struct stat &info) {
+		return static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+	}
+#endif
+}
+
+std::optional<db::StorageStamp> db::StorageStamp::of(const std::string &dbPath) {
+#ifdef _WIN32
+	return std::nullopt;
+#else
+	const int fd = ::open(dbPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return std::nullopt;
+	}
+
+	StorageStamp stamp;
+	struct stat info{};
+	if (::fstat(fd, &info) == 0) {
+		stamp.dbSize = info.st_size;
+		stamp.dbModified = modifiedNs(info);
+	}
+
+	// The file change counter is a big-endian 32-bit integer at offset 24 of the database header
+	unsigned char counter[4] = {};
+	if (::pread(fd, counter, sizeof(counter), 24) == sizeof(counter)) {
+		stamp.changeCounter = static_cast<std::uint32_t>(counter[0]) << 24 | counter[1] << 16 | counter[2] << 8 |
+		                      counter[3];
+	}
+	::close(fd);
+
+	// The WAL file only exists in WAL mode, commits there don't touch the database file
+	if (::stat((dbPath + "-wal").c_str(), &info) == 0) {
+		stamp.walSize = info.st_size;
+		stamp.walModified = modifiedNs(info);
+	}
+	return stamp;
+#endif
+}
+
+std::optional<db::TaskCounts> db::CounterCache::load() const {
+#ifdef _WIN32
+	return std::nullopt;
+#else
+	const int fd = ::open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return std::nullopt;
+	}
+
+	struct stat info{};
+	if (::fstat(fd, &info) != 0 || info.st_size != sizeof(SidecarData)) {
+		::close(fd);
+		return std::nullopt;
+	}
+
+	void *mapping = ::mmap(nullptr, sizeof(SidecarData), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		return std::nullopt;
+	}
+	const auto *data = static_cast<const SidecarData *>(mapping);
+
+	std::optional<TaskCounts> counts;
+	if (data->magic == sidecarMagic && data->version == sidecarVersion && StorageStamp::of(dbPath) == data->stamp) {
+		counts = data->counts;
+	}
+	::munmap(mapping, sizeof(SidecarData));
+	return counts;
+#endif
+}
+
+void db::CounterCache::store(const TaskCounts &counts, const StorageStamp &stamp) const {
+#ifndef _WIN32
+	const SidecarData data{sidecarMagic, sidecarVersion, stamp, counts};
+
+	// Write a temporary file first, renaming it over the sidecar is atomic
+	const std::string temporaryPath = cachePath + "." + std::to_string(::getpid());
+	const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return;
+	}
+	const bool written = ::write(fd, &data, sizeof(data)) == sizeof(data);
+	::close(fd);
+
+	if (!written || std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+	}
+#endif
+}
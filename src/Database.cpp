@@ -5,11 +5,137 @@
 #include <stdexcept>
 #include <ranges>
 
+db::Statement::Statement(sqlite3 *db, const std::string &sql) : db(db) {
+	if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+		throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+	}
+}
+
+db::Statement &db::Statement::bind(const int index, const Field &value) {
+	int rc;
+	if (std::holds_alternative<int>(value)) {
+		rc = sqlite3_bind_int(stmt, index, std::get<int>(value));
+	} else if (std::holds_alternative<double>(value)) {
+		rc = sqlite3_bind_double(stmt, index, std::get<double>(value));
+	} else {
+		const auto &text = std::get<std::string>(value);
+		rc = sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+	}
+	if (rc != SQLITE_OK) {
+		throw std::runtime_error("Failed to bind parameter: " + std::string(sqlite3_errmsg(db)));
+	}
+	return *this;
+}
+
+db::Statement &db::Statement::bindInt64(const int index, const std::int64_t value) {
+	if (sqlite3_bind_int64(stmt, index, value) != SQLITE_OK) {
+		throw std::runtime_error("Failed to bind parameter: " + std::string(sqlite3_errmsg(db)));
+	}
+	return *this;
+}
+
+db::Statement &db::Statement::bindBlob(const int index, const std::string_view bytes) {
+	if (sqlite3_bind_blob(stmt, index, bytes.data(), static_cast<int>(bytes.size()), SQLITE_TRANSIENT) != SQLITE_OK) {
+		throw std::runtime_error("Failed to bind parameter: " + std::string(sqlite3_errmsg(db)));
+	}
+	return *this;
+}
+
+db::Statement &db::Statement::bindNull(const int index) {
+	if (sqlite3_bind_null(stmt, index) != SQLITE_OK) {
+		throw std::runtime_error("Failed to bind parameter: " + std::string(sqlite3_errmsg(db)));
+	}
+	return *this;
+}
+
+bool db::Statement::step() {
+	const int rc = sqlite3_step(stmt);
+	if (rc == SQLITE_ROW) {
+		return true;
+	}
+	if (rc == SQLITE_DONE) {
+		return false;
+	}
+	throw std::runtime_error("Failed to execute statement: " + std::string(sqlite3_errmsg(db)));
+}
+
+void db::Statement::reset() {
+	sqlite3_reset(stmt);
+}
+
+int db::Statement::columnCount() const {
+	return sqlite3_column_count(stmt);
+}
+
+bool db::Statement::columnIsNull(const int column) const {
+	return sqlite3_column_type(stmt, column) == SQLITE_NULL;
+}
+
+int db::Statement::columnType(const int column) const {
+	return sqlite3_column_type(stmt, column);
+}
+
+std::int64_t db::Statement::columnInt64(const int column) const {
+	return sqlite3_column_int64(stmt, column);
+}
+
+double db::Statement::columnDouble(const int column) const {
+	return sqlite3_column_double(stmt, column);
+}
+
+std::string_view db::Statement::columnText(const int column) const {
+	const auto *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+	return text ? std::string_view(text, sqlite3_column_bytes(stmt, column)) : std::string_view();
+}
+
+std::string_view db::Statement::columnBlob(const int column) const {
+	const auto *bytes = static_cast<const char *>(sqlite3_column_blob(stmt, column));
+	return bytes ? std::string_view(bytes, sqlite3_column_bytes(stmt, column)) : std::string_view();
+}
+
 void db::Database::openDatabase() {
-	const int rc = sqlite3_open(db_path.c_str(), &db);
+	const int flags = mode == OpenMode::ReadOnly
+		                  ? SQLITE_OPEN_READONLY
+		                  : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+	const int rc = sqlite3_open_v2(db_path.c_str(), &db, flags, nullptr);
 	if (rc != SQLITE_OK) {
 		throw std::runtime_error(sqlite3_errmsg(db));
 	}
+	// Wait for other connections, like a running --serve, instead of failing while they hold the write lock
+	sqlite3_busy_timeout(db, 5000);
+	applyStoredSettings();
+}
+
+void db::Database::applyStoredSettings() const {
+	// Settings chosen by `tike --tune` that SQLite doesn't keep in the file itself. Most databases have none
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v2(db, "SELECT name, value FROM storageSettings", -1, &stmt, nullptr) != SQLITE_OK) {
+		return;
+	}
+	std::vector<std::string> pragmas;
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		const auto *name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+		const auto *value = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+		if (!name || !value) {
+			continue;
+		}
+		// Only known settings with plain values, the table is not a way to run arbitrary SQL
+		const std::string_view setting(value);
+		if (std::string_view(name) == "journal_mode" &&
+		    (setting == "DELETE" || setting == "TRUNCATE" || setting == "PERSIST" || setting == "WAL")) {
+			pragmas.push_back("PRAGMA journal_mode = " + std::string(setting));
+		} else if (std::string_view(name) == "synchronous" &&
+		           (setting == "OFF" || setting == "NORMAL" || setting == "FULL" || setting == "EXTRA")) {
+			pragmas.push_back("PRAGMA synchronous = " + std::string(setting));
+		} else if (std::string_view(name) == "mmap_size" && !setting.empty() &&
+		           setting.find_first_not_of("0123456789") == std::string_view::npos) {
+			pragmas.push_back("PRAGMA mmap_size = " + std::string(setting));
+		}
+	}
+	sqlite3_finalize(stmt);
+	for (const std::string &pragma: pragmas) {
+		sqlite3_exec(db, pragma.c_str(), nullptr, nullptr, nullptr);
+	}
 }
 
 void db::Database::closeDatabase() const {
@@ -80,6 +206,104 @@ void db::Database::createTable(const std::string &table, const std::vector<Colum
 	sqlite3_finalize(stmt);
 }
 
+bool db::Database::hasTable(const std::string &table) const {
+	const std::string query = "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?";
+
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+		throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+	}
+	sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_STATIC);
+
+	const bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+	sqlite3_finalize(stmt);
+	return exists;
+}
+
+bool db::Database::hasColumn(const std::string &table, const std::string &column) const {
+	Statement statement = prepare("SELECT 1 FROM pragma_table_info(?) WHERE name = ?");
+	statement.bind(1, table).bind(2, column);
+	return statement.step();
+}
+
+void db::Database::execute(const std::string &sql) const {
+	char *errorMessage = nullptr;
+	if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+		const std::string error = "Failed to execute statement: " +
+		                          std::string(errorMessage ? errorMessage : sqlite3_errmsg(db));
+		sqlite3_free(errorMessage);
+		throw std::runtime_error(error);
+	}
+}
+
+std::int64_t db::Database::countRecords(const std::string &table) const {
+	const std::string query = std::format("SELECT COUNT(*) FROM {}", table);
+
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+		throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+	}
+
+	if (sqlite3_step(stmt) != SQLITE_ROW) {
+		const std::string error = "Failed to execute statement: " + std::string(sqlite3_errmsg(db));
+		sqlite3_finalize(stmt);
+		throw std::runtime_error(error);
+	}
+
+	const std::int64_t count = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+	return count;
+}
+
+std::int64_t db::Database::dataVersion() const {
+	// Asked for on every wakeup of the resident modes, so the statement is only prepared once
+	Statement &statement = prepareCached("PRAGMA data_version");
+	statement.step();
+	const std::int64_t version = statement.columnInt64(0);
+	statement.reset();
+	return version;
+}
+
+std::int64_t db::Database::lastInsertId() const {
+	return sqlite3_last_insert_rowid(db);
+}
+
+std::int64_t db::Database::totalChanges() const {
+	return sqlite3_total_changes64(db);
+}
+
+bool db::Database::inTransaction() const {
+	return sqlite3_get_autocommit(db) == 0;
+}
+
+void db::Database::interrupt() const {
+	sqlite3_interrupt(db);
+}
+
+void db::Database::setUpdateHook(std::function<void()> hook) const {
+	updateHook = std::move(hook);
+	if (!updateHook) {
+		sqlite3_update_hook(db, nullptr, nullptr);
+		return;
+	}
+	sqlite3_update_hook(db, [](void *context, int, const char *, const char *, sqlite3_int64) {
+		(*static_cast<std::function<void()> *>(context))();
+	}, &updateHook);
+}
+
+db::Statement db::Database::prepare(const std::string &sql) const {
+	return Statement(db, sql);
+}
+
+db::Statement &db::Database::prepareCached(const std::string &sql) const {
+	auto found = statementCache.find(sql);
+	if (found == statementCache.end()) {
+		found = statementCache.emplace(sql, prepare(sql)).first;
+	}
+	found->second.reset();
+	return found->second;
+}
+
 void db::Database::addRecord(const Record &record) const {
 	// Construct the SQL query
 	std::string columns;
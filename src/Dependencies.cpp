@@ -0,0 +1,180 @@
+#include "Dependencies.h"
+
+#include "DependencyCache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+tike::DependencyGraph tike::DependencyGraph::load(const db::Database &db) {
+	DependencyGraph graph;
+	db::Statement ids = db.prepare("SELECT id FROM tasks ORDER BY id");
+	while (ids.step()) {
+		graph.taskIds.push_back(ids.columnInt64(0));
+	}
+	graph.offsets.assign(graph.taskIds.size() + 1, 0);
+	graph.inDegree.assign(graph.taskIds.size(), 0);
+	if (!db.hasTable("taskDependencies")) {
+		return graph;
+	}
+
+	// Edges come ordered by the blocking task, so the rows of the CSR are filled one after the other
+	db::Statement edges = db.prepare("SELECT blockedBy, taskId FROM taskDependencies ORDER BY blockedBy, taskId");
+	Node filled = 0;
+	while (edges.step()) {
+		const std::optional<Node> from = graph.nodeOf(edges.columnInt64(0));
+		const std::optional<Node> to = graph.nodeOf(edges.columnInt64(1));
+		if (!from || !to) {
+			continue;
+		}
+		while (filled < *from) {
+			graph.offsets[++filled] = static_cast<std::uint32_t>(graph.targets.size());
+		}
+		graph.targets.push_back(*to);
+		graph.inDegree[*to]++;
+	}
+	while (filled < graph.taskIds.size()) {
+		graph.offsets[++filled] = static_cast<std::uint32_t>(graph.targets.size());
+	}
+	return graph;
+}
+
+std::optional<tike::DependencyGraph::Node> tike::DependencyGraph::nodeOf(const std::int64_t taskId) const {
+	const auto found = std::ranges::lower_bound(taskIds, taskId);
+	if (found == taskIds.end() || *found != taskId) {
+		return std::nullopt;
+	}
+	return static_cast<Node>(found - taskIds.begin());
+}
+
+bool tike::DependencyGraph::reaches(const Node from, const Node to) const {
+	std::vector<bool> seen(size());
+	std::vector<Node> stack = {from};
+	seen[from] = true;
+	while (!stack.empty()) {
+		const Node node = stack.back();
+		stack.pop_back();
+		if (node == to) {
+			return true;
+		}
+		for (std::uint32_t edge = offsets[node]; edge < offsets[node + 1]; edge++) {
+			if (!seen[targets[edge]]) {
+				seen[targets[edge]] = true;
+				stack.push_back(targets[edge]);
+			}
+		}
+	}
+	return false;
+}
+
+std::vector<tike::DependencyGraph::Node> tike::DependencyGraph::topologicalOrder() const {
+	std::vector<std::uint32_t> remaining = inDegree;
+	std::vector<Node> order;
+	order.reserve(size());
+	for (Node node = 0; node < size(); node++) {
+		if (remaining[node] == 0) {
+			order.push_back(node);
+		}
+	}
+
+	// order doubles as the queue, everything before `next` has been expanded
+	for (std::size_t next = 0; next < order.size(); next++) {
+		const Node node = order[next];
+		for (std::uint32_t edge = offsets[node]; edge < offsets[node + 1]; edge++) {
+			if (--remaining[targets[edge]] == 0) {
+				order.push_back(targets[edge]);
+			}
+		}
+	}
+	return order;
+}
+
+tike::DependencyAnalysis::DependencyAnalysis(DependencyGraph graph) {
+	const DependencyGraph &g = graph;
+	order = g.topologicalOrder();
+	for (DependencyGraph::Node node = 0; node < g.size(); node++) {
+		if (g.inDegree[node] == 0) {
+			ready.push_back(node);
+		}
+	}
+
+	// Longest chain ending at each node, in topological order every predecessor is final before its successors
+	std::vector<std::uint32_t> length(g.size(), 1);
+	std::vector<DependencyGraph::Node> previous(g.size(), static_cast<DependencyGraph::Node>(-1));
+	for (const DependencyGraph::Node node: order) {
+		for (std::uint32_t edge = g.offsets[node]; edge < g.offsets[node + 1]; edge++) {
+			const DependencyGraph::Node next = g.targets[edge];
+			if (length[node] + 1 > length[next]) {
+				length[next] = length[node] + 1;
+				previous[next] = node;
+			}
+		}
+	}
+	if (!order.empty()) {
+		DependencyGraph::Node last = order.front();
+		for (const DependencyGraph::Node node: order) {
+			if (length[node] > length[last]) {
+				last = node;
+			}
+		}
+		for (DependencyGraph::Node node = last; node != static_cast<DependencyGraph::Node>(-1); node = previous[node]) {
+			criticalPath.push_back(node);
+		}
+		std::ranges::reverse(criticalPath);
+	}
+	taskIds = std::move(graph.taskIds);
+}
+
+void tike::ensureDependencies(const db::Database &db) {
+	db.execute(R"(
+		CREATE TABLE IF NOT EXISTS taskDependencies (
+			taskId INTEGER NOT NULL,
+			blockedBy INTEGER NOT NULL,
+			PRIMARY KEY (taskId, blockedBy)
+		) WITHOUT ROWID;
+		CREATE INDEX IF NOT EXISTS taskDependenciesBlockedBy ON taskDependencies (blockedBy, taskId);
+	)");
+}
+
+tike::DependencyAnalysis tike::analyseDependencies(const db::Database &db, const std::string &dbPath) {
+	const DependencyCache cache(dbPath);
+	if (std::optional<DependencyAnalysis> cached = cache.load()) {
+		return std::move(*cached);
+	}
+
+	// The stamp is taken before reading, and the analysis only stored if nothing was written meanwhile
+	const std::optional<db::StorageStamp> before = db::StorageStamp::of(dbPath);
+	DependencyAnalysis analysis(DependencyGraph::load(db));
+	if (before && db::StorageStamp::of(dbPath) == before) {
+		cache.store(analysis, *before);
+	}
+	return analysis;
+}
+
+void tike::addDependency(const db::Database &db, const std::int64_t taskId, const std::int64_t blockerId) {
+	if (taskId == blockerId) {
+		throw std::invalid_argument("A task can't block itself");
+	}
+
+	const DependencyGraph graph = DependencyGraph::load(db);
+	const std::optional<DependencyGraph::Node> blocked = graph.nodeOf(taskId);
+	const std::optional<DependencyGraph::Node> blocker = graph.nodeOf(blockerId);
+	if (!blocked || !blocker) {
+		throw std::invalid_argument("Only open tasks can block each other");
+	}
+	// The new edge runs blocker -> blocked, it closes a cycle if the blocked task already leads to the blocker
+	if (graph.reaches(*blocked, *blocker)) {
+		throw std::invalid_argument("That would be a cycle, the blocking task already waits for this task");
+	}
+
+	db::Statement statement = db.prepare("INSERT OR IGNORE INTO taskDependencies (taskId, blockedBy) VALUES (?, ?)");
+	statement.bindInt64(1, taskId).bindInt64(2, blockerId);
+	statement.step();
+}
+
+bool tike::removeDependency(const db::Database &db, const std::int64_t taskId, const std::int64_t blockerId) {
+	const std::int64_t before = db.totalChanges();
+	db::Statement statement = db.prepare("DELETE FROM taskDependencies WHERE taskId = ? AND blockedBy = ?");
+	statement.bindInt64(1, taskId).bindInt64(2, blockerId);
+	statement.step();
+	return db.totalChanges() != before;
+}
@@ -0,0 +1,130 @@
+#include "DependencyCache.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	// "TKDP", followed by a layout version so a future change can't be misread
+	constexpr std::uint32_t cacheMagic = 0x50444B54;
+	constexpr std::uint32_t cacheVersion = 1;
+
+	struct CacheHeader {
+		std::uint32_t magic;
+		std::uint32_t version;
+		db::StorageStamp stamp;
+		std::uint64_t tasks;
+		std::uint64_t order;
+		std::uint64_t ready;
+		std::uint64_t criticalPath;
+	};
+
+	using Node = tike::DependencyGraph::Node;
+
+#ifndef _WIN32
+	bool writeAll(const int fd, const void *bytes, std::size_t size) {
+		const auto *next = static_cast<const char *>(bytes);
+		while (size > 0) {
+			const ssize_t written = ::write(fd, next, size);
+			if (written <= 0) {
+				return false;
+			}
+			next += written;
+			size -= static_cast<std::size_t>(written);
+		}
+		return true;
+	}
+
+	// Copies a list of nodes out of the mapping, false if one of them isn't a node of the graph
+	bool readNodes(const char *&next, const std::uint64_t count, const std::uint64_t tasks, std::vector<Node> &nodes) {
+		nodes.resize(count);
+		if (count > 0) {
+			std::memcpy(nodes.data(), next, count * sizeof(Node));
+		}
+		next += count * sizeof(Node);
+		return std::ranges::all_of(nodes, [&](const Node node) { return node < tasks; });
+	}
+#endif
+}
+
+std::optional<tike::DependencyAnalysis> tike::DependencyCache::load() const {
+#ifdef _WIN32
+	return std::nullopt;
+#else
+	const int fd = ::open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return std::nullopt;
+	}
+
+	struct stat info{};
+	if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(CacheHeader))) {
+		::close(fd);
+		return std::nullopt;
+	}
+
+	const auto size = static_cast<std::size_t>(info.st_size);
+	void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		return std::nullopt;
+	}
+	const auto *header = static_cast<const CacheHeader *>(mapping);
+
+	// The lists can't be longer than the graph, which also keeps the size computation from overflowing
+	const std::uint64_t tasks = header->tasks;
+	const bool fits = tasks <= size / sizeof(std::int64_t) && header->order <= tasks && header->ready <= tasks &&
+	                  header->criticalPath <= tasks &&
+	                  size == sizeof(CacheHeader) + tasks * sizeof(std::int64_t) +
+	                          (header->order + header->ready + header->criticalPath) * sizeof(Node);
+	std::optional<DependencyAnalysis> analysis;
+	if (header->magic == cacheMagic && header->version == cacheVersion && fits &&
+	    db::StorageStamp::of(dbPath) == header->stamp) {
+		const char *next = static_cast<const char *>(mapping) + sizeof(CacheHeader);
+		analysis.emplace();
+		analysis->taskIds.resize(tasks);
+		if (tasks > 0) {
+			std::memcpy(analysis->taskIds.data(), next, tasks * sizeof(std::int64_t));
+		}
+		next += tasks * sizeof(std::int64_t);
+		if (!readNodes(next, header->order, tasks, analysis->order) ||
+		    !readNodes(next, header->ready, tasks, analysis->ready) ||
+		    !readNodes(next, header->criticalPath, tasks, analysis->criticalPath)) {
+			analysis.reset();
+		}
+	}
+	::munmap(mapping, size);
+	return analysis;
+#endif
+}
+
+void tike::DependencyCache::store(const DependencyAnalysis &analysis, const db::StorageStamp &stamp) const {
+#ifndef _WIN32
+	const CacheHeader header{
+		cacheMagic, cacheVersion, stamp, analysis.taskIds.size(), analysis.order.size(), analysis.ready.size(),
+		analysis.criticalPath.size()
+	};
+
+	// Write a temporary file first, renaming it over the sidecar is atomic
+	const std::string temporaryPath = cachePath + "." + std::to_string(::getpid());
+	const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return;
+	}
+	const bool written = writeAll(fd, &header, sizeof(header)) &&
+	                     writeAll(fd, analysis.taskIds.data(), analysis.taskIds.size() * sizeof(std::int64_t)) &&
+	                     writeAll(fd, analysis.order.data(), analysis.order.size() * sizeof(Node)) &&
+	                     writeAll(fd, analysis.ready.data(), analysis.ready.size() * sizeof(Node)) &&
+	                     writeAll(fd, analysis.criticalPath.data(), analysis.criticalPath.size() * sizeof(Node));
+	::close(fd);
+
+	if (!written || std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+	}
+#endif
+}
@@ -0,0 +1,321 @@
+#include "Export.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	constexpr std::size_t rowsPerBatch = 4096;
+
+	struct ExportColumn {
+		std::string_view name;
+		db::ColumnType type;
+	};
+
+	using enum db::ColumnType;
+
+	constexpr std::array openColumns = {
+		ExportColumn{"id", Integer}, ExportColumn{"title", Text}, ExportColumn{"description", Text},
+		ExportColumn{"timeCreated", Timestamp}
+	};
+
+	constexpr std::array completedColumns = {
+		ExportColumn{"id", Integer}, ExportColumn{"title", Text}, ExportColumn{"description", Text},
+		ExportColumn{"timeCreated", Timestamp}, ExportColumn{"timeCompleted", Timestamp},
+		ExportColumn{"taskId", Integer}
+	};
+
+	/*
+	 * Rows as the reader copied them out of SQLite: every value of the batch in one buffer, row after row, with
+	 * the end offset of each value. One allocation per batch instead of one per value
+	 */
+	struct RowBatch {
+		std::uint64_t sequence = 0;
+		std::size_t rows = 0;
+		std::string values;
+		std::vector<std::size_t> ends;
+		std::vector<char> nulls;
+	};
+
+	// Everything the stages share, guarded by mutex
+	struct Pipeline {
+		std::mutex mutex;
+		std::condition_variable batchRead;
+		std::condition_variable batchFormatted;
+		std::condition_variable batchWritten;
+		std::deque<RowBatch> unformatted;
+		std::map<std::uint64_t, std::string> unwritten;
+		std::size_t inFlight = 0; // Read but not written yet
+		std::uint64_t batchesRead = 0;
+		bool readingDone = false;
+		std::exception_ptr error;
+
+		// Stops every stage, keeping the first error
+		void fail(std::exception_ptr exception) {
+			std::lock_guard lock(mutex);
+			if (!error) {
+				error = std::move(exception);
+			}
+			batchRead.notify_all();
+			batchFormatted.notify_all();
+			batchWritten.notify_all();
+		}
+	};
+
+	void appendCsvField(std::string &out, const std::string_view text) {
+		if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+			out += text;
+			return;
+		}
+		out += '"';
+		for (const char character: text) {
+			if (character == '"') {
+				out += '"';
+			}
+			out += character;
+		}
+		out += '"';
+	}
+
+	std::string formatBatch(const RowBatch &batch, const std::span<const ExportColumn> columns,
+	                        const tike::ExportFormat format) {
+		std::string out;
+		out.reserve(batch.values.size() + batch.rows * columns.size() * 16);
+		std::size_t value = 0;
+		std::size_t start = 0;
+		for (std::size_t row = 0; row < batch.rows; row++) {
+			if (format == tike::ExportFormat::Json) {
+				// Every row but the very first one of the export follows a comma
+				out += batch.sequence == 0 && row == 0 ? "\n  {" : ",\n  {";
+			}
+			for (std::size_t column = 0; column < columns.size(); column++, value++) {
+				const std::string_view text(batch.values.data() + start, batch.ends[value] - start);
+				start = batch.ends[value];
+				if (format == tike::ExportFormat::Json) {
+					if (column > 0) {
+						out += ", ";
+					}
+					out += '"';
+					out += columns[column].name;
+					out += "\": ";
+					if (batch.nulls[value]) {
+						out += "null";
+					} else if (columns[column].type == Integer) {
+						out += text;
+					} else {
+						tike::appendJsonString(out, text);
+					}
+				} else {
+					if (column > 0) {
+						out += ',';
+					}
+					appendCsvField(out, text);
+				}
+			}
+			out += format == tike::ExportFormat::Json ? "}" : "\n";
+		}
+		return out;
+	}
+
+	void formatLoop(Pipeline &pipeline, const std::span<const ExportColumn> columns, const tike::ExportFormat format) {
+		try {
+			std::unique_lock lock(pipeline.mutex);
+			for (;;) {
+				pipeline.batchRead.wait(lock, [&] {
+					return pipeline.error || !pipeline.unformatted.empty() || pipeline.readingDone;
+				});
+				if (pipeline.error || pipeline.unformatted.empty()) {
+					return;
+				}
+				const RowBatch batch = std::move(pipeline.unformatted.front());
+				pipeline.unformatted.pop_front();
+
+				lock.unlock();
+				std::string text = formatBatch(batch, columns, format);
+				lock.lock();
+
+				pipeline.unwritten.emplace(batch.sequence, std::move(text));
+				pipeline.batchFormatted.notify_all();
+			}
+		} catch (...) {
+			pipeline.fail(std::current_exception());
+		}
+	}
+
+	void writeLoop(Pipeline &pipeline, tike::OutputSink &out) {
+		try {
+			std::unique_lock lock(pipeline.mutex);
+			for (std::uint64_t next = 0;; next++) {
+				pipeline.batchFormatted.wait(lock, [&] {
+					return pipeline.error || pipeline.unwritten.contains(next) ||
+					       (pipeline.readingDone && next == pipeline.batchesRead);
+				});
+				if (pipeline.error || !pipeline.unwritten.contains(next)) {
+					return;
+				}
+				const std::string text = std::move(pipeline.unwritten.extract(next).mapped());
+
+				lock.unlock();
+				out.write(text);
+				lock.lock();
+
+				pipeline.inFlight--;
+				pipeline.batchWritten.notify_one();
+			}
+		} catch (...) {
+			pipeline.fail(std::current_exception());
+		}
+	}
+}
+
+void tike::appendJsonString(std::string &out, const std::string_view text) {
+	constexpr char hex[] = "0123456789abcdef";
+	out += '"';
+	std::size_t plain = 0;
+	for (std::size_t index = 0; index < text.size(); index++) {
+		const auto byte = static_cast<unsigned char>(text[index]);
+		if (byte >= 0x20 && byte != '"' && byte != '\\') {
+			continue;
+		}
+		// Copy the run of characters that need no escaping at once
+		out.append(text, plain, index - plain);
+		plain = index + 1;
+		switch (byte) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				out += "\\u00";
+				out += hex[byte >> 4];
+				out += hex[byte & 0xF];
+		}
+	}
+	out.append(text, plain);
+	out += '"';
+}
+
+tike::ExportFormat tike::parseExportFormat(const std::string_view text) {
+	if (text == "json") {
+		return ExportFormat::Json;
+	}
+	if (text == "csv") {
+		return ExportFormat::Csv;
+	}
+	if (text == "tkc") {
+		return ExportFormat::Tkc;
+	}
+	throw std::invalid_argument("Unknown export format: " + std::string(text) + " (use json, csv or tkc)");
+}
+
+std::int64_t tike::exportTasks(const db::Database &db, const bool completed, const ExportFormat format,
+                               OutputSink &out, unsigned formatters) {
+	const std::span<const ExportColumn> columns = completed
+		                                              ? std::span<const ExportColumn>(completedColumns)
+		                                              : std::span<const ExportColumn>(openColumns);
+	std::string sql = "SELECT ";
+	for (const ExportColumn &column: columns) {
+		// tkc stores timestamps as numbers, the text formats keep SQLite's text
+		sql += format == ExportFormat::Tkc && column.type == Timestamp
+			       ? "unixepoch(" + std::string(column.name) + ")"
+			       : std::string(column.name);
+		sql += &column == &columns.back() ? "" : ", ";
+	}
+	sql += completed ? " FROM completedTasks ORDER BY id" : " FROM tasks ORDER BY id";
+	db::Statement select = db.prepare(sql);
+
+	// Columnar encoding is cheap next to stepping the query, so tkc is written straight from the cursor
+	if (format == ExportFormat::Tkc) {
+		std::vector<db::ColumnInfo> info;
+		for (const ExportColumn &column: columns) {
+			info.push_back(db::ColumnInfo{std::string(column.name), column.type});
+		}
+		return db::writeColumnFile(select, info, [&](const std::string_view bytes) { out.write(bytes); });
+	}
+
+	if (formatters == 0) {
+		formatters = std::max(std::thread::hardware_concurrency(), 3u) - 2;
+	}
+	// Enough batches in flight to keep every formatter busy while the writer waits for the oldest one
+	const std::size_t maxInFlight = 4 * formatters;
+
+	if (format == ExportFormat::Json) {
+		out.write("[");
+	} else {
+		for (const ExportColumn &column: columns) {
+			out.write(column.name);
+			out.write(&column == &columns.back() ? "\n" : ",");
+		}
+	}
+
+	Pipeline pipeline;
+	std::vector<std::thread> threads;
+	threads.emplace_back(writeLoop, std::ref(pipeline), std::ref(out));
+	for (unsigned index = 0; index < formatters; index++) {
+		threads.emplace_back(formatLoop, std::ref(pipeline), columns, format);
+	}
+
+	// The calling thread is the reader, it owns the connection
+	std::int64_t rows = 0;
+	try {
+		for (bool more = true; more;) {
+			RowBatch batch;
+			batch.ends.reserve(rowsPerBatch * columns.size());
+			batch.nulls.reserve(rowsPerBatch * columns.size());
+			while (batch.rows < rowsPerBatch && (more = select.step())) {
+				for (int column = 0; column < static_cast<int>(columns.size()); column++) {
+					// Check for NULL first, the type of a value is undefined once it was read as text
+					batch.nulls.push_back(select.columnIsNull(column));
+					batch.values += select.columnText(column);
+					batch.ends.push_back(batch.values.size());
+				}
+				batch.rows++;
+			}
+			if (batch.rows == 0) {
+				break;
+			}
+			rows += static_cast<std::int64_t>(batch.rows);
+
+			std::unique_lock lock(pipeline.mutex);
+			pipeline.batchWritten.wait(lock, [&] { return pipeline.error || pipeline.inFlight < maxInFlight; });
+			if (pipeline.error) {
+				break;
+			}
+			batch.sequence = pipeline.batchesRead++;
+			pipeline.inFlight++;
+			pipeline.unformatted.push_back(std::move(batch));
+			pipeline.batchRead.notify_one();
+		}
+	} catch (...) {
+		pipeline.fail(std::current_exception());
+	}
+
+	{
+		std::lock_guard lock(pipeline.mutex);
+		pipeline.readingDone = true;
+	}
+	pipeline.batchRead.notify_all();
+	pipeline.batchFormatted.notify_all();
+	for (std::thread &thread: threads) {
+		thread.join();
+	}
+	select.reset();
+	if (pipeline.error) {
+		std::rethrow_exception(pipeline.error);
+	}
+
+	if (format == ExportFormat::Json) {
+		out.write(rows > 0 ? "\n]\n" : "]\n");
+	}
+	return rows;
+}
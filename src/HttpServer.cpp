@@ -0,0 +1,1233 @@
+#include "HttpServer.h"
+
+#include "Database.h"
+#include "Export.h"
+#include "QueryCache.h"
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+	constexpr std::size_t maxHeaderBytes = 16 * 1024;
+	constexpr std::size_t maxBodyBytes = 1024 * 1024;
+	// Task lists go out in chunks of about this size, and a reader waits while this many are still unsent
+	constexpr std::size_t chunkBytes = 64 * 1024;
+	constexpr std::size_t maxQueuedChunks = 4;
+	// Rows a task list reads at a time, pages that fit a chunk are kept in the query cache
+	constexpr std::int64_t pageRows = 256;
+	constexpr auto idleTimeout = std::chrono::seconds(60);
+
+	// A failed request, answered with its status and {"error": message}
+	struct HttpError : std::runtime_error {
+		int status;
+		std::string allow; // The methods the path takes, for 405
+
+		HttpError(const int status, const std::string &message, std::string allow = "")
+			: std::runtime_error(message), status(status), allow(std::move(allow)) {
+		}
+	};
+
+	std::string_view reasonPhrase(const int status) {
+		switch (status) {
+			case 200: return "OK";
+			case 201: return "Created";
+			case 400: return "Bad Request";
+			case 404: return "Not Found";
+			case 405: return "Method Not Allowed";
+			case 413: return "Content Too Large";
+			case 431: return "Request Header Fields Too Large";
+			case 501: return "Not Implemented";
+			case 505: return "HTTP Version Not Supported";
+			default: return "Internal Server Error";
+		}
+	}
+
+	struct Request {
+		std::string method;
+		std::string path;
+		std::map<std::string, std::string, std::less<>> query;
+		std::string body;
+		bool keepAlive = true;
+	};
+
+	std::optional<std::int64_t> parseInteger(const std::string_view text) {
+		std::int64_t value = 0;
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc() || end != text.data() + text.size() || text.empty()) {
+			return std::nullopt;
+		}
+		return value;
+	}
+
+	std::string lowercase(std::string_view text) {
+		std::string lower(text);
+		std::ranges::transform(lower, lower.begin(), [](const unsigned char character) {
+			return static_cast<char>(std::tolower(character));
+		});
+		return lower;
+	}
+
+	// Decodes %XX and '+' in a query string, malformed escapes are kept as they are
+	std::string percentDecode(const std::string_view text) {
+		std::string decoded;
+		decoded.reserve(text.size());
+		for (std::size_t index = 0; index < text.size(); index++) {
+			if (text[index] == '+') {
+				decoded += ' ';
+			} else if (text[index] == '%' && index + 2 < text.size() &&
+			           std::isxdigit(static_cast<unsigned char>(text[index + 1])) &&
+			           std::isxdigit(static_cast<unsigned char>(text[index + 2]))) {
+				unsigned value = 0;
+				std::from_chars(text.data() + index + 1, text.data() + index + 3, value, 16);
+				decoded += static_cast<char>(value);
+				index += 2;
+			} else {
+				decoded += text[index];
+			}
+		}
+		return decoded;
+	}
+
+	/*
+	 * Takes one request off the front of the input, or returns std::nullopt until all of it has arrived.
+	 * Errors mean the framing can't be trusted anymore, the connection is closed after answering them
+	 */
+	std::optional<Request> parseRequest(std::string &input) {
+		const std::size_t headerEnd = input.find("\r\n\r\n");
+		if (headerEnd == std::string::npos) {
+			if (input.size() > maxHeaderBytes) {
+				throw HttpError(431, "The request headers are too large");
+			}
+			return std::nullopt;
+		}
+		if (headerEnd > maxHeaderBytes) {
+			throw HttpError(431, "The request headers are too large");
+		}
+
+		const std::string_view head(input.data(), headerEnd);
+		const std::size_t lineEnd = std::min(head.find("\r\n"), head.size());
+		const std::string_view line = head.substr(0, lineEnd);
+		const std::size_t methodEnd = line.find(' ');
+		const std::size_t targetEnd = line.rfind(' ');
+		if (methodEnd == std::string_view::npos || targetEnd == methodEnd) {
+			throw HttpError(400, "Malformed request line");
+		}
+		const std::string_view target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+		const std::string_view version = line.substr(targetEnd + 1);
+		if (!version.starts_with("HTTP/1.")) {
+			throw HttpError(505, "Only HTTP/1.x is supported");
+		}
+
+		Request request;
+		request.method = line.substr(0, methodEnd);
+		request.keepAlive = version != "HTTP/1.0";
+
+		std::size_t contentLength = 0;
+		for (std::size_t start = lineEnd + 2; start < head.size();) {
+			const std::size_t end = std::min(head.find("\r\n", start), head.size());
+			const std::string_view field = head.substr(start, end - start);
+			start = end + 2;
+
+			const std::size_t colon = field.find(':');
+			if (colon == std::string_view::npos) {
+				throw HttpError(400, "Malformed header line");
+			}
+			const std::string name = lowercase(field.substr(0, colon));
+			std::string_view value = field.substr(colon + 1);
+			value.remove_prefix(std::min(value.find_first_not_of(" \t"), value.size()));
+			value.remove_suffix(value.size() - std::min(value.find_last_not_of(" \t") + 1, value.size()));
+
+			if (name == "content-length") {
+				const std::optional<std::int64_t> length = parseInteger(value);
+				if (!length || *length < 0) {
+					throw HttpError(400, "Invalid Content-Length");
+				}
+				if (static_cast<std::uint64_t>(*length) > maxBodyBytes) {
+					throw HttpError(413, "The request body is too large");
+				}
+				contentLength = static_cast<std::size_t>(*length);
+			} else if (name == "transfer-encoding") {
+				throw HttpError(501, "Request bodies have to be sent with Content-Length");
+			} else if (name == "connection") {
+				const std::string option = lowercase(value);
+				if (option.find("close") != std::string::npos) {
+					request.keepAlive = false;
+				} else if (option.find("keep-alive") != std::string::npos) {
+					request.keepAlive = true;
+				}
+			}
+		}
+
+		const std::size_t total = headerEnd + 4 + contentLength;
+		if (input.size() < total) {
+			return std::nullopt;
+		}
+
+		const std::size_t queryStart = std::min(target.find('?'), target.size());
+		request.path = target.substr(0, queryStart);
+		for (std::string_view query = target.substr(std::min(queryStart + 1, target.size())); !query.empty();) {
+			const std::size_t end = std::min(query.find('&'), query.size());
+			const std::string_view pair = query.substr(0, end);
+			query.remove_prefix(std::min(end + 1, query.size()));
+			const std::size_t equals = std::min(pair.find('='), pair.size());
+			request.query.insert_or_assign(percentDecode(pair.substr(0, equals)),
+			                               percentDecode(pair.substr(std::min(equals + 1, pair.size()))));
+		}
+		request.body = input.substr(headerEnd + 4, contentLength);
+		input.erase(0, total);
+		return request;
+	}
+
+	enum class Route {
+		Stats,
+		List,
+		Get,
+		Add,
+		Complete,
+		Remove
+	};
+
+	struct Target {
+		Route route;
+		std::int64_t taskId = 0;
+	};
+
+	Target route(const Request &request) {
+		std::string_view path = request.path;
+		const std::string_view method = request.method;
+		if (path == "/stats") {
+			if (method != "GET") {
+				throw HttpError(405, "Use GET on /stats", "GET");
+			}
+			return {Route::Stats};
+		}
+		if (path == "/tasks" || path == "/tasks/") {
+			if (method == "GET") {
+				return {Route::List};
+			}
+			if (method == "POST") {
+				return {Route::Add};
+			}
+			throw HttpError(405, "Use GET or POST on /tasks", "GET, POST");
+		}
+
+		const std::string notFound = "No such endpoint: " + request.path;
+		if (!path.starts_with("/tasks/")) {
+			throw HttpError(404, notFound);
+		}
+		path.remove_prefix(std::string_view("/tasks/").size());
+		const bool complete = path.ends_with("/complete");
+		if (complete) {
+			path.remove_suffix(std::string_view("/complete").size());
+		}
+		const std::optional<std::int64_t> taskId = parseInteger(path);
+		if (!taskId) {
+			throw HttpError(404, notFound);
+		}
+
+		if (complete) {
+			if (method != "POST") {
+				throw HttpError(405, "Use POST to complete a task", "POST");
+			}
+			return {Route::Complete, *taskId};
+		}
+		if (method == "GET") {
+			return {Route::Get, *taskId};
+		}
+		if (method == "DELETE") {
+			return {Route::Remove, *taskId};
+		}
+		throw HttpError(405, "Use GET or DELETE on a task", "GET, DELETE");
+	}
+
+	// Just enough JSON for the body of POST /tasks: an object whose values are strings or null
+	class BodyReader {
+	public:
+		explicit BodyReader(const std::string_view text) : text(text) {
+		}
+
+		tike::NewTask newTask() {
+			tike::NewTask task;
+			bool hasTitle = false;
+			expect('{');
+			if (!consume('}')) {
+				do {
+					const std::string key = string();
+					expect(':');
+					std::optional<std::string> value;
+					if (!literal("null")) {
+						value = string();
+					}
+					if (key == "title" && value) {
+						task.title = std::move(*value);
+						hasTitle = true;
+					} else if (key == "description") {
+						task.description = std::move(value);
+					}
+				} while (consume(','));
+				expect('}');
+			}
+			skipSpace();
+			if (position != text.size()) {
+				throw HttpError(400, "Unexpected text after the JSON object");
+			}
+			if (!hasTitle || task.title.empty()) {
+				throw HttpError(400, "A task needs a \"title\"");
+			}
+			return task;
+		}
+
+	private:
+		std::string_view text;
+		std::size_t position = 0;
+
+		void skipSpace() {
+			while (position < text.size() && std::string_view(" \t\r\n").find(text[position]) != std::string_view::npos) {
+				position++;
+			}
+		}
+
+		bool consume(const char character) {
+			skipSpace();
+			if (position < text.size() && text[position] == character) {
+				position++;
+				return true;
+			}
+			return false;
+		}
+
+		void expect(const char character) {
+			if (!consume(character)) {
+				throw HttpError(400, std::string("Invalid JSON, expected '") + character + "'");
+			}
+		}
+
+		bool literal(const std::string_view word) {
+			skipSpace();
+			if (text.substr(position).starts_with(word)) {
+				position += word.size();
+				return true;
+			}
+			return false;
+		}
+
+		std::uint32_t hexQuad() {
+			std::uint32_t value = 0;
+			const auto [end, error] = std::from_chars(text.data() + position,
+			                                          text.data() + std::min(position + 4, text.size()), value, 16);
+			if (error != std::errc() || end != text.data() + position + 4) {
+				throw HttpError(400, "Invalid JSON, bad \\u escape");
+			}
+			position += 4;
+			return value;
+		}
+
+		void appendUtf8(std::string &out, const std::uint32_t code) {
+			if (code < 0x80) {
+				out += static_cast<char>(code);
+			} else if (code < 0x800) {
+				out += static_cast<char>(0xC0 | code >> 6);
+				out += static_cast<char>(0x80 | (code & 0x3F));
+			} else if (code < 0x10000) {
+				out += static_cast<char>(0xE0 | code >> 12);
+				out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+				out += static_cast<char>(0x80 | (code & 0x3F));
+			} else {
+				out += static_cast<char>(0xF0 | code >> 18);
+				out += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+				out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+				out += static_cast<char>(0x80 | (code & 0x3F));
+			}
+		}
+
+		std::string string() {
+			if (!consume('"')) {
+				throw HttpError(400, "Invalid JSON, only strings and null are accepted as values");
+			}
+			std::string out;
+			while (position < text.size() && text[position] != '"') {
+				const char character = text[position++];
+				if (static_cast<unsigned char>(character) < 0x20) {
+					throw HttpError(400, "Invalid JSON, control character in a string");
+				}
+				if (character != '\\') {
+					out += character;
+					continue;
+				}
+				if (position == text.size()) {
+					break;
+				}
+				switch (text[position++]) {
+					case '"': out += '"'; break;
+					case '\\': out += '\\'; break;
+					case '/': out += '/'; break;
+					case 'b': out += '\b'; break;
+					case 'f': out += '\f'; break;
+					case 'n': out += '\n'; break;
+					case 'r': out += '\r'; break;
+					case 't': out += '\t'; break;
+					case 'u': {
+						std::uint32_t code = hexQuad();
+						// Characters outside the BMP come as a surrogate pair
+						if (code >= 0xD800 && code < 0xDC00 && text.substr(position).starts_with("\\u")) {
+							position += 2;
+							const std::uint32_t low = hexQuad();
+							if (low < 0xDC00 || low >= 0xE000) {
+								throw HttpError(400, "Invalid JSON, unpaired surrogate");
+							}
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						} else if (code >= 0xD800 && code < 0xE000) {
+							throw HttpError(400, "Invalid JSON, unpaired surrogate");
+						}
+						appendUtf8(out, code);
+						break;
+					}
+					default:
+						throw HttpError(400, "Invalid JSON, unknown escape");
+				}
+			}
+			if (position == text.size()) {
+				throw HttpError(400, "Invalid JSON, unterminated string");
+			}
+			position++;
+			return out;
+		}
+	};
+
+#ifdef __linux__
+	// Tells the event loop which connections have output waiting, through an eventfd it polls with the sockets
+	class Wakeup {
+	public:
+		Wakeup() : fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+			if (fd < 0) {
+				throw std::runtime_error(std::string("Failed to create an eventfd: ") + std::strerror(errno));
+			}
+		}
+
+		~Wakeup() {
+			::close(fd);
+		}
+
+		Wakeup(const Wakeup &) = delete;
+
+		Wakeup &operator=(const Wakeup &) = delete;
+
+		[[nodiscard]] int descriptor() const { return fd; }
+
+		void notify(const std::uint64_t connection) {
+			{
+				std::lock_guard lock(mutex);
+				ready.push_back(connection);
+			}
+			constexpr std::uint64_t one = 1;
+			[[maybe_unused]] const ssize_t written = ::write(fd, &one, sizeof(one));
+		}
+
+		std::vector<std::uint64_t> take() {
+			std::uint64_t count = 0;
+			[[maybe_unused]] const ssize_t read = ::read(fd, &count, sizeof(count));
+			std::lock_guard lock(mutex);
+			return std::exchange(ready, {});
+		}
+
+	private:
+		int fd;
+		std::mutex mutex;
+		std::vector<std::uint64_t> ready;
+	};
+
+	/*
+	 * The output of one response. A worker thread pushes it piece by piece, the event loop takes the pieces
+	 * whenever the socket has room. The worker waits while too much is unsent, and stops once the connection is gone
+	 */
+	class ResponseStream {
+	public:
+		ResponseStream(Wakeup &wakeup, const std::uint64_t connection, const bool keepAlive)
+			: wakeup(wakeup), connection(connection), keepAliveRequested(keepAlive) {
+		}
+
+		// Queues bytes, false if the connection was closed and the response should be given up
+		bool push(std::string bytes) {
+			{
+				std::unique_lock lock(mutex);
+				space.wait(lock, [this] { return abandoned || chunks.size() < maxQueuedChunks; });
+				if (abandoned) {
+					return false;
+				}
+				chunks.push_back(std::move(bytes));
+				started = true;
+			}
+			wakeup.notify(connection);
+			return true;
+		}
+
+		// Marks the response complete. With close the connection ends after it, e.g. when a stream broke off
+		void finish(const bool close = false) {
+			{
+				std::lock_guard lock(mutex);
+				finished = true;
+				closeAfter = closeAfter || close;
+			}
+			wakeup.notify(connection);
+		}
+
+		// Moves everything queued to out, true once the response is complete
+		bool take(std::string &out) {
+			bool complete;
+			{
+				std::lock_guard lock(mutex);
+				for (const std::string &chunk: chunks) {
+					out += chunk;
+				}
+				chunks.clear();
+				complete = finished;
+			}
+			space.notify_all();
+			return complete;
+		}
+
+		void abandon() {
+			{
+				std::lock_guard lock(mutex);
+				abandoned = true;
+			}
+			space.notify_all();
+		}
+
+		[[nodiscard]] bool hasStarted() {
+			std::lock_guard lock(mutex);
+			return started;
+		}
+
+		[[nodiscard]] bool keepAlive() {
+			std::lock_guard lock(mutex);
+			return keepAliveRequested && !closeAfter;
+		}
+
+	private:
+		Wakeup &wakeup;
+		std::uint64_t connection;
+		bool keepAliveRequested;
+
+		std::mutex mutex;
+		std::condition_variable space;
+		std::deque<std::string> chunks;
+		bool started = false;
+		bool finished = false;
+		bool closeAfter = false;
+		bool abandoned = false;
+	};
+
+	std::string statusLine(const int status) {
+		return "HTTP/1.1 " + std::to_string(status) + " " + std::string(reasonPhrase(status)) + "\r\n";
+	}
+
+	void respond(ResponseStream &stream, const int status, const std::string_view body,
+	             const std::string_view allow = "") {
+		const bool keepAlive = stream.keepAlive();
+		std::string out = statusLine(status);
+		out += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+		if (!allow.empty()) {
+			out += "Allow: " + std::string(allow) + "\r\n";
+		}
+		if (!keepAlive) {
+			out += "Connection: close\r\n";
+		}
+		out += "\r\n";
+		out += body;
+		stream.push(std::move(out));
+		stream.finish();
+	}
+
+	void respondError(ResponseStream &stream, const int status, const std::string_view message,
+	                  const std::string_view allow = "") {
+		// Once part of a streamed response is out, the status can't change anymore, only the connection can end
+		if (stream.hasStarted()) {
+			stream.finish(true);
+			return;
+		}
+		std::string body = "{\"error\":";
+		tike::appendJsonString(body, message);
+		body += "}";
+		respond(stream, status, body, allow);
+	}
+
+	// A response of unknown length, sent with chunked transfer encoding in pieces of about chunkBytes
+	class ChunkedBody {
+	public:
+		ChunkedBody(ResponseStream &stream, const int status) : stream(stream) {
+			head = statusLine(status) + "Content-Type: application/json\r\nTransfer-Encoding: chunked\r\n";
+			if (!stream.keepAlive()) {
+				head += "Connection: close\r\n";
+			}
+			head += "\r\n";
+		}
+
+		std::string &text() { return data; }
+
+		// Sends the text so far once it fills a chunk, false if the client went away
+		bool flushIfFull() {
+			return data.size() < chunkBytes || flush();
+		}
+
+		bool end() {
+			if (!data.empty() && !flush()) {
+				return false;
+			}
+			const bool sent = stream.push(std::exchange(head, {}) + "0\r\n\r\n");
+			stream.finish();
+			return sent;
+		}
+
+	private:
+		ResponseStream &stream;
+		std::string head; // Sent in front of the first chunk
+		std::string data;
+
+		bool flush() {
+			char size[17];
+			const auto end = std::to_chars(size, size + sizeof(size), data.size(), 16).ptr;
+			std::string out = std::exchange(head, {});
+			out.reserve(out.size() + data.size() + 32);
+			out.append(size, end);
+			out += "\r\n";
+			out += data;
+			out += "\r\n";
+			data.clear();
+			return stream.push(std::move(out));
+		}
+	};
+
+	constexpr std::string_view listQuery = R"(
+		SELECT id, title, description, timeCreated FROM tasks
+		WHERE id > ?1 AND (?2 = '' OR instr(lower(title), lower(?2)) > 0)
+		ORDER BY id LIMIT ?3
+	)";
+	constexpr std::string_view taskQuery = "SELECT id, title, description, timeCreated FROM tasks WHERE id = ?1";
+
+	// A read-only connection, with the results of repeated requests kept until the database changes
+	struct Reader {
+		db::Database db;
+		db::QueryCache cache;
+
+		explicit Reader(const std::string &dbPath) : db(dbPath, db::OpenMode::ReadOnly), cache(db) {
+		}
+	};
+
+	void appendText(std::string &out, const db::Value &value) {
+		if (const auto *text = std::get_if<std::string>(&value)) {
+			tike::appendJsonString(out, *text);
+		} else if (const auto *integer = std::get_if<std::int64_t>(&value)) {
+			out += std::to_string(*integer);
+		} else {
+			out += "null";
+		}
+	}
+
+	// One row of the task queries as a JSON object
+	void appendTask(std::string &out, const std::span<const db::Value> row) {
+		out += "{\"id\":";
+		out += std::to_string(std::get<std::int64_t>(row[0]));
+		out += ",\"title\":";
+		appendText(out, row[1]);
+		out += ",\"description\":";
+		appendText(out, row[2]);
+		out += ",\"timeCreated\":";
+		appendText(out, row[3]);
+		out += "}";
+	}
+
+	struct Job {
+		Request request;
+		Target target;
+		std::shared_ptr<ResponseStream> stream;
+	};
+
+	// Jobs waiting for one group of threads, the readers or the writer
+	class JobQueue {
+	public:
+		void push(Job job) {
+			{
+				std::lock_guard lock(mutex);
+				jobs.push_back(std::move(job));
+			}
+			ready.notify_one();
+		}
+
+		// Waits for the next job, std::nullopt once the queue is closed
+		std::optional<Job> pop() {
+			std::unique_lock lock(mutex);
+			ready.wait(lock, [this] { return closed || !jobs.empty(); });
+			if (closed) {
+				return std::nullopt;
+			}
+			Job job = std::move(jobs.front());
+			jobs.pop_front();
+			return job;
+		}
+
+		void close() {
+			{
+				std::lock_guard lock(mutex);
+				closed = true;
+			}
+			ready.notify_all();
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<Job> jobs;
+		bool closed = false;
+	};
+
+	// Turns whatever a job throws into an error response
+	void runJob(const Job &job, const std::function<void()> &run) {
+		try {
+			run();
+		} catch (const HttpError &error) {
+			respondError(*job.stream, error.status, error.what(), error.allow);
+		} catch (const std::invalid_argument &error) {
+			respondError(*job.stream, 400, error.what());
+		} catch (const std::exception &error) {
+			respondError(*job.stream, 500, error.what());
+		}
+	}
+
+	std::int64_t queryInteger(const Request &request, const std::string_view name, const std::int64_t fallback) {
+		const auto found = request.query.find(name);
+		if (found == request.query.end()) {
+			return fallback;
+		}
+		const std::optional<std::int64_t> value = parseInteger(found->second);
+		if (!value || *value < 0) {
+			throw HttpError(400, "?" + std::string(name) + " takes a non-negative integer");
+		}
+		return *value;
+	}
+
+	/*
+	 * Streams the rows of the list query a page at a time. A page ends after pageRows rows or once a chunk is full,
+	 * and the statement is reset before the chunk is sent. Sending waits while the client is slow, and a cursor
+	 * still open meanwhile would keep the read lock, so every write would wait for the slowest client. The next
+	 * page starts after the last id sent, so commits in between don't repeat or skip rows
+	 */
+	void listTasks(Reader &reader, const Job &job) {
+		const Request &request = job.request;
+		const auto search = request.query.find("search");
+		const std::string text = search == request.query.end() ? std::string() : search->second;
+		std::int64_t after = queryInteger(request, "after", 0);
+		std::int64_t remaining = queryInteger(request, "limit", -1);
+
+		ChunkedBody body(*job.stream, 200);
+		body.text() += '[';
+		bool first = true;
+		while (remaining != 0) {
+			const std::int64_t limit = remaining < 0 ? pageRows : std::min(remaining, pageRows);
+			const std::array<db::Value, 3> parameters = {after, text, limit};
+			std::int64_t rows = 0;
+			const bool wholePage = reader.cache.forEach(listQuery, parameters, [&](const std::span<const db::Value> row) {
+				if (!first) {
+					body.text() += ',';
+				}
+				first = false;
+				appendTask(body.text(), row);
+				after = std::get<std::int64_t>(row[0]);
+				rows++;
+				return body.text().size() < chunkBytes;
+			});
+			if (remaining > 0) {
+				remaining -= rows;
+			}
+			if (wholePage && rows < limit) {
+				break;
+			}
+			// Stopping means the client left halfway
+			if (!body.flushIfFull()) {
+				return;
+			}
+		}
+		body.text() += ']';
+		body.end();
+	}
+
+	void getTask(Reader &reader, const Job &job) {
+		const std::array<db::Value, 1> parameters = {job.target.taskId};
+		std::string body;
+		reader.cache.forEach(taskQuery, parameters, [&](const std::span<const db::Value> row) {
+			appendTask(body, row);
+			return true;
+		});
+		if (body.empty()) {
+			throw HttpError(404, "No open task with id " + std::to_string(job.target.taskId));
+		}
+		respond(*job.stream, 200, body);
+	}
+
+	void serveReads(Reader &reader, JobQueue &jobs) {
+		while (std::optional<Job> job = jobs.pop()) {
+			runJob(*job, [&] {
+				job->target.route == Route::List ? listTasks(reader, *job) : getTask(reader, *job);
+			});
+		}
+	}
+
+	void serveWrites(const tike::HttpActions &actions, JobQueue &jobs) {
+		while (std::optional<Job> job = jobs.pop()) {
+			runJob(*job, [&] {
+				const std::int64_t taskId = job->target.taskId;
+				switch (job->target.route) {
+					case Route::Add: {
+						const tike::NewTask task = BodyReader(job->request.body).newTask();
+						respond(*job->stream, 201, "{\"id\":" + std::to_string(actions.add(task)) + "}");
+						return;
+					}
+					case Route::Complete:
+					case Route::Remove: {
+						const auto &change = job->target.route == Route::Complete ? actions.complete : actions.remove;
+						if (!change(taskId)) {
+							throw HttpError(404, "No open task with id " + std::to_string(taskId));
+						}
+						respond(*job->stream, 200, "{\"id\":" + std::to_string(taskId) + "}");
+						return;
+					}
+					default:
+						throw std::logic_error("Not a write");
+				}
+			});
+		}
+	}
+
+	// Listens on "host:port", brackets around an IPv6 host are optional
+	int listenOn(const std::string &address) {
+		const std::size_t colon = address.rfind(':');
+		if (colon == std::string::npos) {
+			throw std::invalid_argument("Expected host:port for --http, e.g. 127.0.0.1:8080");
+		}
+		std::string host = address.substr(0, colon);
+		const std::string port = address.substr(colon + 1);
+		if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+			host = host.substr(1, host.size() - 2);
+		}
+
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+		addrinfo *found = nullptr;
+		if (const int error = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found);
+			error != 0) {
+			throw std::invalid_argument("Can't use " + address + " for --http: " + ::gai_strerror(error));
+		}
+
+		int fd = -1;
+		int error = 0;
+		for (const addrinfo *candidate = found; candidate && fd < 0; candidate = candidate->ai_next) {
+			fd = ::socket(candidate->ai_family, candidate->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			              candidate->ai_protocol);
+			if (fd < 0) {
+				error = errno;
+				continue;
+			}
+			constexpr int one = 1;
+			::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+			if (::bind(fd, candidate->ai_addr, candidate->ai_addrlen) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+				error = errno;
+				::close(fd);
+				fd = -1;
+			}
+		}
+		::freeaddrinfo(found);
+		if (fd < 0) {
+			throw std::runtime_error("Failed to listen on " + address + ": " + std::strerror(error));
+		}
+		return fd;
+	}
+
+	std::string boundAddress(const int fd) {
+		sockaddr_storage address{};
+		socklen_t length = sizeof(address);
+		::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+		char host[INET6_ADDRSTRLEN] = {};
+		if (address.ss_family == AF_INET6) {
+			const auto *ipv6 = reinterpret_cast<const sockaddr_in6 *>(&address);
+			::inet_ntop(AF_INET6, &ipv6->sin6_addr, host, sizeof(host));
+			return "[" + std::string(host) + "]:" + std::to_string(ntohs(ipv6->sin6_port));
+		}
+		const auto *ipv4 = reinterpret_cast<const sockaddr_in *>(&address);
+		::inet_ntop(AF_INET, &ipv4->sin_addr, host, sizeof(host));
+		return std::string(host) + ":" + std::to_string(ntohs(ipv4->sin_port));
+	}
+
+	// The worker threads, stopped and joined when the server ends
+	class Workers {
+	public:
+		Workers(std::vector<std::unique_ptr<Reader>> readerConnections, const tike::HttpActions &actions)
+			: readerConnections(std::move(readerConnections)) {
+			for (const std::unique_ptr<Reader> &reader: this->readerConnections) {
+				threads.emplace_back(serveReads, std::ref(*reader), std::ref(reads));
+			}
+			threads.emplace_back(serveWrites, std::cref(actions), std::ref(writes));
+		}
+
+		~Workers() {
+			reads.close();
+			writes.close();
+			for (std::thread &thread: threads) {
+				thread.join();
+			}
+		}
+
+		Workers(const Workers &) = delete;
+
+		Workers &operator=(const Workers &) = delete;
+
+		JobQueue reads;
+		JobQueue writes;
+
+		// The query caches of all readers, added up
+		[[nodiscard]] db::QueryCacheStats cacheStats() const {
+			db::QueryCacheStats total;
+			for (const std::unique_ptr<Reader> &reader: readerConnections) {
+				total += reader->cache.stats();
+			}
+			return total;
+		}
+
+	private:
+		std::vector<std::unique_ptr<Reader>> readerConnections;
+		std::vector<std::thread> threads;
+	};
+	std::string statsBody(const db::QueryCacheStats &stats) {
+		return "{\"queryCache\":{\"hits\":" + std::to_string(stats.hits) +
+		       ",\"misses\":" + std::to_string(stats.misses) +
+		       ",\"hitRate\":" + std::to_string(stats.hitRate()) +
+		       ",\"invalidations\":" + std::to_string(stats.invalidations) +
+		       ",\"evictions\":" + std::to_string(stats.evictions) +
+		       ",\"bypassed\":" + std::to_string(stats.bypassed) +
+		       ",\"entries\":" + std::to_string(stats.entries) +
+		       ",\"bytes\":" + std::to_string(stats.bytes) + "}}";
+	}
+
+	struct Connection {
+		int fd = -1;
+		std::string input;
+		std::string output;
+		std::size_t outputSent = 0;
+		std::shared_ptr<ResponseStream> response; // The request being answered, one at a time
+		std::chrono::steady_clock::time_point lastActive;
+		std::chrono::steady_clock::time_point lastSent; // When the output last moved, for the send timeout
+		bool inputFull = false; // Reading paused until the buffered requests are answered
+		bool peerClosed = false;
+	};
+
+	/*
+	 * The event loop. Sockets are registered edge-triggered for reading and writing, so every event is followed
+	 * by reading or writing until the kernel says EAGAIN. Epoll ids 0 and 1 are the listener and the wakeup
+	 */
+	class EventLoop {
+	public:
+		EventLoop(const int listener, Workers &workers, const std::chrono::seconds sendTimeout)
+			: listener(listener), epoll(::epoll_create1(EPOLL_CLOEXEC)), workers(workers), sendTimeout(sendTimeout) {
+			if (epoll < 0) {
+				throw std::runtime_error(std::string("Failed to create an epoll instance: ") + std::strerror(errno));
+			}
+			watch(listener, EPOLLIN, listenerId);
+			watch(wakeup.descriptor(), EPOLLIN, wakeupId);
+		}
+
+		~EventLoop() {
+			while (!connections.empty()) {
+				close(connections.begin()->first);
+			}
+			::close(epoll);
+			::close(listener);
+		}
+
+		EventLoop(const EventLoop &) = delete;
+
+		EventLoop &operator=(const EventLoop &) = delete;
+
+		[[noreturn]] void run() {
+			epoll_event events[64];
+			for (;;) {
+				const int count = ::epoll_wait(epoll, events, static_cast<int>(std::size(events)), 1000);
+				if (count < 0 && errno != EINTR) {
+					throw std::runtime_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+				}
+				for (int index = 0; index < count; index++) {
+					const std::uint64_t id = events[index].data.u64;
+					const std::uint32_t flags = events[index].events;
+					if (id == listenerId) {
+						accept();
+					} else if (id == wakeupId) {
+						for (const std::uint64_t ready: wakeup.take()) {
+							send(ready);
+						}
+					} else {
+						if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+							receive(id);
+						}
+						if (flags & EPOLLOUT) {
+							send(id);
+						}
+					}
+				}
+				closeIdle();
+			}
+		}
+
+	private:
+		static constexpr std::uint64_t listenerId = 0;
+		static constexpr std::uint64_t wakeupId = 1;
+
+		int listener;
+		int epoll;
+		Wakeup wakeup;
+		Workers &workers;
+		std::chrono::seconds sendTimeout;
+		std::unordered_map<std::uint64_t, Connection> connections;
+		std::uint64_t nextId = 2;
+
+		void watch(const int fd, const std::uint32_t events, const std::uint64_t id) const {
+			epoll_event event{};
+			event.events = events;
+			event.data.u64 = id;
+			if (::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+				throw std::runtime_error(std::string("Failed to watch a socket: ") + std::strerror(errno));
+			}
+		}
+
+		void accept() {
+			for (;;) {
+				const int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+				if (fd < 0) {
+					if (errno == EINTR || errno == ECONNABORTED) {
+						continue;
+					}
+					return;
+				}
+				// Responses are written in whole pieces already, waiting to coalesce them only adds latency
+				constexpr int one = 1;
+				::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+				const std::uint64_t id = nextId++;
+				Connection &connection = connections[id];
+				connection.fd = fd;
+				connection.lastActive = std::chrono::steady_clock::now();
+				watch(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, id);
+			}
+		}
+
+		void close(const std::uint64_t id) {
+			const auto found = connections.find(id);
+			if (found == connections.end()) {
+				return;
+			}
+			if (found->second.response) {
+				found->second.response->abandon();
+			}
+			::close(found->second.fd);
+			connections.erase(found);
+		}
+
+		void receive(const std::uint64_t id) {
+			const auto found = connections.find(id);
+			if (found == connections.end()) {
+				return;
+			}
+			Connection &connection = found->second;
+			char buffer[16 * 1024];
+			for (;;) {
+				// A client sending faster than it reads gets no more buffering than one full request
+				if (connection.input.size() > maxHeaderBytes + maxBodyBytes) {
+					connection.inputFull = true;
+					break;
+				}
+				const ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+				if (received > 0) {
+					connection.input.append(buffer, static_cast<std::size_t>(received));
+				} else if (received == 0) {
+					connection.peerClosed = true;
+					break;
+				} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					break;
+				} else if (errno != EINTR) {
+					close(id);
+					return;
+				}
+			}
+			connection.lastActive = std::chrono::steady_clock::now();
+			dispatch(id);
+		}
+
+		// Starts answering the next buffered request, if no other one is being answered
+		void dispatch(const std::uint64_t id) {
+			Connection &connection = connections.at(id);
+			if (connection.response) {
+				return;
+			}
+
+			std::optional<Request> request;
+			try {
+				request = parseRequest(connection.input);
+			} catch (const HttpError &error) {
+				connection.response = std::make_shared<ResponseStream>(wakeup, id, false);
+				respondError(*connection.response, error.status, error.what());
+				return;
+			}
+			if (!request) {
+				if (connection.peerClosed) {
+					close(id);
+				}
+				return;
+			}
+
+			connection.response = std::make_shared<ResponseStream>(wakeup, id, request->keepAlive);
+			try {
+				const Target target = route(*request);
+				if (target.route == Route::Stats) {
+					respond(*connection.response, 200, statsBody(workers.cacheStats()));
+					return;
+				}
+				JobQueue &queue = target.route == Route::List || target.route == Route::Get
+					                  ? workers.reads
+					                  : workers.writes;
+				queue.push(Job{std::move(*request), target, connection.response});
+			} catch (const HttpError &error) {
+				respondError(*connection.response, error.status, error.what(), error.allow);
+			}
+		}
+
+		// Writes out what the response has ready, and moves on to the next request once it is complete
+		void send(const std::uint64_t id) {
+			const auto found = connections.find(id);
+			if (found == connections.end()) {
+				return; // Output of a connection that was closed since
+			}
+			Connection &connection = found->second;
+			for (;;) {
+				while (connection.outputSent < connection.output.size()) {
+					const ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputSent,
+					                            connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+					if (sent > 0) {
+						connection.outputSent += static_cast<std::size_t>(sent);
+						connection.lastSent = std::chrono::steady_clock::now();
+					} else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+						return; // EPOLLOUT comes back once the socket has room
+					} else if (sent < 0 && errno != EINTR) {
+						close(id);
+						return;
+					}
+				}
+				connection.output.clear();
+				connection.outputSent = 0;
+				if (!connection.response) {
+					return;
+				}
+
+				const bool complete = connection.response->take(connection.output);
+				if (!connection.output.empty()) {
+					// The client only gets blamed for output it had the chance to read
+					connection.lastSent = std::chrono::steady_clock::now();
+					continue;
+				}
+				if (!complete) {
+					return; // The worker is still producing, the wakeup brings us back
+				}
+
+				const bool keepAlive = connection.response->keepAlive();
+				connection.response.reset();
+				connection.lastActive = std::chrono::steady_clock::now();
+				if (!keepAlive) {
+					close(id);
+				} else if (connection.inputFull) {
+					connection.inputFull = false;
+					receive(id);
+				} else {
+					dispatch(id);
+				}
+				return;
+			}
+		}
+
+		/*
+		 * Closes connections that were idle between requests for too long, and those whose output didn't move for
+		 * the send timeout. Closing abandons the response, so a worker waiting for room in it gives up
+		 */
+		void closeIdle() {
+			const auto now = std::chrono::steady_clock::now();
+			std::vector<std::uint64_t> idle;
+			for (const auto &[id, connection]: connections) {
+				const bool stalled = connection.outputSent < connection.output.size() &&
+				                     now - connection.lastSent > sendTimeout;
+				if (stalled || (!connection.response && now - connection.lastActive > idleTimeout)) {
+					idle.push_back(id);
+				}
+			}
+			for (const std::uint64_t id: idle) {
+				close(id);
+			}
+		}
+	};
+
+#endif
+}
+
+void tike::runHttpServer(const std::string &address, const std::string &dbPath, const HttpActions &actions,
+                         unsigned readers, const std::chrono::seconds sendTimeout) {
+#ifndef __linux__
+	throw std::runtime_error("--http is only available on Linux, it is built on epoll");
+#else
+	const int listener = listenOn(address);
+	if (readers == 0) {
+		readers = std::max(2u, std::thread::hardware_concurrency());
+	}
+
+	// Open the connections here, so a database that can't be read fails now instead of inside a thread
+	std::vector<std::unique_ptr<Reader>> readerConnections;
+	try {
+		for (unsigned index = 0; index < readers; index++) {
+			readerConnections.push_back(std::make_unique<Reader>(dbPath));
+		}
+	} catch (...) {
+		::close(listener);
+		throw;
+	}
+
+	Workers workers(std::move(readerConnections), actions);
+	EventLoop loop(listener, workers, sendTimeout);
+	std::cout << "Serving on http://" << boundAddress(listener) << std::endl;
+	loop.run();
+#endif
+}
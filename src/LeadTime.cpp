@@ -0,0 +1,154 @@
+#include "LeadTime.h"
+
+#include "TDigest.h"
+
+#include <format>
+#include <stdexcept>
+
+namespace {
+	// "YYYY-MM" of the month after the given one
+	std::string nextMonth(const std::string &month) {
+		int year = std::stoi(month.substr(0, 4));
+		int monthNumber = std::stoi(month.substr(5, 2)) + 1;
+		if (monthNumber > 12) {
+			monthNumber = 1;
+			year++;
+		}
+		return std::format("{:04}-{:02}", year, monthNumber);
+	}
+
+	/*
+	 * Adds the lead time of every task completed in [from, to) to the digest. Bounds are dates, timestamps
+	 * are stored as "YYYY-MM-DD HH:MM:SS" so they compare correctly as text and the range uses the index
+	 */
+	void scanInto(const db::Database &db, tike::TDigest &digest, const std::string &from, const std::string &to) {
+		db::Statement statement = db.prepare(R"(
+			SELECT julianday(timeCompleted) - julianday(timeCreated)
+			FROM completedTasks
+			WHERE timeCompleted >= ? AND timeCompleted < ?
+		)");
+		statement.bind(1, from).bind(2, to);
+		while (statement.step()) {
+			if (!statement.columnIsNull(0)) {
+				digest.add(statement.columnDouble(0));
+			}
+		}
+	}
+}
+
+void tike::ensureLeadTime(const db::Database &db) {
+	db.execute(R"(
+		CREATE TABLE IF NOT EXISTS leadTimeDigests (
+			month TEXT PRIMARY KEY,
+			generation INTEGER NOT NULL,
+			digest BLOB NOT NULL
+		) WITHOUT ROWID;
+		CREATE INDEX IF NOT EXISTS completedTasksTimeCompleted ON completedTasks (timeCompleted);
+
+		-- A month without a row counts as generation 0, every change in a month moves it past any stored digest
+		CREATE TABLE IF NOT EXISTS leadTimeGenerations (
+			month TEXT PRIMARY KEY,
+			generation INTEGER NOT NULL
+		) WITHOUT ROWID;
+
+		CREATE TRIGGER IF NOT EXISTS completedTasksInsertLeadTime AFTER INSERT ON completedTasks BEGIN
+			INSERT INTO leadTimeGenerations (month, generation)
+			SELECT month, 1 FROM (SELECT strftime('%Y-%m', NEW.timeCompleted) AS month) WHERE month IS NOT NULL
+			ON CONFLICT (month) DO UPDATE SET generation = generation + 1;
+		END;
+
+		CREATE TRIGGER IF NOT EXISTS completedTasksDeleteLeadTime AFTER DELETE ON completedTasks BEGIN
+			INSERT INTO leadTimeGenerations (month, generation)
+			SELECT month, 1 FROM (SELECT strftime('%Y-%m', OLD.timeCompleted) AS month) WHERE month IS NOT NULL
+			ON CONFLICT (month) DO UPDATE SET generation = generation + 1;
+		END;
+
+		CREATE TRIGGER IF NOT EXISTS completedTasksUpdateLeadTime
+		AFTER UPDATE OF timeCreated, timeCompleted ON completedTasks BEGIN
+			INSERT INTO leadTimeGenerations (month, generation)
+			SELECT month, 1 FROM (SELECT strftime('%Y-%m', OLD.timeCompleted) AS month) WHERE month IS NOT NULL
+			ON CONFLICT (month) DO UPDATE SET generation = generation + 1;
+			INSERT INTO leadTimeGenerations (month, generation)
+			SELECT month, 1 FROM (SELECT strftime('%Y-%m', NEW.timeCompleted) AS month) WHERE month IS NOT NULL
+			ON CONFLICT (month) DO UPDATE SET generation = generation + 1;
+		END;
+	)");
+}
+
+tike::LeadTimeReport tike::leadTimeReport(const db::Database &db, const std::optional<std::string> &since) {
+	std::string sinceDay;
+	if (since) {
+		db::Statement check = db.prepare("SELECT date(?) IS ?");
+		check.bind(1, *since).bind(2, *since);
+		if (!check.step() || check.columnInt64(0) == 0) {
+			throw std::invalid_argument("Invalid date, expected YYYY-MM-DD: " + *since);
+		}
+		sinceDay = *since;
+	}
+
+	db::Statement currentMonthQuery = db.prepare("SELECT strftime('%Y-%m', 'now')");
+	currentMonthQuery.step();
+	const std::string currentMonth(currentMonthQuery.columnText(0));
+
+	/*
+	 * dailyStats says which months have completions without touching completedTasks, leadTimeGenerations how
+	 * often each month's completions changed
+	 */
+	db::Statement months = db.prepare(R"(
+		SELECT substr(day, 1, 7), COALESCE(g.generation, 0)
+		FROM dailyStats
+		LEFT JOIN leadTimeGenerations g ON g.month = substr(day, 1, 7)
+		WHERE day >= ?
+		GROUP BY 1
+		HAVING SUM(completed) > 0
+		ORDER BY 1
+	)");
+	months.bind(1, sinceDay);
+
+	db::Statement loadSketch = db.prepare("SELECT generation, digest FROM leadTimeDigests WHERE month = ?");
+	db::Statement storeSketch = db.prepare(
+		"INSERT OR REPLACE INTO leadTimeDigests (month, generation, digest) VALUES (?, ?, ?)");
+
+	TDigest total;
+	while (months.step()) {
+		const std::string month(months.columnText(0));
+		const std::int64_t generation = months.columnInt64(1);
+		const std::string from = month + "-01";
+		const std::string to = nextMonth(month) + "-01";
+
+		// The running month and the month `since` cuts into are scanned, their digests would be partial
+		if (month == currentMonth || sinceDay > from) {
+			scanInto(db, total, std::max(from, sinceDay), to);
+			continue;
+		}
+
+		/*
+		 * A stored digest is current as long as no completion of its month was added, removed or changed since
+		 * it was built. Counting rows would miss a delete and an insert that cancel out, or an edited timestamp
+		 */
+		loadSketch.reset();
+		loadSketch.bind(1, month);
+		if (loadSketch.step() && loadSketch.columnInt64(0) == generation) {
+			if (const std::optional<TDigest> digest = TDigest::deserialize(loadSketch.columnBlob(1))) {
+				total.merge(*digest);
+				continue;
+			}
+		}
+
+		TDigest digest;
+		scanInto(db, digest, from, to);
+		storeSketch.reset();
+		storeSketch.bind(1, month).bindInt64(2, generation).bindBlob(3, digest.serialize());
+		storeSketch.step();
+		total.merge(digest);
+	}
+
+	LeadTimeReport report;
+	report.count = static_cast<std::int64_t>(total.count());
+	if (report.count > 0) {
+		report.p50 = total.quantile(0.5);
+		report.p90 = total.quantile(0.9);
+		report.p99 = total.quantile(0.99);
+	}
+	return report;
+}
@@ -0,0 +1,464 @@
+#include "OutputSink.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define TIKE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+	constexpr std::size_t bufferSize = 1 << 20;
+
+	std::runtime_error writeError(const int error) {
+		return std::runtime_error("Failed to write the output: " + std::string(std::strerror(error)));
+	}
+
+#ifdef _WIN32
+	// No file descriptors to hand to the kernel, the streams do the buffering
+	class StreamSink final : public tike::OutputSink {
+	public:
+		explicit StreamSink(const std::string &path) : file(path, std::ios::binary | std::ios::trunc), out(file) {
+			if (!file) {
+				throw std::runtime_error("Failed to open " + path);
+			}
+		}
+
+		StreamSink() : out(std::cout) {
+		}
+
+		void write(const std::string_view bytes) override {
+			if (!out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+				throw std::runtime_error("Failed to write the output");
+			}
+		}
+
+		void finish() override {
+			if (!out.flush()) {
+				throw std::runtime_error("Failed to write the output");
+			}
+		}
+
+		[[nodiscard]] std::string_view method() const override { return "write"; }
+
+	private:
+		std::ofstream file;
+		std::ostream &out;
+	};
+#else
+	// Collects small writes into one buffer and hands it to write() once it is full
+	class FdSink final : public tike::OutputSink {
+	public:
+		FdSink(const int fd, const bool ownsFd) : fd(fd), ownsFd(ownsFd) {
+			buffer.reserve(bufferSize);
+		}
+
+		~FdSink() override {
+			if (ownsFd && fd >= 0) {
+				::close(fd);
+			}
+		}
+
+		void write(const std::string_view bytes) override {
+			if (buffer.size() + bytes.size() > bufferSize) {
+				flush();
+			}
+			// Large writes skip the copy
+			if (bytes.size() >= bufferSize) {
+				writeAll(bytes);
+			} else {
+				buffer.append(bytes);
+			}
+		}
+
+		void finish() override {
+			flush();
+			if (ownsFd) {
+				const int closing = fd;
+				fd = -1;
+				if (::close(closing) != 0) {
+					throw writeError(errno);
+				}
+			}
+		}
+
+		[[nodiscard]] std::string_view method() const override { return "write"; }
+
+	private:
+		int fd;
+		bool ownsFd;
+		std::string buffer;
+
+		void flush() {
+			writeAll(buffer);
+			buffer.clear();
+		}
+
+		void writeAll(std::string_view bytes) const {
+			while (!bytes.empty()) {
+				const ssize_t written = ::write(fd, bytes.data(), bytes.size());
+				if (written < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					throw writeError(errno);
+				}
+				bytes.remove_prefix(static_cast<std::size_t>(written));
+			}
+		}
+	};
+#endif
+
+#ifdef TIKE_IO_URING
+	// Thrown while setting the ring up, the caller falls back to FdSink
+	struct UringUnavailable {
+	};
+
+	/*
+	 * The io_uring sink, on the raw system calls, so there is no dependency on liburing. Every write is a
+	 * IORING_OP_WRITE_FIXED of one registered buffer at an explicit offset, so writes may complete in any order
+	 */
+	class UringSink final : public tike::OutputSink {
+	public:
+		UringSink(const int fd, const bool ownsFd, const off_t offset, const bool direct)
+			: fd(fd), ownsFd(ownsFd), direct(direct), offset(offset) {
+			io_uring_params params{};
+			ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+			if (ringFd < 0) {
+				throw UringUnavailable();
+			}
+			try {
+				mapRings(params);
+				buffers = static_cast<char *>(std::aligned_alloc(pageSize, depth * bufferSize));
+				if (!buffers) {
+					throw UringUnavailable();
+				}
+				std::vector<iovec> vectors(depth);
+				for (unsigned index = 0; index < depth; index++) {
+					vectors[index] = {buffers + index * bufferSize, bufferSize};
+					freeBuffers.push_back(index);
+				}
+				// Registering pins the buffers once, instead of mapping them again for every write
+				if (::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, vectors.data(), depth) != 0) {
+					throw UringUnavailable();
+				}
+			} catch (...) {
+				release();
+				throw;
+			}
+		}
+
+		~UringSink() override {
+			// The kernel may still be writing from the buffers, they can only go once every write completed
+			try {
+				while (inFlight > 0) {
+					reap(true);
+				}
+			} catch (...) {
+			}
+			release();
+			if (ownsFd && fd >= 0) {
+				::close(fd);
+			}
+		}
+
+		void write(std::string_view bytes) override {
+			while (!bytes.empty()) {
+				if (!current) {
+					current = takeBuffer();
+				}
+				const std::size_t take = std::min(bytes.size(), bufferSize - filled);
+				std::memcpy(buffers + *current * bufferSize + filled, bytes.data(), take);
+				filled += take;
+				bytes.remove_prefix(take);
+				if (filled == bufferSize) {
+					submitCurrent();
+				}
+			}
+		}
+
+		void finish() override {
+			const off_t end = offset + static_cast<off_t>(filled);
+			if (current) {
+				if (direct) {
+					// O_DIRECT only takes whole blocks, the padding is cut off again below
+					const std::size_t padded = (filled + pageSize - 1) / pageSize * pageSize;
+					std::memset(buffers + *current * bufferSize + filled, 0, padded - filled);
+					filled = padded;
+				}
+				submitCurrent();
+			}
+			while (inFlight > 0) {
+				reap(true);
+			}
+			if (direct && ::ftruncate(fd, end) != 0) {
+				throw writeError(errno);
+			}
+			if (ownsFd) {
+				const int closing = fd;
+				fd = -1;
+				if (::close(closing) != 0) {
+					throw writeError(errno);
+				}
+			} else {
+				// Writes at explicit offsets don't move the file position, move it past the output
+				::lseek(fd, end, SEEK_SET);
+			}
+		}
+
+		[[nodiscard]] std::string_view method() const override { return "io_uring"; }
+
+	private:
+		static constexpr unsigned depth = 8;
+		static constexpr std::size_t pageSize = 4096;
+
+		// A buffer being written: where it goes and how much of it the kernel took so far
+		struct Write {
+			off_t offset = 0;
+			std::size_t length = 0;
+			std::size_t done = 0;
+		};
+
+		int fd;
+		bool ownsFd;
+		bool direct;
+		off_t offset;
+		int ringFd = -1;
+
+		void *sqRing = MAP_FAILED;
+		void *cqRing = MAP_FAILED;
+		std::size_t sqRingSize = 0;
+		std::size_t cqRingSize = 0;
+		io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+		std::size_t sqesSize = 0;
+		unsigned *sqTail = nullptr;
+		unsigned *sqMask = nullptr;
+		unsigned *sqArray = nullptr;
+		unsigned *cqHead = nullptr;
+		unsigned *cqTail = nullptr;
+		unsigned *cqMask = nullptr;
+		io_uring_cqe *cqes = nullptr;
+
+		char *buffers = nullptr;
+		std::vector<unsigned> freeBuffers;
+		Write writes[depth]{};
+		unsigned inFlight = 0;
+		std::optional<unsigned> current;
+		std::size_t filled = 0;
+
+		void mapRings(const io_uring_params &params) {
+			sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+			if (single) {
+				sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+			}
+			sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+			                IORING_OFF_SQ_RING);
+			if (sqRing == MAP_FAILED) {
+				throw UringUnavailable();
+			}
+			cqRing = single
+				         ? sqRing
+				         : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+				                  IORING_OFF_CQ_RING);
+			if (cqRing == MAP_FAILED) {
+				throw UringUnavailable();
+			}
+			sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			sqes = static_cast<io_uring_sqe *>(::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+			                                          MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+			if (sqes == MAP_FAILED) {
+				throw UringUnavailable();
+			}
+
+			const auto field = [](void *ring, const unsigned offset) {
+				return reinterpret_cast<unsigned *>(static_cast<char *>(ring) + offset);
+			};
+			sqTail = field(sqRing, params.sq_off.tail);
+			sqMask = field(sqRing, params.sq_off.ring_mask);
+			sqArray = field(sqRing, params.sq_off.array);
+			cqHead = field(cqRing, params.cq_off.head);
+			cqTail = field(cqRing, params.cq_off.tail);
+			cqMask = field(cqRing, params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(cqRing) + params.cq_off.cqes);
+		}
+
+		void release() {
+			if (sqes != MAP_FAILED) {
+				::munmap(sqes, sqesSize);
+			}
+			if (cqRing != MAP_FAILED && cqRing != sqRing) {
+				::munmap(cqRing, cqRingSize);
+			}
+			if (sqRing != MAP_FAILED) {
+				::munmap(sqRing, sqRingSize);
+			}
+			if (ringFd >= 0) {
+				::close(ringFd);
+			}
+			std::free(buffers);
+			sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+			sqRing = cqRing = MAP_FAILED;
+			ringFd = -1;
+			buffers = nullptr;
+		}
+
+		unsigned takeBuffer() {
+			while (freeBuffers.empty()) {
+				reap(true);
+			}
+			const unsigned index = freeBuffers.back();
+			freeBuffers.pop_back();
+			return index;
+		}
+
+		void submitCurrent() {
+			writes[*current] = {offset, filled, 0};
+			offset += static_cast<off_t>(filled);
+			inFlight++;
+			submit(*current);
+			current.reset();
+			filled = 0;
+		}
+
+		void submit(const unsigned index) {
+			const Write &write = writes[index];
+			// Only this thread produces submissions, the kernel reads the tail we publish
+			const unsigned tail = *sqTail;
+			const unsigned slot = tail & *sqMask;
+			io_uring_sqe &sqe = sqes[slot];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_WRITE_FIXED;
+			sqe.fd = fd;
+			sqe.addr = reinterpret_cast<std::uint64_t>(buffers + index * bufferSize + write.done);
+			sqe.len = static_cast<std::uint32_t>(write.length - write.done);
+			sqe.off = static_cast<std::uint64_t>(write.offset) + write.done;
+			sqe.buf_index = static_cast<std::uint16_t>(index);
+			sqe.user_data = index;
+			sqArray[slot] = slot;
+			__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+			while (::syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0) < 0) {
+				if (errno != EINTR) {
+					throw writeError(errno);
+				}
+			}
+		}
+
+		// Handles the completed writes. With `wait`, blocks until at least one completed
+		void reap(const bool wait) {
+			for (bool reaped = false;;) {
+				const unsigned head = *cqHead;
+				if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+					if (reaped || !wait) {
+						return;
+					}
+					if (::syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+					    errno != EINTR) {
+						throw writeError(errno);
+					}
+					continue;
+				}
+				const io_uring_cqe cqe = cqes[head & *cqMask];
+				__atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+				reaped = true;
+
+				const auto index = static_cast<unsigned>(cqe.user_data);
+				Write &write = writes[index];
+				if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+					submit(index);
+					continue;
+				}
+				if (cqe.res <= 0) {
+					inFlight--;
+					freeBuffers.push_back(index);
+					throw writeError(cqe.res < 0 ? -cqe.res : EIO);
+				}
+				// A short write goes again for the rest
+				write.done += static_cast<std::size_t>(cqe.res);
+				if (write.done < write.length) {
+					submit(index);
+				} else {
+					inFlight--;
+					freeBuffers.push_back(index);
+				}
+			}
+		}
+	};
+#endif
+
+#ifndef _WIN32
+	std::unique_ptr<tike::OutputSink> sinkFor(const int fd, const bool ownsFd, const off_t offset,
+	                                          const tike::OutputOptions &options, const bool direct) {
+#ifdef TIKE_IO_URING
+		if (options.uring) {
+			try {
+				return std::make_unique<UringSink>(fd, ownsFd, offset, direct);
+			} catch (const UringUnavailable &) {
+			}
+		}
+#endif
+		// write() on an O_DIRECT descriptor would need aligned buffers, drop the flag instead
+		if (direct) {
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT);
+		}
+		return std::make_unique<FdSink>(fd, ownsFd);
+	}
+#endif
+}
+
+std::unique_ptr<tike::OutputSink> tike::openOutputFile(const std::string &path, const OutputOptions &options) {
+#ifdef _WIN32
+	return std::make_unique<StreamSink>(path);
+#else
+	constexpr int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+	int fd = -1;
+	bool direct = false;
+	if (options.direct) {
+		// Filesystems like tmpfs refuse O_DIRECT, they get a normal file
+		fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+		direct = fd >= 0;
+	}
+	if (fd < 0) {
+		fd = ::open(path.c_str(), flags, 0644);
+	}
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+	}
+	return sinkFor(fd, true, 0, options, direct);
+#endif
+}
+
+std::unique_ptr<tike::OutputSink> tike::standardOutput(const OutputOptions &options) {
+	std::cout.flush();
+#ifdef _WIN32
+	return std::make_unique<StreamSink>();
+#else
+	// Only a regular file has offsets to write at. With O_APPEND the kernel ignores them, so that is out too
+	struct stat status{};
+	if (::fstat(STDOUT_FILENO, &status) == 0 && S_ISREG(status.st_mode) &&
+	    !(::fcntl(STDOUT_FILENO, F_GETFL) & O_APPEND)) {
+		if (const off_t offset = ::lseek(STDOUT_FILENO, 0, SEEK_CUR); offset >= 0) {
+			return sinkFor(STDOUT_FILENO, false, offset, options, false);
+		}
+	}
+	return std::make_unique<FdSink>(STDOUT_FILENO, false);
+#endif
+}
@@ -0,0 +1,364 @@
+#include "PerfCounters.h"
+
+#ifdef TIKE_ALLOC_STATS
+#include "AllocStats.h"
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <memory>
+#include <sqlite3.h>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	enum Counter : std::size_t {
+		Cycles,
+		Instructions,
+		CacheMisses,
+		BranchMisses,
+		PageFaults,
+		ContextSwitches,
+		Allocations,
+		AllocatedBytes,
+		CounterCount
+	};
+
+	constexpr const char *counterNames[CounterCount] = {
+		"Cycles", "Instructions", "Cache misses", "Branch misses", "Page faults", "Ctx switches", "Allocations",
+		"Alloc bytes"
+	};
+
+	// The allocation columns only exist in the instrumentation build, see AllocStats.h
+#ifdef TIKE_ALLOC_STATS
+	constexpr std::size_t shownCounters = CounterCount;
+#else
+	constexpr std::size_t shownCounters = Allocations;
+#endif
+
+	using Counts = std::array<double, CounterCount>;
+
+	struct Reading {
+		Clock::time_point time;
+		Counts counts{};
+	};
+
+#ifdef __linux__
+	struct CounterSpec {
+		Counter counter;
+		std::uint32_t type;
+		std::uint64_t config;
+	};
+
+	constexpr CounterSpec hardwareCounters[] = {
+		{Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+		{BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+	};
+
+	constexpr CounterSpec softwareCounters[] = {
+		{PageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+		{ContextSwitches, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}
+	};
+
+	/*
+	 * Counters the kernel schedules together, so they cover the same stretch of time and are read with one
+	 * system call. When there are more hardware counters than the CPU has, the group only runs part of the time
+	 * and its counts are scaled up by the share it ran
+	 */
+	class CounterGroup {
+	public:
+		CounterGroup() = default;
+
+		CounterGroup(const CounterGroup &) = delete;
+
+		CounterGroup &operator=(const CounterGroup &) = delete;
+
+		~CounterGroup() {
+			for (const int fd: fds) {
+				::close(fd);
+			}
+		}
+
+		// Opens what it can of the counters, false if not even the first one opened
+		bool open(const std::span<const CounterSpec> specs, const bool excludeKernel) {
+			for (const CounterSpec &spec: specs) {
+				perf_event_attr attribute{};
+				attribute.size = sizeof(attribute);
+				attribute.type = spec.type;
+				attribute.config = spec.config;
+				attribute.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+				                        PERF_FORMAT_TOTAL_TIME_RUNNING;
+				attribute.exclude_kernel = excludeKernel;
+				attribute.exclude_hv = excludeKernel;
+				const int leader = fds.empty() ? -1 : fds.front();
+				const long fd = ::syscall(SYS_perf_event_open, &attribute, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+				if (fd < 0) {
+					if (fds.empty()) {
+						return false;
+					}
+					continue;
+				}
+				fds.push_back(static_cast<int>(fd));
+				counters.push_back(spec.counter);
+			}
+			return true;
+		}
+
+		void read(Counts &counts) const {
+			if (fds.empty()) {
+				return;
+			}
+			// nr, time enabled, time running, then one value per counter
+			std::array<std::uint64_t, 3 + std::size(hardwareCounters)> values{};
+			const ssize_t size = ::read(fds.front(), values.data(), sizeof(values));
+			if (size < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || values[0] != counters.size()) {
+				return;
+			}
+			const double scale = values[2] > 0 ? static_cast<double>(values[1]) / static_cast<double>(values[2]) : 0;
+			for (std::size_t index = 0; index < counters.size(); index++) {
+				counts[counters[index]] = static_cast<double>(values[3 + index]) * scale;
+			}
+		}
+
+		[[nodiscard]] bool has(const Counter counter) const {
+			return std::ranges::find(counters, counter) != counters.end();
+		}
+
+	private:
+		std::vector<int> fds; // The group leader first
+		std::vector<Counter> counters;
+	};
+#endif
+
+	struct PhaseTotals {
+		std::string_view name;
+		double milliseconds = 0;
+		Counts counts{};
+	};
+
+	class Profiler {
+	public:
+		Profiler() {
+#ifdef __linux__
+			// Counting the kernel's share as well shows the cost of system calls, but needs more privileges
+			for (const bool excludeKernel: {false, true}) {
+				if (software.open(softwareCounters, excludeKernel)) {
+					hardware.open(hardwareCounters, excludeKernel);
+					userOnly = excludeKernel;
+					break;
+				}
+			}
+#endif
+#ifdef TIKE_ALLOC_STATS
+			// Whether the system SQLite keeps memory statistics by default depends on how it was built, and it can
+			// only be switched on before SQLite initializes
+			sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 1);
+#endif
+			// Room for every phase up front, so the profiler's own allocations don't show up in them
+			phases.reserve(16);
+			stack.reserve(16);
+			phases.push_back({"other"});
+			stack.push_back(0);
+			last = read();
+		}
+
+		void enter(const std::string_view name) {
+			attribute();
+			std::size_t index = 0;
+			while (index < phases.size() && phases[index].name != name) {
+				index++;
+			}
+			if (index == phases.size()) {
+				phases.push_back({name});
+			}
+			stack.push_back(index);
+		}
+
+		void leave() {
+			attribute();
+			if (stack.size() > 1) {
+				stack.pop_back();
+			}
+		}
+
+		void report(std::ostream &out) {
+			attribute();
+
+			std::array<bool, CounterCount> available{};
+#ifdef __linux__
+			for (std::size_t counter = 0; counter < CounterCount; counter++) {
+				available[counter] = hardware.has(static_cast<Counter>(counter)) ||
+				                     software.has(static_cast<Counter>(counter));
+			}
+#endif
+#ifdef _WIN32
+			const bool fromRusage = false;
+#else
+			const bool fromRusage = !available[PageFaults];
+			if (fromRusage) {
+				available[PageFaults] = available[ContextSwitches] = true;
+			}
+#endif
+			available[Allocations] = available[AllocatedBytes] = shownCounters == CounterCount;
+
+			out << "\n" << std::left << std::setw(8) << "Phase" << std::right << std::setw(11) << "Time";
+			for (std::size_t counter = 0; counter < shownCounters; counter++) {
+				out << std::setw(15) << counterNames[counter];
+			}
+			out << std::setw(6) << "IPC" << "\n";
+			for (const PhaseTotals &phase: phases) {
+				std::ostringstream time;
+				time << std::fixed << std::setprecision(3) << phase.milliseconds << " ms";
+				out << std::left << std::setw(8) << phase.name << std::right << std::setw(11) << time.str();
+				for (std::size_t counter = 0; counter < shownCounters; counter++) {
+					if (available[counter]) {
+						out << std::setw(15) << static_cast<std::uint64_t>(phase.counts[counter] + 0.5);
+					} else {
+						out << std::setw(15) << "-";
+					}
+				}
+				if (available[Cycles] && available[Instructions] && phase.counts[Cycles] > 0) {
+					out << std::setw(6) << std::fixed << std::setprecision(2)
+							<< phase.counts[Instructions] / phase.counts[Cycles];
+				} else {
+					out << std::setw(6) << "-";
+				}
+				out << "\n";
+			}
+
+			if (!available[Cycles]) {
+				out << "No hardware counters on this system, only the software counters are shown\n";
+			}
+			if (fromRusage) {
+				out << "perf_event_open isn't available, page faults and context switches come from getrusage\n";
+			} else if (userOnly) {
+				out << "Counting the kernel isn't allowed, the counts only cover tike's own code\n";
+			}
+
+#ifndef _WIN32
+			rusage usage{};
+			if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+				const long peakKiB = usage.ru_maxrss / 1024;
+#else
+				const long peakKiB = usage.ru_maxrss;
+#endif
+				out << "Peak RSS: " << peakKiB << " KiB\n";
+			}
+#endif
+			// SQLite allocates with malloc, past the operator new counters. Without its memory statistics these are 0
+			sqlite3_int64 current = 0;
+			sqlite3_int64 peak = 0;
+			if (sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &peak, 0) == SQLITE_OK && peak > 0) {
+				sqlite3_int64 allocations = 0;
+				sqlite3_int64 peakAllocations = 0;
+				sqlite3_status64(SQLITE_STATUS_MALLOC_COUNT, &allocations, &peakAllocations, 0);
+				out << "SQLite heap: " << peak / 1024 << " KiB at the peak, in " << peakAllocations << " allocations\n";
+			}
+			out << std::flush;
+		}
+
+	private:
+		std::vector<PhaseTotals> phases;
+		std::vector<std::size_t> stack; // Indices into phases, the innermost phase last
+		Reading last;
+		bool userOnly = false;
+#ifdef __linux__
+		CounterGroup hardware;
+		CounterGroup software;
+#endif
+
+		[[nodiscard]] Reading read() const {
+			Reading reading;
+#ifdef __linux__
+			hardware.read(reading.counts);
+			software.read(reading.counts);
+			if (software.has(PageFaults)) {
+				readHeap(reading);
+				reading.time = Clock::now();
+				return reading;
+			}
+#endif
+#ifndef _WIN32
+			rusage usage{};
+			if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+				reading.counts[PageFaults] = static_cast<double>(usage.ru_minflt + usage.ru_majflt);
+				reading.counts[ContextSwitches] = static_cast<double>(usage.ru_nvcsw + usage.ru_nivcsw);
+			}
+#endif
+			readHeap(reading);
+			reading.time = Clock::now();
+			return reading;
+		}
+
+		static void readHeap([[maybe_unused]] Reading &reading) {
+#ifdef TIKE_ALLOC_STATS
+			const tike::AllocCounts heap = tike::allocCounts();
+			reading.counts[Allocations] = static_cast<double>(heap.allocations);
+			reading.counts[AllocatedBytes] = static_cast<double>(heap.bytes);
+#endif
+		}
+
+		// Adds what was counted since the last phase change to the phase running until now
+		void attribute() {
+			const Reading now = read();
+			PhaseTotals &phase = phases[stack.back()];
+			phase.milliseconds += std::chrono::duration<double, std::milli>(now.time - last.time).count();
+			for (std::size_t counter = 0; counter < CounterCount; counter++) {
+				phase.counts[counter] += now.counts[counter] - last.counts[counter];
+			}
+			last = now;
+		}
+	};
+
+	std::unique_ptr<Profiler> profiler;
+}
+
+void tike::startPerfCounters() {
+	if (!profiler) {
+		profiler = std::make_unique<Profiler>();
+	}
+}
+
+void tike::reportPerfCounters(std::ostream &out) {
+	if (profiler) {
+		profiler->report(out);
+	}
+}
+
+tike::PerfReport::~PerfReport() {
+	try {
+		reportPerfCounters(out);
+	} catch (const std::exception &) {
+		// A report that can't be written is not worth terminating for
+	}
+}
+
+tike::PerfPhase::PerfPhase(const std::string_view name) : counting(profiler != nullptr) {
+	if (counting) {
+		profiler->enter(name);
+	}
+}
+
+tike::PerfPhase::~PerfPhase() {
+	if (counting) {
+		profiler->leave();
+	}
+}
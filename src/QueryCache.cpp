@@ -0,0 +1,231 @@
+#include "QueryCache.h"
+
+#include <bit>
+#include <cstring>
+
+namespace {
+	// The bookkeeping of a list node and the index slot, so budgets hold for many small results as well
+	constexpr std::size_t entryOverhead = 128;
+
+	void appendKey(std::string &key, const db::Value &value) {
+		key += static_cast<char>(value.index());
+		const auto appendBytes = [&](const auto number) {
+			char bytes[sizeof(number)];
+			std::memcpy(bytes, &number, sizeof(number));
+			key.append(bytes, sizeof(bytes));
+		};
+		if (const auto *integer = std::get_if<std::int64_t>(&value)) {
+			appendBytes(*integer);
+		} else if (const auto *real = std::get_if<double>(&value)) {
+			appendBytes(std::bit_cast<std::uint64_t>(*real));
+		} else if (const auto *text = std::get_if<std::string>(&value)) {
+			// The length first, so "a" followed by "bc" can't match "ab" followed by "c"
+			appendBytes(static_cast<std::uint64_t>(text->size()));
+			key += *text;
+		}
+	}
+
+	void bindValue(db::Statement &statement, const int index, const db::Value &value) {
+		if (const auto *integer = std::get_if<std::int64_t>(&value)) {
+			statement.bindInt64(index, *integer);
+		} else if (const auto *real = std::get_if<double>(&value)) {
+			statement.bind(index, *real);
+		} else if (const auto *text = std::get_if<std::string>(&value)) {
+			statement.bind(index, *text);
+		} else {
+			statement.bindNull(index);
+		}
+	}
+
+	// Reads a column into value, reusing the string a text value already has
+	void readColumn(const db::Statement &statement, const int column, db::Value &value) {
+		const auto assignText = [&](const std::string_view text) {
+			if (auto *existing = std::get_if<std::string>(&value)) {
+				existing->assign(text);
+			} else {
+				value = std::string(text);
+			}
+		};
+		switch (statement.columnType(column)) {
+			case SQLITE_INTEGER: value = statement.columnInt64(column); break;
+			case SQLITE_FLOAT: value = statement.columnDouble(column); break;
+			case SQLITE_TEXT: assignText(statement.columnText(column)); break;
+			case SQLITE_BLOB: assignText(statement.columnBlob(column)); break;
+			default: value = std::monostate();
+		}
+	}
+
+	std::size_t valueBytes(const db::Value &value) {
+		const auto *text = std::get_if<std::string>(&value);
+		return sizeof(db::Value) + (text ? text->size() : 0);
+	}
+}
+
+db::QueryCacheStats &db::QueryCacheStats::operator+=(const QueryCacheStats &other) {
+	hits += other.hits;
+	misses += other.misses;
+	invalidations += other.invalidations;
+	evictions += other.evictions;
+	bypassed += other.bypassed;
+	entries += other.entries;
+	bytes += other.bytes;
+	return *this;
+}
+
+db::QueryCache::QueryCache(const Database &db, const std::size_t byteBudget)
+	: db(db), byteBudget(byteBudget), dataVersion(db.dataVersion()) {
+	db.setUpdateHook([this] { changed = true; });
+}
+
+db::QueryCache::~QueryCache() {
+	db.setUpdateHook({});
+}
+
+bool db::QueryCache::forEach(const std::string_view sql, const std::span<const Value> parameters,
+                             const std::function<bool(std::span<const Value>)> &onRow) {
+	// Inside a transaction the rows may not be committed yet, or belong to an older snapshot than the cache
+	const bool caching = !db.inTransaction();
+	std::string key;
+	if (caching) {
+		invalidateIfChanged();
+		key = normalizeSql(sql);
+		for (const Value &parameter: parameters) {
+			appendKey(key, parameter);
+		}
+
+		if (const auto found = index.find(key); found != index.end()) {
+			hits++;
+			entries.splice(entries.begin(), entries, found->second);
+			// Holding on to the rows keeps them alive even if onRow runs queries that evict them
+			const std::shared_ptr<const std::vector<Value>> values = found->second->values;
+			const std::size_t columns = found->second->columns;
+			for (std::size_t row = 0; row < values->size(); row += columns) {
+				if (!onRow(std::span(values->data() + row, columns))) {
+					return false;
+				}
+			}
+			return true;
+		}
+		misses++;
+	} else {
+		bypassed++;
+	}
+
+	Statement &statement = db.prepareCached(std::string(sql));
+	statement.reset();
+	for (std::size_t parameter = 0; parameter < parameters.size(); parameter++) {
+		bindValue(statement, static_cast<int>(parameter + 1), parameters[parameter]);
+	}
+
+	const auto columns = static_cast<std::size_t>(statement.columnCount());
+	std::vector<Value> row(columns);
+	std::vector<Value> kept;
+	std::size_t keptBytes = key.size() + entryOverhead;
+	bool keeping = caching;
+	try {
+		while (statement.step()) {
+			for (std::size_t column = 0; column < columns; column++) {
+				readColumn(statement, static_cast<int>(column), row[column]);
+			}
+			if (keeping) {
+				for (const Value &value: row) {
+					keptBytes += valueBytes(value);
+				}
+				kept.insert(kept.end(), row.begin(), row.end());
+				// Too big to keep, the rest is only passed through
+				if (keptBytes > byteBudget / 8) {
+					keeping = false;
+					kept = {};
+					bypassed++;
+				}
+			}
+			if (!onRow(row)) {
+				statement.reset();
+				return false;
+			}
+		}
+	} catch (...) {
+		statement.reset();
+		throw;
+	}
+	statement.reset();
+
+	// A write through this connection while the rows were handed out makes them stale already
+	if (keeping && !changed) {
+		insert(Entry{
+			std::move(key), columns, std::make_shared<const std::vector<Value>>(std::move(kept)), keptBytes
+		});
+	}
+	return true;
+}
+
+db::QueryCacheStats db::QueryCache::stats() const {
+	return QueryCacheStats{
+		.hits = hits, .misses = misses, .invalidations = invalidations, .evictions = evictions,
+		.bypassed = bypassed, .entries = entryCount, .bytes = byteCount
+	};
+}
+
+void db::QueryCache::clear() {
+	index.clear();
+	entries.clear();
+	bytes = 0;
+	entryCount = 0;
+	byteCount = 0;
+}
+
+void db::QueryCache::invalidateIfChanged() {
+	const std::int64_t version = db.dataVersion();
+	if (version == dataVersion && !changed) {
+		return;
+	}
+	dataVersion = version;
+	changed = false;
+	if (!entries.empty()) {
+		clear();
+		invalidations++;
+	}
+}
+
+void db::QueryCache::insert(Entry entry) {
+	while (!entries.empty() && bytes + entry.bytes > byteBudget) {
+		const Entry &oldest = entries.back();
+		bytes -= oldest.bytes;
+		index.erase(oldest.key);
+		entries.pop_back();
+		evictions++;
+	}
+	bytes += entry.bytes;
+	entries.push_front(std::move(entry));
+	index.emplace(entries.front().key, entries.begin());
+	entryCount = entries.size();
+	byteCount = bytes;
+}
+
+std::string db::normalizeSql(const std::string_view sql) {
+	std::string normalized;
+	normalized.reserve(sql.size());
+	char quote = 0;
+	bool space = false;
+	for (const char character: sql) {
+		if (quote) {
+			// A doubled quote ends and reopens the literal, which copies it unchanged as well
+			normalized += character;
+			quote = character == quote ? 0 : quote;
+			continue;
+		}
+		if (character == ' ' || character == '\t' || character == '\n' || character == '\r') {
+			space = !normalized.empty();
+			continue;
+		}
+		if (space) {
+			normalized += ' ';
+			space = false;
+		}
+		if (character == '\'' || character == '"' || character == '`') {
+			quote = character;
+		}
+		normalized += character;
+	}
+	return normalized;
+}
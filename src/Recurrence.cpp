@@ -0,0 +1,252 @@
+#include "Recurrence.h"
+
+#include "Tags.h"
+
+#include <array>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+	constexpr auto recurrencesSchema = R"(
+		CREATE TABLE recurrences (
+			id INTEGER PRIMARY KEY,
+			title TEXT NOT NULL,
+			description TEXT,
+			tags TEXT NOT NULL DEFAULT '',
+			unit TEXT NOT NULL CHECK (unit IN ('days', 'weeks', 'months')),
+			every INTEGER NOT NULL CHECK (every > 0),
+			firstDueAt INTEGER NOT NULL,
+			nextOccurrence INTEGER NOT NULL DEFAULT 0,
+			nextDueAt INTEGER NOT NULL
+		);
+		CREATE INDEX recurrencesNextDueAt ON recurrences (nextDueAt);
+
+		CREATE TABLE recurrenceInstances (
+			taskId INTEGER PRIMARY KEY,
+			recurrenceId INTEGER NOT NULL
+		);
+		CREATE INDEX recurrenceInstancesRecurrence ON recurrenceInstances (recurrenceId);
+
+		-- Completed and removed tasks are no open instances any more
+		CREATE TRIGGER recurrenceInstancesDelete AFTER DELETE ON tasks BEGIN
+			DELETE FROM recurrenceInstances WHERE taskId = OLD.id;
+		END;
+	)";
+
+	// When occurrence `index` is due. SQLite does the calendar, in local time, so months and DST come out right
+	std::int64_t occurrenceDueAt(const db::Database &db, const std::int64_t firstDueAt, const tike::RecurrenceRule &rule,
+	                             const std::int64_t index) {
+		const std::int64_t amount = index * rule.every * (rule.unit == "weeks" ? 7 : 1);
+		const std::string modifier = "+" + std::to_string(amount) + (rule.unit == "months" ? " months" : " days");
+
+		db::Statement statement = db.prepare("SELECT unixepoch(datetime(?, 'unixepoch', 'localtime', ?), 'utc')");
+		statement.bindInt64(1, firstDueAt).bind(2, modifier);
+		statement.step();
+		return statement.columnInt64(0);
+	}
+
+	// Creates the next occurrence of a template, returns the new task and when the occurrence after it is due
+	std::pair<std::int64_t, std::int64_t> createInstance(const db::Database &db, const std::int64_t recurrenceId) {
+		db::Statement recurrence = db.prepare(R"(
+			SELECT title, description, tags, unit, every, firstDueAt, nextOccurrence, nextDueAt
+			FROM recurrences WHERE id = ?
+		)");
+		recurrence.bindInt64(1, recurrenceId);
+		if (!recurrence.step()) {
+			throw std::invalid_argument("No recurring task with id " + std::to_string(recurrenceId));
+		}
+		const std::string title(recurrence.columnText(0));
+		const std::optional<std::string> description = recurrence.columnIsNull(1)
+			                                               ? std::nullopt
+			                                               : std::optional(std::string(recurrence.columnText(1)));
+		const std::string tags(recurrence.columnText(2));
+		const tike::RecurrenceRule rule{std::string(recurrence.columnText(3)), recurrence.columnInt64(4)};
+		const std::int64_t firstDueAt = recurrence.columnInt64(5);
+		const std::int64_t occurrence = recurrence.columnInt64(6);
+		const std::int64_t dueAt = recurrence.columnInt64(7);
+		recurrence.reset();
+
+		db::Statement task = db.prepare("INSERT INTO tasks (title, description, dueAt) VALUES (?, ?, ?)");
+		task.bind(1, title);
+		if (description) {
+			task.bind(2, *description);
+		} else {
+			task.bindNull(2);
+		}
+		task.bindInt64(3, dueAt);
+		task.step();
+		// Tagging inserts rows of its own, so the id has to be read first
+		const std::int64_t taskId = db.lastInsertId();
+
+		db::Statement instance = db.prepare("INSERT INTO recurrenceInstances (taskId, recurrenceId) VALUES (?, ?)");
+		instance.bindInt64(1, taskId).bindInt64(2, recurrenceId);
+		instance.step();
+		if (!tags.empty()) {
+			const std::array<std::string_view, 1> tagList = {tags};
+			tike::tagTask(db, taskId, tagList);
+		}
+
+		const std::int64_t nextDueAt = occurrenceDueAt(db, firstDueAt, rule, occurrence + 1);
+		db::Statement advance = db.prepare("UPDATE recurrences SET nextOccurrence = ?, nextDueAt = ? WHERE id = ?");
+		advance.bindInt64(1, occurrence + 1).bindInt64(2, nextDueAt).bindInt64(3, recurrenceId);
+		advance.step();
+		return {taskId, nextDueAt};
+	}
+
+	// The template a task was created from
+	std::optional<std::int64_t> recurrenceOf(const db::Database &db, const std::int64_t taskId) {
+		if (!db.hasTable("recurrenceInstances")) {
+			return std::nullopt;
+		}
+		db::Statement statement = db.prepare("SELECT recurrenceId FROM recurrenceInstances WHERE taskId = ?");
+		statement.bindInt64(1, taskId);
+		if (!statement.step()) {
+			return std::nullopt;
+		}
+		return statement.columnInt64(0);
+	}
+}
+
+tike::RecurrenceRule tike::parseRecurrenceRule(const std::string_view text) {
+	if (text == "daily") {
+		return {"days", 1};
+	}
+	if (text == "weekly") {
+		return {"weeks", 1};
+	}
+	if (text == "monthly") {
+		return {"months", 1};
+	}
+	if (text == "yearly") {
+		return {"months", 12};
+	}
+
+	// "N unit", the unit singular or plural
+	const std::size_t space = text.find(' ');
+	std::int64_t every = 0;
+	if (space != std::string_view::npos) {
+		const auto [end, error] = std::from_chars(text.data(), text.data() + space, every);
+		std::string unit(text.substr(space + 1));
+		if (!unit.empty() && unit.back() != 's') {
+			unit += 's';
+		}
+		if (error == std::errc() && end == text.data() + space && every > 0 &&
+		    (unit == "days" || unit == "weeks" || unit == "months")) {
+			return {unit, every};
+		}
+	}
+	throw std::invalid_argument(
+		"Invalid repeat rule, expected daily, weekly, monthly, yearly or e.g. \"3 days\": " + std::string(text));
+}
+
+void tike::ensureRecurrences(const db::Database &db) {
+	if (db.hasTable("recurrences")) {
+		return;
+	}
+
+	db::Transaction transaction(db);
+	if (!db.hasTable("recurrences")) {
+		db.execute(recurrencesSchema);
+	}
+	transaction.commit();
+}
+
+std::int64_t tike::addRecurrence(const db::Database &db, const RecurringTask &task) {
+	db::Statement statement = db.prepare(R"(
+		INSERT INTO recurrences (title, description, tags, unit, every, firstDueAt, nextDueAt)
+		VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?6)
+	)");
+	statement.bind(1, task.title);
+	if (task.description) {
+		statement.bind(2, *task.description);
+	} else {
+		statement.bindNull(2);
+	}
+	statement.bind(3, task.tags).bind(4, task.rule.unit).bindInt64(5, task.rule.every).bindInt64(6, task.firstDueAt);
+	statement.step();
+	return db.lastInsertId();
+}
+
+std::int64_t tike::materializeNext(const db::Database &db, const std::int64_t recurrenceId) {
+	return createInstance(db, recurrenceId).first;
+}
+
+bool tike::recurrencesDueBy(const db::Database &db, const std::int64_t until) {
+	if (!db.hasTable("recurrences")) {
+		return false;
+	}
+	db::Statement statement = db.prepare("SELECT 1 FROM recurrences WHERE nextDueAt <= ? LIMIT 1");
+	statement.bindInt64(1, until);
+	return statement.step();
+}
+
+std::int64_t tike::nextRecurrenceDue(const db::Database &db) {
+	if (!db.hasTable("recurrences")) {
+		return std::numeric_limits<std::int64_t>::max();
+	}
+	db::Statement statement = db.prepare("SELECT MIN(nextDueAt) FROM recurrences");
+	if (!statement.step() || statement.columnIsNull(0)) {
+		return std::numeric_limits<std::int64_t>::max();
+	}
+	return statement.columnInt64(0);
+}
+
+std::int64_t tike::materializeDueBy(const db::Database &db, const std::int64_t until) {
+	if (!db.hasTable("recurrences")) {
+		return 0;
+	}
+
+	// Collect first, creating instances updates the rows the scan walks over
+	db::Statement due = db.prepare("SELECT id FROM recurrences WHERE nextDueAt <= ? ORDER BY nextDueAt, id");
+	due.bindInt64(1, until);
+	std::vector<std::int64_t> recurrenceIds;
+	while (due.step()) {
+		recurrenceIds.push_back(due.columnInt64(0));
+	}
+
+	std::int64_t created = 0;
+	for (const std::int64_t recurrenceId: recurrenceIds) {
+		std::int64_t nextDueAt;
+		do {
+			nextDueAt = createInstance(db, recurrenceId).second;
+			created++;
+		} while (nextDueAt <= until);
+	}
+	return created;
+}
+
+std::optional<std::int64_t> tike::completeInstance(const db::Database &db, const std::int64_t taskId) {
+	const std::optional<std::int64_t> recurrenceId = recurrenceOf(db, taskId);
+	if (!recurrenceId) {
+		return std::nullopt;
+	}
+
+	db::Statement otherOpen = db.prepare(R"(
+		SELECT 1 FROM recurrenceInstances i JOIN tasks t ON t.id = i.taskId
+		WHERE i.recurrenceId = ? AND i.taskId != ?
+		LIMIT 1
+	)");
+	otherOpen.bindInt64(1, *recurrenceId).bindInt64(2, taskId);
+	if (otherOpen.step()) {
+		return std::nullopt;
+	}
+	return materializeNext(db, *recurrenceId);
+}
+
+bool tike::stopRecurrence(const db::Database &db, const std::int64_t taskId) {
+	const std::optional<std::int64_t> recurrenceId = recurrenceOf(db, taskId);
+	if (!recurrenceId) {
+		return false;
+	}
+
+	db::Statement instances = db.prepare("DELETE FROM recurrenceInstances WHERE recurrenceId = ?");
+	instances.bindInt64(1, *recurrenceId);
+	instances.step();
+	db::Statement recurrence = db.prepare("DELETE FROM recurrences WHERE id = ?");
+	recurrence.bindInt64(1, *recurrenceId);
+	recurrence.step();
+	return true;
+}
@@ -0,0 +1,168 @@
+#include "Reminders.h"
+
+#include "TimerWheel.h"
+
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+	// Changes are only recorded while a reminder loop is registered, nothing else reads them
+	constexpr auto dueDatesSchema = R"(
+		CREATE INDEX tasksDueAt ON tasks (dueAt) WHERE dueAt IS NOT NULL;
+
+		CREATE TABLE dueChanges (taskId INTEGER NOT NULL);
+		CREATE TABLE reminderLoops (id INTEGER PRIMARY KEY AUTOINCREMENT);
+
+		CREATE TRIGGER dueChangesInsert AFTER INSERT ON tasks
+		WHEN NEW.dueAt IS NOT NULL AND EXISTS (SELECT 1 FROM reminderLoops) BEGIN
+			INSERT INTO dueChanges (taskId) VALUES (NEW.id);
+		END;
+		CREATE TRIGGER dueChangesUpdate AFTER UPDATE OF dueAt ON tasks
+		WHEN OLD.dueAt IS NOT NEW.dueAt AND EXISTS (SELECT 1 FROM reminderLoops) BEGIN
+			INSERT INTO dueChanges (taskId) VALUES (NEW.id);
+		END;
+		CREATE TRIGGER dueChangesDelete AFTER DELETE ON tasks
+		WHEN OLD.dueAt IS NOT NULL AND EXISTS (SELECT 1 FROM reminderLoops) BEGIN
+			INSERT INTO dueChanges (taskId) VALUES (OLD.id);
+		END;
+	)";
+
+	// How often the loop wakes up, which is also how late a reminder can be
+	constexpr auto pollInterval = std::chrono::seconds(1);
+
+	std::int64_t unixNow() {
+		return std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	volatile std::sig_atomic_t stopRequested = 0;
+
+	void onStop(int) {
+		stopRequested = 1;
+	}
+}
+
+void tike::ensureDueDates(const db::Database &db) {
+	if (db.hasTable("dueChanges")) {
+		return;
+	}
+
+	db::Transaction transaction(db);
+	if (!db.hasTable("dueChanges")) {
+		if (!db.hasColumn("tasks", "dueAt")) {
+			db.execute("ALTER TABLE tasks ADD COLUMN dueAt INTEGER");
+		}
+		db.execute(dueDatesSchema);
+	}
+	transaction.commit();
+}
+
+void tike::setDueDate(const db::Database &db, const std::int64_t taskId, const std::optional<std::int64_t> dueAt) {
+	db::Statement statement = db.prepare("UPDATE tasks SET dueAt = ? WHERE id = ?");
+	if (dueAt) {
+		statement.bindInt64(1, *dueAt);
+	} else {
+		statement.bindNull(1);
+	}
+	statement.bindInt64(2, taskId);
+	statement.step();
+}
+
+void tike::runReminders(const db::Database &db, const std::function<void(const Reminder &)> &remind) {
+	const std::int64_t startedAt = unixNow();
+	TimerWheel wheel(startedAt);
+	std::unordered_map<std::int64_t, TimerWheel::Handle> scheduled;
+
+	// Ctrl+C ends the loop between two wakeups, so it can unregister
+	stopRequested = 0;
+	std::signal(SIGINT, onStop);
+	std::signal(SIGTERM, onStop);
+
+	// Everything still to come, in one range scan. Older changes are part of what it sees, so they are dropped.
+	// Registering replaces the registration of any other loop, a loop that was killed never removed its own
+	std::int64_t loopId = 0;
+	{
+		db::Transaction transaction(db);
+		db.execute("DELETE FROM reminderLoops; INSERT INTO reminderLoops DEFAULT VALUES");
+		loopId = db.lastInsertId();
+		db.execute("DELETE FROM dueChanges");
+		db::Statement upcoming = db.prepare("SELECT id, dueAt FROM tasks WHERE dueAt > ? ORDER BY dueAt");
+		upcoming.bindInt64(1, startedAt);
+		while (upcoming.step()) {
+			const std::int64_t taskId = upcoming.columnInt64(0);
+			scheduled[taskId] = wheel.schedule(upcoming.columnInt64(1), taskId);
+		}
+		transaction.commit();
+	}
+
+	db::Statement changes = db.prepare("SELECT rowid, taskId FROM dueChanges ORDER BY rowid");
+	db::Statement clearChanges = db.prepare("DELETE FROM dueChanges WHERE rowid <= ?");
+	db::Statement dueOf = db.prepare("SELECT dueAt FROM tasks WHERE id = ? AND dueAt IS NOT NULL");
+	db::Statement taskOf = db.prepare(
+		"SELECT (SELECT COUNT(*) FROM tasks WHERE id <= t.id), title, dueAt FROM tasks t WHERE id = ?");
+
+	std::int64_t dataVersion = db.dataVersion();
+	std::int64_t lastLook = startedAt;
+	while (!stopRequested) {
+		std::this_thread::sleep_for(pollInterval);
+		const std::int64_t now = unixNow();
+
+		// Only another connection committing moves data_version, so a quiet database costs one pragma per wakeup
+		if (const std::int64_t version = db.dataVersion(); version != dataVersion) {
+			dataVersion = version;
+			db::Transaction transaction(db);
+			std::int64_t lastChange = 0;
+			while (changes.step()) {
+				lastChange = changes.columnInt64(0);
+				const std::int64_t taskId = changes.columnInt64(1);
+				if (const auto found = scheduled.find(taskId); found != scheduled.end()) {
+					wheel.cancel(found->second);
+					scheduled.erase(found);
+				}
+
+				// Due dates that passed since the last look still fire, older ones were never waited for
+				dueOf.bindInt64(1, taskId);
+				if (dueOf.step() && dueOf.columnInt64(0) > lastLook) {
+					scheduled[taskId] = wheel.schedule(dueOf.columnInt64(0), taskId);
+				}
+				dueOf.reset();
+			}
+			changes.reset();
+			clearChanges.bindInt64(1, lastChange);
+			clearChanges.step();
+			clearChanges.reset();
+			transaction.commit();
+		}
+
+		for (const std::int64_t taskId: wheel.advance(now)) {
+			scheduled.erase(taskId);
+			taskOf.bindInt64(1, taskId);
+			std::optional<Reminder> reminder;
+			if (taskOf.step()) {
+				reminder = Reminder{
+					.taskId = taskId,
+					.pseudoId = taskOf.columnInt64(0),
+					.title = std::string(taskOf.columnText(1)),
+					.dueAt = taskOf.columnInt64(2)
+				};
+			}
+			// A statement that isn't reset keeps its read lock, which would block every writer while the loop sleeps
+			taskOf.reset();
+			if (reminder) {
+				remind(*reminder);
+			}
+		}
+		lastLook = now;
+	}
+
+	std::signal(SIGINT, SIG_DFL);
+	std::signal(SIGTERM, SIG_DFL);
+	db::Transaction transaction(db);
+	db::Statement unregister = db.prepare("DELETE FROM reminderLoops WHERE id = ?");
+	unregister.bindInt64(1, loopId);
+	unregister.step();
+	db.execute("DELETE FROM dueChanges WHERE NOT EXISTS (SELECT 1 FROM reminderLoops)");
+	transaction.commit();
+}
@@ -0,0 +1,397 @@
+#include "RoaringBitmap.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace {
+	// "RBM" and a format version
+	constexpr std::uint32_t bitmapMagic = 0x014D4252;
+
+	enum ContainerKind : std::uint8_t {
+		ArrayKind = 0,
+		BitmapKind = 1
+	};
+
+	void putBytes(std::string &out, const std::uint64_t value, const int size) {
+		for (int shift = 0; shift < size * 8; shift += 8) {
+			out.push_back(static_cast<char>(value >> shift & 0xFF));
+		}
+	}
+
+	std::uint64_t readBytes(const std::string_view bytes, const std::size_t offset, const int size) {
+		std::uint64_t value = 0;
+		for (int index = size - 1; index >= 0; index--) {
+			value = value << 8 | static_cast<unsigned char>(bytes[offset + index]);
+		}
+		return value;
+	}
+
+	constexpr std::uint16_t high(const std::uint32_t value) {
+		return static_cast<std::uint16_t>(value >> 16);
+	}
+
+	constexpr std::uint16_t low(const std::uint32_t value) {
+		return static_cast<std::uint16_t>(value & 0xFFFF);
+	}
+
+	constexpr bool testBit(const std::vector<std::uint64_t> &words, const std::uint16_t bit) {
+		return (words[bit / 64] >> (bit % 64) & 1) != 0;
+	}
+}
+
+std::size_t tike::RoaringBitmap::lowerBound(const std::uint16_t key) const {
+	return std::ranges::lower_bound(containers, key, {}, &Container::key) - containers.begin();
+}
+
+std::vector<std::uint64_t> tike::RoaringBitmap::toWords(const Container &container) {
+	if (container.isBitmap()) {
+		return container.words;
+	}
+	std::vector<std::uint64_t> words(bitmapWords);
+	for (const std::uint16_t value: container.array) {
+		words[value / 64] |= std::uint64_t{1} << (value % 64);
+	}
+	return words;
+}
+
+void tike::RoaringBitmap::normalize(Container &container) {
+	if (!container.isBitmap()) {
+		container.cardinality = static_cast<std::uint32_t>(container.array.size());
+		if (container.cardinality > arrayLimit) {
+			container.words = toWords(container);
+			container.array = {};
+		}
+		return;
+	}
+
+	container.cardinality = 0;
+	for (const std::uint64_t word: container.words) {
+		container.cardinality += std::popcount(word);
+	}
+	if (container.cardinality <= arrayLimit) {
+		container.array.clear();
+		container.array.reserve(container.cardinality);
+		for (std::size_t index = 0; index < bitmapWords; index++) {
+			for (std::uint64_t word = container.words[index]; word != 0; word &= word - 1) {
+				container.array.push_back(static_cast<std::uint16_t>(index * 64 + std::countr_zero(word)));
+			}
+		}
+		container.words = {};
+	}
+}
+
+void tike::RoaringBitmap::add(const std::uint32_t value) {
+	const std::size_t position = lowerBound(high(value));
+	if (position == containers.size() || containers[position].key != high(value)) {
+		containers.insert(containers.begin() + static_cast<std::ptrdiff_t>(position),
+		                  Container{.key = high(value), .cardinality = 1, .array = {low(value)}});
+		return;
+	}
+
+	Container &container = containers[position];
+	if (container.isBitmap()) {
+		std::uint64_t &word = container.words[low(value) / 64];
+		const std::uint64_t bit = std::uint64_t{1} << (low(value) % 64);
+		if ((word & bit) == 0) {
+			word |= bit;
+			container.cardinality++;
+		}
+		return;
+	}
+
+	const auto found = std::ranges::lower_bound(container.array, low(value));
+	if (found == container.array.end() || *found != low(value)) {
+		container.array.insert(found, low(value));
+		normalize(container);
+	}
+}
+
+void tike::RoaringBitmap::remove(const std::uint32_t value) {
+	const std::size_t position = lowerBound(high(value));
+	if (position == containers.size() || containers[position].key != high(value)) {
+		return;
+	}
+
+	Container &container = containers[position];
+	if (container.isBitmap()) {
+		std::uint64_t &word = container.words[low(value) / 64];
+		const std::uint64_t bit = std::uint64_t{1} << (low(value) % 64);
+		if ((word & bit) == 0) {
+			return;
+		}
+		word &= ~bit;
+		if (--container.cardinality <= arrayLimit) {
+			normalize(container);
+		}
+	} else {
+		const auto found = std::ranges::lower_bound(container.array, low(value));
+		if (found == container.array.end() || *found != low(value)) {
+			return;
+		}
+		container.array.erase(found);
+		container.cardinality--;
+	}
+
+	if (container.cardinality == 0) {
+		containers.erase(containers.begin() + static_cast<std::ptrdiff_t>(position));
+	}
+}
+
+bool tike::RoaringBitmap::contains(const std::uint32_t value) const {
+	const std::size_t position = lowerBound(high(value));
+	if (position == containers.size() || containers[position].key != high(value)) {
+		return false;
+	}
+	const Container &container = containers[position];
+	return container.isBitmap() ? testBit(container.words, low(value))
+	                            : std::ranges::binary_search(container.array, low(value));
+}
+
+bool tike::RoaringBitmap::empty() const {
+	return containers.empty();
+}
+
+std::uint64_t tike::RoaringBitmap::cardinality() const {
+	std::uint64_t total = 0;
+	for (const auto &container: containers) {
+		total += container.cardinality;
+	}
+	return total;
+}
+
+std::uint64_t tike::RoaringBitmap::rank(const std::uint32_t value) const {
+	std::uint64_t total = 0;
+	for (const auto &container: containers) {
+		if (container.key < high(value)) {
+			total += container.cardinality;
+			continue;
+		}
+		if (container.key > high(value)) {
+			break;
+		}
+
+		// The container holding value, count its values up to and including the low bits
+		if (!container.isBitmap()) {
+			total += std::ranges::upper_bound(container.array, low(value)) - container.array.begin();
+			break;
+		}
+		const std::size_t lastWord = low(value) / 64;
+		for (std::size_t index = 0; index < lastWord; index++) {
+			total += std::popcount(container.words[index]);
+		}
+		const int bits = low(value) % 64 + 1;
+		const std::uint64_t mask = bits == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+		total += std::popcount(container.words[lastWord] & mask);
+		break;
+	}
+	return total;
+}
+
+std::vector<std::uint32_t> tike::RoaringBitmap::values() const {
+	std::vector<std::uint32_t> result;
+	result.reserve(cardinality());
+	for (const auto &container: containers) {
+		const std::uint32_t base = static_cast<std::uint32_t>(container.key) << 16;
+		if (!container.isBitmap()) {
+			for (const std::uint16_t value: container.array) {
+				result.push_back(base | value);
+			}
+			continue;
+		}
+		for (std::size_t index = 0; index < bitmapWords; index++) {
+			for (std::uint64_t word = container.words[index]; word != 0; word &= word - 1) {
+				result.push_back(base | static_cast<std::uint32_t>(index * 64 + std::countr_zero(word)));
+			}
+		}
+	}
+	return result;
+}
+
+tike::RoaringBitmap &tike::RoaringBitmap::operator&=(const RoaringBitmap &other) {
+	std::vector<Container> result;
+	auto mine = containers.begin();
+	auto theirs = other.containers.begin();
+	while (mine != containers.end() && theirs != other.containers.end()) {
+		if (mine->key < theirs->key) {
+			++mine;
+			continue;
+		}
+		if (theirs->key < mine->key) {
+			++theirs;
+			continue;
+		}
+
+		Container container{.key = mine->key};
+		if (mine->isBitmap() && theirs->isBitmap()) {
+			container.words = mine->words;
+			for (std::size_t index = 0; index < bitmapWords; index++) {
+				container.words[index] &= theirs->words[index];
+			}
+		} else if (!mine->isBitmap() && !theirs->isBitmap()) {
+			std::ranges::set_intersection(mine->array, theirs->array, std::back_inserter(container.array));
+		} else {
+			// An array and a bitmap: keep the array values whose bit is set
+			const Container &array = mine->isBitmap() ? *theirs : *mine;
+			const Container &bitmap = mine->isBitmap() ? *mine : *theirs;
+			std::ranges::copy_if(array.array, std::back_inserter(container.array), [&bitmap](const std::uint16_t value) {
+				return testBit(bitmap.words, value);
+			});
+		}
+		normalize(container);
+		if (container.cardinality > 0) {
+			result.push_back(std::move(container));
+		}
+		++mine;
+		++theirs;
+	}
+	containers = std::move(result);
+	return *this;
+}
+
+tike::RoaringBitmap &tike::RoaringBitmap::operator|=(const RoaringBitmap &other) {
+	std::vector<Container> result;
+	result.reserve(containers.size() + other.containers.size());
+	auto mine = containers.begin();
+	auto theirs = other.containers.begin();
+	while (mine != containers.end() || theirs != other.containers.end()) {
+		if (theirs == other.containers.end() || (mine != containers.end() && mine->key < theirs->key)) {
+			result.push_back(std::move(*mine++));
+			continue;
+		}
+		if (mine == containers.end() || theirs->key < mine->key) {
+			result.push_back(*theirs++);
+			continue;
+		}
+
+		Container container{.key = mine->key};
+		if (!mine->isBitmap() && !theirs->isBitmap()) {
+			std::ranges::set_union(mine->array, theirs->array, std::back_inserter(container.array));
+		} else {
+			container.words = toWords(*mine);
+			const std::vector<std::uint64_t> words = toWords(*theirs);
+			for (std::size_t index = 0; index < bitmapWords; index++) {
+				container.words[index] |= words[index];
+			}
+		}
+		normalize(container);
+		result.push_back(std::move(container));
+		++mine;
+		++theirs;
+	}
+	containers = std::move(result);
+	return *this;
+}
+
+tike::RoaringBitmap &tike::RoaringBitmap::operator-=(const RoaringBitmap &other) {
+	std::vector<Container> result;
+	result.reserve(containers.size());
+	auto theirs = other.containers.begin();
+	for (auto &container: containers) {
+		while (theirs != other.containers.end() && theirs->key < container.key) {
+			++theirs;
+		}
+		if (theirs == other.containers.end() || theirs->key != container.key) {
+			result.push_back(std::move(container));
+			continue;
+		}
+
+		if (container.isBitmap()) {
+			const std::vector<std::uint64_t> words = toWords(*theirs);
+			for (std::size_t index = 0; index < bitmapWords; index++) {
+				container.words[index] &= ~words[index];
+			}
+		} else if (theirs->isBitmap()) {
+			std::erase_if(container.array, [&theirs](const std::uint16_t value) {
+				return testBit(theirs->words, value);
+			});
+		} else {
+			std::vector<std::uint16_t> difference;
+			std::ranges::set_difference(container.array, theirs->array, std::back_inserter(difference));
+			container.array = std::move(difference);
+		}
+		normalize(container);
+		if (container.cardinality > 0) {
+			result.push_back(std::move(container));
+		}
+	}
+	containers = std::move(result);
+	return *this;
+}
+
+std::string tike::RoaringBitmap::serialize() const {
+	// Header, then per container its key, kind and cardinality followed by the array or the bitmap words,
+	// everything little-endian
+	std::string bytes;
+	putBytes(bytes, bitmapMagic, 4);
+	putBytes(bytes, containers.size(), 4);
+	for (const auto &container: containers) {
+		putBytes(bytes, container.key, 2);
+		putBytes(bytes, container.isBitmap() ? BitmapKind : ArrayKind, 1);
+		putBytes(bytes, container.cardinality, 4);
+		if (container.isBitmap()) {
+			for (const std::uint64_t word: container.words) {
+				putBytes(bytes, word, 8);
+			}
+		} else {
+			for (const std::uint16_t value: container.array) {
+				putBytes(bytes, value, 2);
+			}
+		}
+	}
+	return bytes;
+}
+
+std::optional<tike::RoaringBitmap> tike::RoaringBitmap::deserialize(const std::string_view bytes) {
+	if (bytes.size() < 8 || readBytes(bytes, 0, 4) != bitmapMagic) {
+		return std::nullopt;
+	}
+
+	RoaringBitmap bitmap;
+	const std::uint64_t count = readBytes(bytes, 4, 4);
+	std::size_t offset = 8;
+	for (std::uint64_t index = 0; index < count; index++) {
+		if (bytes.size() - offset < 7) {
+			return std::nullopt;
+		}
+		Container container{.key = static_cast<std::uint16_t>(readBytes(bytes, offset, 2))};
+		const auto kind = static_cast<std::uint8_t>(readBytes(bytes, offset + 2, 1));
+		const std::uint64_t cardinality = readBytes(bytes, offset + 3, 4);
+		offset += 7;
+
+		const std::size_t payload = kind == BitmapKind ? bitmapWords * 8 : cardinality * 2;
+		if (kind > BitmapKind || cardinality == 0 || cardinality > 65536 || bytes.size() - offset < payload) {
+			return std::nullopt;
+		}
+		if (!bitmap.containers.empty() && bitmap.containers.back().key >= container.key) {
+			return std::nullopt;
+		}
+
+		if (kind == BitmapKind) {
+			container.words.resize(bitmapWords);
+			for (std::size_t word = 0; word < bitmapWords; word++) {
+				container.words[word] = readBytes(bytes, offset + word * 8, 8);
+			}
+		} else {
+			container.array.resize(cardinality);
+			for (std::size_t value = 0; value < cardinality; value++) {
+				container.array[value] = static_cast<std::uint16_t>(readBytes(bytes, offset + value * 2, 2));
+			}
+			if (std::ranges::adjacent_find(container.array, std::ranges::greater_equal()) != container.array.end()) {
+				return std::nullopt;
+			}
+		}
+		offset += payload;
+
+		// Recounting also brings the container into its canonical form
+		normalize(container);
+		if (container.cardinality != cardinality) {
+			return std::nullopt;
+		}
+		bitmap.containers.push_back(std::move(container));
+	}
+	if (offset != bytes.size()) {
+		return std::nullopt;
+	}
+	return bitmap;
+}
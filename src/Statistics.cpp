@@ -0,0 +1,137 @@
+#include "Statistics.h"
+
+namespace {
+	// Tables, seeded from the existing rows, then the triggers keeping them current. Runs once per database. A time
+	// julianday() can't read counts as 0 and has no day, the same in the triggers as in the seeding queries
+	constexpr auto statisticsSchema = R"(
+		CREATE TABLE taskStats (
+			id INTEGER PRIMARY KEY CHECK (id = 1),
+			openCount INTEGER NOT NULL,
+			completedCount INTEGER NOT NULL,
+			openCreatedSum REAL NOT NULL,
+			leadTimeSum REAL NOT NULL
+		);
+
+		CREATE TABLE dailyStats (
+			day TEXT PRIMARY KEY,
+			created INTEGER NOT NULL DEFAULT 0,
+			completed INTEGER NOT NULL DEFAULT 0
+		) WITHOUT ROWID;
+
+		INSERT INTO taskStats (id, openCount, completedCount, openCreatedSum, leadTimeSum)
+		SELECT 1,
+		       (SELECT COUNT(*) FROM tasks),
+		       (SELECT COUNT(*) FROM completedTasks),
+		       (SELECT COALESCE(SUM(julianday(timeCreated)), 0) FROM tasks),
+		       (SELECT COALESCE(SUM(julianday(timeCompleted) - julianday(timeCreated)), 0) FROM completedTasks);
+
+		INSERT INTO dailyStats (day, created)
+		SELECT date(timeCreated), COUNT(*)
+		FROM (SELECT timeCreated FROM tasks UNION ALL SELECT timeCreated FROM completedTasks)
+		WHERE timeCreated IS NOT NULL
+		GROUP BY 1;
+
+		INSERT INTO dailyStats (day, completed)
+		SELECT date(timeCompleted), COUNT(*) FROM completedTasks WHERE timeCompleted IS NOT NULL GROUP BY 1
+		ON CONFLICT (day) DO UPDATE SET completed = excluded.completed;
+
+		CREATE TRIGGER tasksInsertStats AFTER INSERT ON tasks BEGIN
+			UPDATE taskStats
+			SET openCount = openCount + 1, openCreatedSum = openCreatedSum + COALESCE(julianday(NEW.timeCreated), 0)
+			WHERE id = 1;
+			INSERT INTO dailyStats (day, created) SELECT date(NEW.timeCreated), 1 WHERE date(NEW.timeCreated) IS NOT NULL
+			ON CONFLICT (day) DO UPDATE SET created = created + 1;
+		END;
+
+		CREATE TRIGGER tasksDeleteStats AFTER DELETE ON tasks BEGIN
+			UPDATE taskStats
+			SET openCount = openCount - 1, openCreatedSum = openCreatedSum - COALESCE(julianday(OLD.timeCreated), 0)
+			WHERE id = 1;
+		END;
+
+		CREATE TRIGGER completedTasksInsertStats AFTER INSERT ON completedTasks BEGIN
+			UPDATE taskStats
+			SET completedCount = completedCount + 1,
+			    leadTimeSum = leadTimeSum + COALESCE(julianday(NEW.timeCompleted) - julianday(NEW.timeCreated), 0)
+			WHERE id = 1;
+			INSERT INTO dailyStats (day, completed) SELECT date(NEW.timeCompleted), 1 WHERE date(NEW.timeCompleted) IS NOT NULL
+			ON CONFLICT (day) DO UPDATE SET completed = completed + 1;
+		END;
+
+		CREATE TRIGGER completedTasksDeleteStats AFTER DELETE ON completedTasks BEGIN
+			UPDATE taskStats
+			SET completedCount = completedCount - 1,
+			    leadTimeSum = leadTimeSum - COALESCE(julianday(OLD.timeCompleted) - julianday(OLD.timeCreated), 0)
+			WHERE id = 1;
+			UPDATE dailyStats SET completed = completed - 1 WHERE day = date(OLD.timeCompleted);
+		END;
+	)";
+}
+
+void tike::ensureStatistics(const db::Database &db) {
+	if (db.hasTable("taskStats")) {
+		return;
+	}
+
+	db::Transaction transaction(db);
+	// Another process may have created them while we waited for the write lock
+	if (!db.hasTable("taskStats")) {
+		db.execute(statisticsSchema);
+	}
+	transaction.commit();
+}
+
+db::TaskCounts tike::readTaskCounts(const db::Database &db) {
+	if (!db.hasTable("taskStats")) {
+		return {db.countRecords("tasks"), db.countRecords("completedTasks")};
+	}
+
+	db::Statement statement = db.prepare("SELECT openCount, completedCount FROM taskStats WHERE id = 1");
+	if (!statement.step()) {
+		return {};
+	}
+	return {statement.columnInt64(0), statement.columnInt64(1)};
+}
+
+tike::Summary tike::readSummary(const db::Database &db, const int days) {
+	// Everything is in UTC, like the timestamps. Weeks start on Monday
+	db::Statement statement = db.prepare(R"(
+		SELECT s.openCount, s.completedCount, s.openCreatedSum, s.leadTimeSum, julianday('now'),
+		       (SELECT COALESCE(SUM(created), 0) FROM dailyStats WHERE day = date('now')),
+		       (SELECT COALESCE(SUM(completed), 0) FROM dailyStats WHERE day = date('now')),
+		       (SELECT COALESCE(SUM(completed), 0) FROM dailyStats
+		        WHERE day >= date('now', 'weekday 0', '-6 days')),
+		       (SELECT COALESCE(SUM(completed), 0) FROM dailyStats
+		        WHERE day > date('now', '-' || ? || ' days'))
+		FROM taskStats s
+		WHERE s.id = 1
+	)");
+	statement.bindInt64(1, days);
+
+	Summary summary;
+	if (!statement.step()) {
+		return summary;
+	}
+
+	summary.open = statement.columnInt64(0);
+	summary.completed = statement.columnInt64(1);
+	const double openCreatedSum = statement.columnDouble(2);
+	const double leadTimeSum = statement.columnDouble(3);
+	const double now = statement.columnDouble(4);
+	summary.createdToday = statement.columnInt64(5);
+	summary.completedToday = statement.columnInt64(6);
+	summary.completedThisWeek = statement.columnInt64(7);
+
+	const auto completedInPeriod = static_cast<double>(statement.columnInt64(8));
+	summary.completedPerDay = completedInPeriod / days;
+	summary.completedPerWeek = completedInPeriod / days * 7;
+
+	// The average of (now - created) is now minus the average of created
+	if (summary.open > 0) {
+		summary.averageAge = now - openCreatedSum / static_cast<double>(summary.open);
+	}
+	if (summary.completed > 0) {
+		summary.averageLeadTime = leadTimeSum / static_cast<double>(summary.completed);
+	}
+	return summary;
+}
@@ -0,0 +1,449 @@
+#include "StorageTuner.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// The scratch copy is padded to this many rows, so small databases are measured at a size worth tuning for
+	constexpr std::int64_t scratchRows = 20000;
+	// Each journal candidate commits this often, or for as long as commitTimeLimit, whichever ends first
+	constexpr int commitRounds = 40;
+	constexpr auto commitTimeLimit = std::chrono::milliseconds(1500);
+	constexpr int fsyncRounds = 20;
+	constexpr int readLookups = 2000;
+	constexpr int readRounds = 3;
+	constexpr std::int64_t tunedMmapSize = 256 * 1024 * 1024;
+	constexpr std::int64_t pageSizes[] = {4096, 8192, 16384};
+
+	double millisecondsSince(const Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	std::string lowerCase(std::string text) {
+		std::ranges::transform(text, text.begin(), [](const unsigned char character) {
+			return static_cast<char>(std::tolower(character));
+		});
+		return text;
+	}
+
+	std::string upperCase(std::string text) {
+		std::ranges::transform(text, text.begin(), [](const unsigned char character) {
+			return static_cast<char>(std::toupper(character));
+		});
+		return text;
+	}
+
+	// The scratch database and its journals, removed again however the benchmark ends
+	class ScratchFiles {
+	public:
+		explicit ScratchFiles(std::string path) : path(std::move(path)) {
+			// Left over by a benchmark that was killed, VACUUM INTO won't overwrite it
+			remove();
+		}
+
+		~ScratchFiles() {
+			remove();
+		}
+
+		ScratchFiles(const ScratchFiles &) = delete;
+
+		ScratchFiles &operator=(const ScratchFiles &) = delete;
+
+	private:
+		std::string path;
+
+		void remove() const {
+			for (const char *suffix: {"", "-journal", "-wal", "-shm"}) {
+				std::remove((path + suffix).c_str());
+			}
+		}
+	};
+
+	std::int64_t pragmaInteger(const db::Database &db, const std::string &pragma) {
+		db::Statement statement = db.prepare("PRAGMA " + pragma);
+		return statement.step() ? statement.columnInt64(0) : 0;
+	}
+
+	// Sets the journal mode and checks that it took, switching fails while another connection has the file open
+	void setJournalMode(const db::Database &db, const std::string &mode) {
+		db::Statement statement = db.prepare("PRAGMA journal_mode = " + mode);
+		if (!statement.step() || upperCase(std::string(statement.columnText(0))) != mode) {
+			throw std::runtime_error("Could not switch the journal to " + lowerCase(mode) +
+			                         ", close other tike processes using the database and try again");
+		}
+	}
+
+	void useSettings(const db::Database &db, const std::string &journalMode, const std::string &synchronous) {
+		setJournalMode(db, journalMode);
+		db.execute("PRAGMA synchronous = " + synchronous);
+	}
+
+	// The median time to flush a small write, what a durable commit waits for at least once
+	std::optional<double> fsyncLatency(const std::string &path) {
+#ifdef _WIN32
+		return std::nullopt;
+#else
+		const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			return std::nullopt;
+		}
+		char block[4096] = {};
+		std::vector<double> times;
+		for (int round = 0; round < fsyncRounds; round++) {
+			block[0] = static_cast<char>(round);
+			const Clock::time_point start = Clock::now();
+			if (::pwrite(fd, block, sizeof(block), 0) != static_cast<ssize_t>(sizeof(block))) {
+				break;
+			}
+#ifdef __linux__
+			const int flushed = ::fdatasync(fd);
+#else
+			const int flushed = ::fsync(fd);
+#endif
+			if (flushed != 0) {
+				break;
+			}
+			times.push_back(millisecondsSince(start));
+		}
+		::close(fd);
+		std::remove(path.c_str());
+
+		if (times.empty()) {
+			return std::nullopt;
+		}
+		std::ranges::nth_element(times, times.begin() + static_cast<std::ptrdiff_t>(times.size() / 2));
+		return times[times.size() / 2];
+#endif
+	}
+
+	// SQLite's WAL index lives in shared memory, which network filesystems don't share between machines
+	bool onNetworkFilesystem(const std::string &dbPath) {
+#ifdef __linux__
+		struct statfs info{};
+		if (::statfs(dbPath.c_str(), &info) != 0) {
+			return false;
+		}
+		switch (static_cast<unsigned long>(info.f_type)) {
+			case 0x6969: // NFS
+			case 0x517B: // SMB
+			case 0xFF534D42: // CIFS
+			case 0xFE534D42: // SMB2
+				return true;
+			default:
+				return false;
+		}
+#else
+		static_cast<void>(dbPath);
+		return false;
+#endif
+	}
+
+	// What the process caused to be written to the disk so far, journals and checkpoints included. Not what it
+	// passed to write(), most of that is overwritten in the page cache before it is flushed. Empty without the
+	// kernel's I/O accounting
+	std::optional<std::uint64_t> bytesWritten() {
+#ifdef __linux__
+		std::ifstream io("/proc/self/io");
+		std::string name;
+		std::uint64_t value = 0;
+		while (io >> name >> value) {
+			if (name == "write_bytes:") {
+				return value;
+			}
+		}
+#endif
+		return std::nullopt;
+	}
+
+	struct CommitCost {
+		double milliseconds;
+		std::optional<double> bytes;
+	};
+
+	// Small transactions like the ones tike's commands make: add a task, change another
+	CommitCost measureCommits(const db::Database &db, const int rounds) {
+		db::Statement &insert = db.prepareCached(
+			"INSERT INTO tuneRows (title, description, timeCreated) VALUES (?, ?, CURRENT_TIMESTAMP)");
+		db::Statement &update = db.prepareCached("UPDATE tuneRows SET title = ? WHERE id = ?");
+		std::mt19937_64 random(rounds);
+		std::uniform_int_distribution<std::int64_t> ids(1, scratchRows);
+
+		const std::optional<std::uint64_t> writtenBefore = bytesWritten();
+		const Clock::time_point start = Clock::now();
+		int done = 0;
+		while (done < rounds && (done < 5 || Clock::now() - start < commitTimeLimit)) {
+			db::Transaction transaction(db);
+			insert.bind(1, std::string("Benchmark task ") + std::to_string(done));
+			insert.bind(2, std::string("Written by tike --tune to measure commits"));
+			insert.step();
+			insert.reset();
+			update.bind(1, std::string("Changed by tike --tune"));
+			update.bindInt64(2, ids(random));
+			update.step();
+			update.reset();
+			transaction.commit();
+			done++;
+		}
+		// What piled up in the WAL has to reach the database at some point, every commit shares that cost
+		db.execute("PRAGMA wal_checkpoint(TRUNCATE)");
+		const double milliseconds = millisecondsSince(start) / done;
+
+		const std::optional<std::uint64_t> writtenAfter = bytesWritten();
+		std::optional<double> bytes;
+		if (writtenBefore && writtenAfter) {
+			bytes = static_cast<double>(*writtenAfter - *writtenBefore) / done;
+		}
+		return {milliseconds, bytes};
+	}
+
+	// Random lookups and full scans, each round on a new connection like a tike command starts with
+	double measureReads(const std::string &path, const std::int64_t mmapSize) {
+		std::mt19937_64 random(readLookups);
+		double best = std::numeric_limits<double>::infinity();
+		for (int round = 0; round < readRounds; round++) {
+			const db::Database reader(path, db::OpenMode::ReadOnly);
+			reader.execute("PRAGMA mmap_size = " + std::to_string(mmapSize));
+			std::uniform_int_distribution<std::int64_t> ids(1, scratchRows);
+			db::Statement lookup = reader.prepare("SELECT title, description FROM tuneRows WHERE id = ?");
+			db::Statement scan = reader.prepare("SELECT sum(length(title) + length(description)) FROM tuneRows");
+
+			const Clock::time_point start = Clock::now();
+			for (int index = 0; index < readLookups; index++) {
+				lookup.bindInt64(1, ids(random));
+				lookup.step();
+				lookup.reset();
+			}
+			for (int index = 0; index < 2; index++) {
+				scan.step();
+				scan.reset();
+			}
+			best = std::min(best, millisecondsSince(start));
+		}
+		return best;
+	}
+
+	// Turns the copy of the user's database into the benchmark's: their tasks, padded up to scratchRows
+	void prepareScratch(const db::Database &scratch) {
+		useSettings(scratch, "DELETE", "OFF");
+		scratch.execute("DROP TABLE IF EXISTS storageSettings");
+		scratch.execute("CREATE TABLE tuneRows (id INTEGER PRIMARY KEY, title TEXT, description TEXT, "
+			"timeCreated DATETIME)");
+		if (scratch.hasTable("tasks")) {
+			scratch.execute("INSERT INTO tuneRows (title, description, timeCreated) "
+				"SELECT title, description, timeCreated FROM tasks");
+		}
+		scratch.execute(R"(
+			INSERT INTO tuneRows (title, description, timeCreated)
+			WITH RECURSIVE padding(row) AS (
+				SELECT (SELECT count(*) FROM tuneRows)
+				UNION ALL SELECT row + 1 FROM padding WHERE row + 1 < )" + std::to_string(scratchRows) + R"(
+			)
+			SELECT 'Task ' || row, substr(hex(randomblob(100)), 1, 40 + row % 160), CURRENT_TIMESTAMP
+			FROM padding WHERE row < )" + std::to_string(scratchRows));
+	}
+
+	struct JournalCandidate {
+		const char *journalMode;
+		const char *synchronous;
+	};
+
+	// The journal settings that keep the promise of the durability level. In rollback journal modes NORMAL may
+	// corrupt the database on power loss, so only WAL gets to relax synchronous without giving up integrity
+	std::vector<JournalCandidate> journalCandidates(const tike::Durability durability, const bool networkFilesystem) {
+		std::vector<JournalCandidate> candidates = {{"DELETE", "FULL"}, {"TRUNCATE", "FULL"}, {"WAL", "FULL"}};
+		if (durability != tike::Durability::Full) {
+			candidates.push_back({"WAL", "NORMAL"});
+		}
+		if (durability == tike::Durability::Off) {
+			candidates.push_back({"TRUNCATE", "OFF"});
+			candidates.push_back({"WAL", "OFF"});
+		}
+		if (networkFilesystem) {
+			std::erase_if(candidates, [](const JournalCandidate &candidate) {
+				return std::string_view(candidate.journalMode) == "WAL";
+			});
+		}
+		return candidates;
+	}
+
+	void setPageSize(const db::Database &db, const std::int64_t pageSize) {
+		// The page size can't change in WAL mode, VACUUM rebuilds the file with the new one
+		setJournalMode(db, "DELETE");
+		db.execute("PRAGMA page_size = " + std::to_string(pageSize));
+		db.execute("VACUUM");
+		if (pragmaInteger(db, "page_size") != pageSize) {
+			throw std::runtime_error("Could not change the page size to " + std::to_string(pageSize));
+		}
+	}
+}
+
+tike::Durability tike::parseDurability(const std::string_view name) {
+	if (name == "full") {
+		return Durability::Full;
+	}
+	if (name == "normal") {
+		return Durability::Normal;
+	}
+	if (name == "off") {
+		return Durability::Off;
+	}
+	throw std::invalid_argument("Unknown durability '" + std::string(name) + "', use full, normal or off");
+}
+
+tike::StorageSettings tike::currentStorageSettings(const db::Database &db) {
+	static constexpr const char *synchronousModes[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+
+	StorageSettings settings;
+	db::Statement journal = db.prepare("PRAGMA journal_mode");
+	if (journal.step()) {
+		settings.journalMode = upperCase(std::string(journal.columnText(0)));
+	}
+	const std::int64_t synchronous = pragmaInteger(db, "synchronous");
+	settings.synchronous = synchronous >= 0 && synchronous < 4 ? synchronousModes[synchronous] : "FULL";
+	settings.pageSize = pragmaInteger(db, "page_size");
+	settings.mmapSize = pragmaInteger(db, "mmap_size");
+	return settings;
+}
+
+tike::TuneReport tike::tuneStorage(const db::Database &db, const std::string &dbPath, const Durability durability) {
+	TuneReport report;
+	report.current = currentStorageSettings(db);
+	report.networkFilesystem = onNetworkFilesystem(dbPath);
+	report.fsyncMs = fsyncLatency(dbPath + ".tune-sync");
+
+	const std::string scratchPath = dbPath + ".tune";
+	const ScratchFiles scratchFiles(scratchPath);
+	std::string quotedPath;
+	for (const char character: scratchPath) {
+		quotedPath += character == '\'' ? "''" : std::string(1, character);
+	}
+	db.execute("VACUUM INTO '" + quotedPath + "'");
+
+	const db::Database scratch(scratchPath);
+	prepareScratch(scratch);
+	StorageSettings &recommended = report.recommended;
+
+	// Journal and synchronous: the fastest commits. Candidates within 10% of it count as just as fast, of
+	// those the one writing least wins, which spares flash storage
+	struct JournalResult {
+		JournalCandidate candidate;
+		CommitCost cost;
+	};
+	std::vector<JournalResult> journals;
+	for (const JournalCandidate &candidate: journalCandidates(durability, report.networkFilesystem)) {
+		useSettings(scratch, candidate.journalMode, candidate.synchronous);
+		const CommitCost cost = measureCommits(scratch, commitRounds);
+		journals.push_back({candidate, cost});
+		report.measurements.push_back({
+			"journal_mode=" + lowerCase(candidate.journalMode) + " synchronous=" + lowerCase(candidate.synchronous),
+			cost.milliseconds, cost.bytes, std::nullopt
+		});
+	}
+	const double fastestCommit = std::ranges::min(journals, {}, [](const JournalResult &result) {
+		return result.cost.milliseconds;
+	}).cost.milliseconds;
+	const JournalResult *chosenJournal = nullptr;
+	for (const JournalResult &result: journals) {
+		if (result.cost.milliseconds > fastestCommit * 1.1) {
+			continue;
+		}
+		const double bytes = result.cost.bytes.value_or(0);
+		if (!chosenJournal || bytes < chosenJournal->cost.bytes.value_or(0) ||
+		    (bytes == chosenJournal->cost.bytes.value_or(0) &&
+		     result.cost.milliseconds < chosenJournal->cost.milliseconds)) {
+			chosenJournal = &result;
+		}
+	}
+	report.writesMeasured = std::ranges::all_of(journals, [](const JournalResult &result) {
+		return result.cost.bytes.has_value();
+	});
+	recommended.journalMode = chosenJournal->candidate.journalMode;
+	recommended.synchronous = chosenJournal->candidate.synchronous;
+
+	// Page size: commits and reads weigh the same, each relative to the best page size at it
+	struct PageResult {
+		std::int64_t pageSize;
+		double commitMs;
+		double readMs;
+	};
+	std::vector<PageResult> pages;
+	for (const std::int64_t pageSize: pageSizes) {
+		setPageSize(scratch, pageSize);
+		useSettings(scratch, recommended.journalMode, recommended.synchronous);
+		const CommitCost cost = measureCommits(scratch, commitRounds / 2);
+		const double readMs = measureReads(scratchPath, 0);
+		pages.push_back({pageSize, cost.milliseconds, readMs});
+		report.measurements.push_back({
+			"page_size=" + std::to_string(pageSize), cost.milliseconds, cost.bytes, readMs
+		});
+	}
+	const double bestPageCommit = std::ranges::min(pages, {}, &PageResult::commitMs).commitMs;
+	const double bestPageRead = std::ranges::min(pages, {}, &PageResult::readMs).readMs;
+	recommended.pageSize = std::ranges::min(pages, {}, [&](const PageResult &result) {
+		return result.commitMs / bestPageCommit + result.readMs / bestPageRead;
+	}).pageSize;
+
+	// mmap_size: reading straight from the page cache saves a copy per page, but only keep it when that shows
+	if (recommended.pageSize != pageSizes[std::size(pageSizes) - 1]) {
+		setPageSize(scratch, recommended.pageSize);
+		useSettings(scratch, recommended.journalMode, recommended.synchronous);
+	}
+	const double plainReads = measureReads(scratchPath, 0);
+	const double mappedReads = measureReads(scratchPath, tunedMmapSize);
+	report.measurements.push_back({"mmap_size=0", std::nullopt, std::nullopt, plainReads});
+	report.measurements.push_back({"mmap_size=" + std::to_string(tunedMmapSize), std::nullopt, std::nullopt,
+	                               mappedReads});
+	recommended.mmapSize = mappedReads < plainReads * 0.95 ? tunedMmapSize : 0;
+	return report;
+}
+
+void tike::applyStorageSettings(const db::Database &db, const StorageSettings &settings) {
+	// The values end up in pragmas, only the ones the tuner can pick get through
+	const auto isOneOf = [](const std::string &value, const std::initializer_list<std::string_view> allowed) {
+		return std::ranges::find(allowed, value) != allowed.end();
+	};
+	if (!isOneOf(settings.journalMode, {"DELETE", "TRUNCATE", "PERSIST", "WAL"}) ||
+	    !isOneOf(settings.synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"}) || settings.mmapSize < 0) {
+		throw std::invalid_argument("Unsupported storage settings");
+	}
+
+	if (pragmaInteger(db, "page_size") != settings.pageSize) {
+		setPageSize(db, settings.pageSize);
+	}
+	setJournalMode(db, settings.journalMode);
+	db.execute("PRAGMA synchronous = " + settings.synchronous);
+	db.execute("PRAGMA mmap_size = " + std::to_string(settings.mmapSize));
+
+	db.execute("CREATE TABLE IF NOT EXISTS storageSettings (name TEXT PRIMARY KEY, value TEXT NOT NULL) "
+		"WITHOUT ROWID");
+	db::Transaction transaction(db);
+	db::Statement store = db.prepare("INSERT INTO storageSettings (name, value) VALUES (?, ?) "
+		"ON CONFLICT (name) DO UPDATE SET value = excluded.value");
+	for (const auto &[name, value]: {
+		     std::pair<std::string, std::string>{"journal_mode", settings.journalMode},
+		     {"synchronous", settings.synchronous},
+		     {"mmap_size", std::to_string(settings.mmapSize)}
+	     }) {
+		store.bind(1, name);
+		store.bind(2, value);
+		store.step();
+		store.reset();
+	}
+	transaction.commit();
+}
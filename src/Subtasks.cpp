@@ -0,0 +1,204 @@
+#include "Subtasks.h"
+
+#include "Tags.h"
+
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace {
+	constexpr auto subtasksSchema = R"(
+		CREATE TABLE taskClosure (
+			ancestor INTEGER NOT NULL,
+			descendant INTEGER NOT NULL,
+			depth INTEGER NOT NULL,
+			PRIMARY KEY (ancestor, descendant)
+		) WITHOUT ROWID;
+		CREATE INDEX taskClosureDescendant ON taskClosure (descendant, depth);
+
+		-- Tasks that exist already start out as top level tasks
+		INSERT INTO taskClosure (ancestor, descendant, depth) SELECT id, id, 0 FROM tasks;
+
+		CREATE TRIGGER taskClosureInsert AFTER INSERT ON tasks BEGIN
+			INSERT INTO taskClosure (ancestor, descendant, depth) VALUES (NEW.id, NEW.id, 0);
+		END;
+	)";
+}
+
+void tike::ensureSubtasks(const db::Database &db) {
+	if (db.hasTable("taskClosure")) {
+		return;
+	}
+
+	db::Transaction transaction(db);
+	if (!db.hasTable("taskClosure")) {
+		db.execute(subtasksSchema);
+	}
+	transaction.commit();
+}
+
+void tike::addSubtask(const db::Database &db, const std::int64_t parentId, const std::int64_t childId) {
+	// The child gets every ancestor of the parent, one level further away, the parent's own row included
+	db::Statement statement = db.prepare(R"(
+		INSERT INTO taskClosure (ancestor, descendant, depth)
+		SELECT ancestor, ?2, depth + 1 FROM taskClosure WHERE descendant = ?1
+	)");
+	statement.bindInt64(1, parentId).bindInt64(2, childId);
+	statement.step();
+}
+
+void tike::moveSubtree(const db::Database &db, const std::int64_t taskId, const std::optional<std::int64_t> parentId) {
+	if (parentId) {
+		db::Statement below = db.prepare("SELECT 1 FROM taskClosure WHERE ancestor = ? AND descendant = ?");
+		below.bindInt64(1, taskId).bindInt64(2, *parentId);
+		if (below.step()) {
+			throw std::invalid_argument("A task can't be moved below itself or one of its subtasks");
+		}
+	}
+
+	// Cut every link from above the task into the subtree, the links within the subtree stay as they are
+	db::Statement detach = db.prepare(R"(
+		DELETE FROM taskClosure
+		WHERE descendant IN (SELECT descendant FROM taskClosure WHERE ancestor = ?1)
+		  AND ancestor NOT IN (SELECT descendant FROM taskClosure WHERE ancestor = ?1)
+	)");
+	detach.bindInt64(1, taskId);
+	detach.step();
+
+	if (!parentId) {
+		return;
+	}
+
+	// Then link every ancestor of the new parent to every task of the subtree
+	db::Statement attach = db.prepare(R"(
+		INSERT INTO taskClosure (ancestor, descendant, depth)
+		SELECT above.ancestor, below.descendant, above.depth + below.depth + 1
+		FROM taskClosure above, taskClosure below
+		WHERE above.descendant = ?1 AND below.ancestor = ?2
+	)");
+	attach.bindInt64(1, *parentId).bindInt64(2, taskId);
+	attach.step();
+}
+
+std::vector<tike::SubtreeNode> tike::subtree(const db::Database &db, const std::int64_t rootId) {
+	if (!db.hasTable("taskClosure")) {
+		// No task has subtasks before the table exists
+		db::Statement task = db.prepare("SELECT title FROM tasks WHERE id = ?");
+		task.bindInt64(1, rootId);
+		if (!task.step()) {
+			return {};
+		}
+		return {SubtreeNode{.taskId = rootId, .title = std::string(task.columnText(0)), .open = true}};
+	}
+
+	// Every task below the root together with its direct parent, shallowest first
+	db::Statement statement = db.prepare(R"(
+		SELECT k.descendant, COALESCE(p.ancestor, 0), k.depth, COALESCE(t.title, c.title, '(removed task)'),
+		       t.id IS NOT NULL, c.taskId IS NOT NULL
+		FROM taskClosure k
+		LEFT JOIN taskClosure p ON p.descendant = k.descendant AND p.depth = 1
+		LEFT JOIN tasks t ON t.id = k.descendant
+		LEFT JOIN completedTasks c ON c.taskId = k.descendant
+		WHERE k.ancestor = ?
+		ORDER BY k.depth, k.descendant
+	)");
+	statement.bindInt64(1, rootId);
+
+	std::vector<SubtreeNode> byDepth;
+	std::vector<bool> completed;
+	std::map<std::int64_t, std::size_t> indexOf;
+	std::map<std::int64_t, std::vector<std::size_t>> children;
+	while (statement.step()) {
+		SubtreeNode node;
+		node.taskId = statement.columnInt64(0);
+		node.parentId = statement.columnInt64(2) == 0 ? 0 : statement.columnInt64(1);
+		node.depth = statement.columnInt64(2);
+		node.title = statement.columnText(3);
+		node.open = statement.columnInt64(4) != 0;
+		indexOf[node.taskId] = byDepth.size();
+		if (node.depth > 0) {
+			children[node.parentId].push_back(byDepth.size());
+		}
+		completed.push_back(statement.columnInt64(5) != 0);
+		byDepth.push_back(std::move(node));
+	}
+
+	// Roll the counts up, deepest first, so every child is done before its parent
+	for (std::size_t index = byDepth.size(); index-- > 1;) {
+		const SubtreeNode &node = byDepth[index];
+		SubtreeNode &parent = byDepth[indexOf.at(node.parentId)];
+		parent.total += node.total + 1;
+		parent.completed += node.completed + (completed[index] ? 1 : 0);
+	}
+
+	// Depth first order for printing
+	std::vector<SubtreeNode> result;
+	result.reserve(byDepth.size());
+	std::vector<std::size_t> stack;
+	if (!byDepth.empty()) {
+		stack.push_back(0);
+	}
+	while (!stack.empty()) {
+		const std::size_t index = stack.back();
+		stack.pop_back();
+		if (const auto found = children.find(byDepth[index].taskId); found != children.end()) {
+			stack.insert(stack.end(), found->second.rbegin(), found->second.rend());
+		}
+		result.push_back(std::move(byDepth[index]));
+	}
+	return result;
+}
+
+std::vector<std::int64_t> tike::pseudoIds(const db::Database &db, const std::span<const std::int64_t> taskIds) {
+	std::vector<std::int64_t> result(taskIds.size());
+	const RoaringBitmap open = openTaskIds(db);
+	for (std::size_t index = 0; index < taskIds.size(); index++) {
+		const std::int64_t id = taskIds[index];
+		if (id >= 0 && id <= std::numeric_limits<std::uint32_t>::max() && open.contains(static_cast<std::uint32_t>(id))) {
+			result[index] = static_cast<std::int64_t>(open.rank(static_cast<std::uint32_t>(id)));
+		}
+	}
+	return result;
+}
+
+std::vector<std::int64_t> tike::openDescendants(const db::Database &db, const std::int64_t taskId) {
+	db::Statement statement = db.prepare(R"(
+		SELECT k.descendant
+		FROM taskClosure k
+		JOIN tasks t ON t.id = k.descendant
+		WHERE k.ancestor = ? AND k.depth > 0
+		ORDER BY k.depth DESC, k.descendant
+	)");
+	statement.bindInt64(1, taskId);
+
+	std::vector<std::int64_t> ids;
+	while (statement.step()) {
+		ids.push_back(statement.columnInt64(0));
+	}
+	return ids;
+}
+
+void tike::detachTask(const db::Database &db, const std::int64_t taskId) {
+	if (!openDescendants(db, taskId).empty()) {
+		throw std::invalid_argument("The task has open subtasks, complete, remove or move them first");
+	}
+
+	// Completed subtasks move up to the task's parent, so the hierarchy stays connected
+	db::Statement parent = db.prepare("SELECT ancestor FROM taskClosure WHERE descendant = ? AND depth = 1");
+	parent.bindInt64(1, taskId);
+	const std::optional<std::int64_t> parentId = parent.step() ? std::optional(parent.columnInt64(0)) : std::nullopt;
+
+	db::Statement children = db.prepare("SELECT descendant FROM taskClosure WHERE ancestor = ? AND depth = 1");
+	children.bindInt64(1, taskId);
+	std::vector<std::int64_t> childIds;
+	while (children.step()) {
+		childIds.push_back(children.columnInt64(0));
+	}
+	for (const std::int64_t childId: childIds) {
+		moveSubtree(db, childId, parentId);
+	}
+
+	db::Statement statement = db.prepare("DELETE FROM taskClosure WHERE ancestor = ?1 OR descendant = ?1");
+	statement.bindInt64(1, taskId);
+	statement.step();
+}
@@ -0,0 +1,193 @@
+#include "TDigest.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace {
+	// "TDG" and a format version
+	constexpr std::uint32_t digestMagic = 0x01474454;
+
+	void putUint64(std::string &out, const std::uint64_t value) {
+		for (int shift = 0; shift < 64; shift += 8) {
+			out.push_back(static_cast<char>(value >> shift & 0xFF));
+		}
+	}
+
+	void putDouble(std::string &out, const double value) {
+		putUint64(out, std::bit_cast<std::uint64_t>(value));
+	}
+
+	std::uint64_t readUint64(const std::string_view bytes, const std::size_t offset) {
+		std::uint64_t value = 0;
+		for (int index = 7; index >= 0; index--) {
+			value = value << 8 | static_cast<unsigned char>(bytes[offset + index]);
+		}
+		return value;
+	}
+
+	double readDouble(const std::string_view bytes, const std::size_t offset) {
+		return std::bit_cast<double>(readUint64(bytes, offset));
+	}
+}
+
+tike::TDigest::TDigest(const double compression)
+	: compression(compression), minimum(std::numeric_limits<double>::infinity()),
+	  maximum(-std::numeric_limits<double>::infinity()) {
+}
+
+void tike::TDigest::add(const double value, const double weight) {
+	if (std::isnan(value) || weight <= 0) {
+		return;
+	}
+	minimum = std::min(minimum, value);
+	maximum = std::max(maximum, value);
+	buffer.push_back({value, weight});
+
+	// Compressing in batches keeps adding amortised O(log n) per value
+	if (buffer.size() >= static_cast<std::size_t>(compression) * 8) {
+		compress();
+	}
+}
+
+void tike::TDigest::merge(const TDigest &other) {
+	other.compress();
+	for (const auto &centroid: other.centroids) {
+		buffer.push_back(centroid);
+	}
+	minimum = std::min(minimum, other.minimum);
+	maximum = std::max(maximum, other.maximum);
+	compress();
+}
+
+double tike::TDigest::count() const {
+	double total = 0;
+	for (const auto &centroid: centroids) {
+		total += centroid.weight;
+	}
+	for (const auto &centroid: buffer) {
+		total += centroid.weight;
+	}
+	return total;
+}
+
+void tike::TDigest::compress() const {
+	if (buffer.empty()) {
+		return;
+	}
+
+	std::vector<Centroid> all = std::move(centroids);
+	all.insert(all.end(), buffer.begin(), buffer.end());
+	buffer.clear();
+	std::ranges::sort(all, {}, &Centroid::mean);
+
+	double total = 0;
+	for (const auto &centroid: all) {
+		total += centroid.weight;
+	}
+
+	// The k1 scale function, centroids may span at most one unit of k. It is steep near q = 0 and q = 1,
+	// which keeps the centroids at the tails small
+	const auto k = [this](const double q) {
+		return compression / (2 * std::numbers::pi) * std::asin(2 * q - 1);
+	};
+	const auto kInverse = [this](const double scale) {
+		return (std::sin(scale * 2 * std::numbers::pi / compression) + 1) / 2;
+	};
+
+	centroids.clear();
+	Centroid current = all.front();
+	double weightSoFar = 0;
+	double qLimit = kInverse(k(0) + 1);
+	for (std::size_t index = 1; index < all.size(); index++) {
+		const Centroid &next = all[index];
+		if ((weightSoFar + current.weight + next.weight) / total <= qLimit) {
+			// Fold into the current centroid, keeping the mean weighted
+			current.weight += next.weight;
+			current.mean += (next.mean - current.mean) * next.weight / current.weight;
+		} else {
+			weightSoFar += current.weight;
+			centroids.push_back(current);
+			qLimit = kInverse(k(weightSoFar / total) + 1);
+			current = next;
+		}
+	}
+	centroids.push_back(current);
+}
+
+double tike::TDigest::quantile(const double q) const {
+	compress();
+	if (centroids.empty()) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	if (centroids.size() == 1) {
+		return centroids.front().mean;
+	}
+
+	double total = 0;
+	for (const auto &centroid: centroids) {
+		total += centroid.weight;
+	}
+	const double target = std::clamp(q, 0.0, 1.0) * total;
+
+	// Each centroid sits at the middle of its weight, interpolate between neighbouring centres.
+	// Before the first and after the last centre interpolate towards the exact minimum and maximum
+	const Centroid &first = centroids.front();
+	if (target < first.weight / 2) {
+		return minimum + (first.mean - minimum) * target / (first.weight / 2);
+	}
+
+	double centre = first.weight / 2;
+	for (std::size_t index = 1; index < centroids.size(); index++) {
+		const Centroid &previous = centroids[index - 1];
+		const Centroid &current = centroids[index];
+		const double nextCentre = centre + (previous.weight + current.weight) / 2;
+		if (target < nextCentre) {
+			return previous.mean + (current.mean - previous.mean) * (target - centre) / (nextCentre - centre);
+		}
+		centre = nextCentre;
+	}
+
+	const Centroid &last = centroids.back();
+	const double remaining = total - centre;
+	return remaining <= 0 ? maximum : last.mean + (maximum - last.mean) * (target - centre) / remaining;
+}
+
+std::string tike::TDigest::serialize() const {
+	compress();
+
+	// Header, then one (mean, weight) pair per centroid, everything little-endian
+	std::string bytes;
+	bytes.reserve(40 + centroids.size() * 16);
+	putUint64(bytes, digestMagic);
+	putDouble(bytes, compression);
+	putDouble(bytes, minimum);
+	putDouble(bytes, maximum);
+	putUint64(bytes, centroids.size());
+	for (const auto &[mean, weight]: centroids) {
+		putDouble(bytes, mean);
+		putDouble(bytes, weight);
+	}
+	return bytes;
+}
+
+std::optional<tike::TDigest> tike::TDigest::deserialize(const std::string_view bytes) {
+	if (bytes.size() < 40 || readUint64(bytes, 0) != digestMagic) {
+		return std::nullopt;
+	}
+	const std::uint64_t size = readUint64(bytes, 32);
+	if (size > (bytes.size() - 40) / 16 || bytes.size() != 40 + size * 16) {
+		return std::nullopt;
+	}
+
+	TDigest digest(readDouble(bytes, 8));
+	digest.minimum = readDouble(bytes, 16);
+	digest.maximum = readDouble(bytes, 24);
+	digest.centroids.reserve(size);
+	for (std::size_t index = 0; index < size; index++) {
+		digest.centroids.push_back({readDouble(bytes, 40 + index * 16), readDouble(bytes, 48 + index * 16)});
+	}
+	return digest;
+}
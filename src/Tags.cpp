@@ -0,0 +1,314 @@
+#include "Tags.h"
+
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	// tagId of the bitmap holding every open task. Tag ids start at 1
+	constexpr std::int64_t openTasks = 0;
+
+	/*
+	 * The tables, then the triggers recording in tagBitmapChanges the (task, bitmap) pairs whose membership may
+	 * have changed, so a sync only loads and rewrites the bitmaps those tasks are in. Runs once per database
+	 */
+	constexpr auto tagsSchema = R"(
+		CREATE TABLE tags (
+			id INTEGER PRIMARY KEY AUTOINCREMENT,
+			name TEXT NOT NULL UNIQUE
+		);
+		CREATE TABLE taskTags (
+			taskId INTEGER NOT NULL,
+			tagId INTEGER NOT NULL,
+			PRIMARY KEY (taskId, tagId)
+		) WITHOUT ROWID;
+		CREATE TABLE tagBitmaps (
+			tagId INTEGER PRIMARY KEY,
+			bitmap BLOB NOT NULL
+		);
+		CREATE TABLE tagBitmapChanges (
+			taskId INTEGER NOT NULL,
+			tagId INTEGER NOT NULL,
+			PRIMARY KEY (taskId, tagId)
+		) WITHOUT ROWID;
+
+		-- Existing tasks get indexed by the first sync
+		INSERT INTO tagBitmapChanges (taskId, tagId) SELECT id, 0 FROM tasks;
+
+		-- A task coming or going changes the open bitmap and the bitmap of every tag it carries
+		CREATE TRIGGER tagChangesTaskInsert AFTER INSERT ON tasks BEGIN
+			INSERT OR IGNORE INTO tagBitmapChanges (taskId, tagId)
+			SELECT NEW.id, 0 UNION ALL SELECT taskId, tagId FROM taskTags WHERE taskId = NEW.id;
+		END;
+		CREATE TRIGGER tagChangesTaskDelete AFTER DELETE ON tasks BEGIN
+			INSERT OR IGNORE INTO tagBitmapChanges (taskId, tagId)
+			SELECT OLD.id, 0 UNION ALL SELECT taskId, tagId FROM taskTags WHERE taskId = OLD.id;
+		END;
+		CREATE TRIGGER tagChangesTagInsert AFTER INSERT ON taskTags BEGIN
+			INSERT OR IGNORE INTO tagBitmapChanges (taskId, tagId) VALUES (NEW.taskId, NEW.tagId);
+		END;
+		CREATE TRIGGER tagChangesTagDelete AFTER DELETE ON taskTags BEGIN
+			INSERT OR IGNORE INTO tagBitmapChanges (taskId, tagId) VALUES (OLD.taskId, OLD.tagId);
+		END;
+	)";
+
+	using Bitmaps = std::map<std::int64_t, tike::RoaringBitmap>;
+
+	// Whether the index is there. Until a write sets it up readers scan instead
+	bool hasTagIndex(const db::Database &db) {
+		return db.hasTable("tagBitmapChanges");
+	}
+
+	std::vector<std::string_view> splitTags(const std::string_view list) {
+		std::vector<std::string_view> tags;
+		std::size_t start = 0;
+		while (true) {
+			const std::size_t end = list.find(',', start);
+			const std::string_view tag = list.substr(start, end == std::string_view::npos ? end : end - start);
+			if (tag.empty() || tag == "!") {
+				throw std::invalid_argument("Empty tag in: " + std::string(list));
+			}
+			tags.push_back(tag);
+			if (end == std::string_view::npos) {
+				return tags;
+			}
+			start = end + 1;
+		}
+	}
+
+	void loadBitmap(const db::Database &db, const std::int64_t tagId, Bitmaps &bitmaps) {
+		db::Statement statement = db.prepare("SELECT bitmap FROM tagBitmaps WHERE tagId = ?");
+		statement.bindInt64(1, tagId);
+		if (!statement.step()) {
+			bitmaps[tagId];
+			return;
+		}
+		std::optional<tike::RoaringBitmap> bitmap = tike::RoaringBitmap::deserialize(statement.columnBlob(0));
+		if (!bitmap) {
+			throw std::runtime_error("Corrupt tag index for tag id " + std::to_string(tagId));
+		}
+		bitmaps[tagId] = std::move(*bitmap);
+	}
+
+	std::uint32_t bitmapTaskId(const std::int64_t id) {
+		if (id < 0 || id > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::runtime_error("Task id too large for the tag index: " + std::to_string(id));
+		}
+		return static_cast<std::uint32_t>(id);
+	}
+
+	// Loads a bitmap for a reader. Without a current index it is built from the tables instead
+	void readBitmap(const db::Database &db, const bool indexed, const std::int64_t tagId, Bitmaps &bitmaps) {
+		if (indexed) {
+			loadBitmap(db, tagId, bitmaps);
+			return;
+		}
+		db::Statement scan = db.prepare(
+			"SELECT id FROM tasks WHERE ?1 = 0 OR id IN (SELECT taskId FROM taskTags WHERE tagId = ?1)");
+		scan.bindInt64(1, tagId);
+		tike::RoaringBitmap &bitmap = bitmaps[tagId];
+		while (scan.step()) {
+			bitmap.add(bitmapTaskId(scan.columnInt64(0)));
+		}
+	}
+
+	/*
+	 * Brings the recorded (task, bitmap) pairs up to date. Only bitmaps in `bitmaps` are touched, unless
+	 * loadMissing is set, then the other bitmaps a pair refers to are loaded first. Returns the tag ids of the
+	 * bitmaps that changed
+	 */
+	std::vector<std::int64_t> applyChanges(const db::Database &db, Bitmaps &bitmaps, const bool loadMissing) {
+		db::Statement changes = db.prepare("SELECT taskId, tagId FROM tagBitmapChanges");
+		db::Statement isOpen = db.prepare("SELECT 1 FROM tasks WHERE id = ?");
+		db::Statement hasTag = db.prepare("SELECT 1 FROM taskTags WHERE taskId = ? AND tagId = ?");
+
+		std::set<std::int64_t> changed;
+		while (changes.step()) {
+			const std::int64_t id = changes.columnInt64(0);
+			const std::int64_t tagId = changes.columnInt64(1);
+			const std::uint32_t taskId = bitmapTaskId(id);
+
+			if (!bitmaps.contains(tagId)) {
+				if (!loadMissing) {
+					continue;
+				}
+				loadBitmap(db, tagId, bitmaps);
+			}
+
+			isOpen.reset();
+			isOpen.bindInt64(1, id);
+			bool member = isOpen.step();
+			if (member && tagId != openTasks) {
+				hasTag.reset();
+				hasTag.bindInt64(1, id).bindInt64(2, tagId);
+				member = hasTag.step();
+			}
+
+			tike::RoaringBitmap &bitmap = bitmaps.at(tagId);
+			if (bitmap.contains(taskId) != member) {
+				member ? bitmap.add(taskId) : bitmap.remove(taskId);
+				changed.insert(tagId);
+			}
+		}
+
+		return {changed.begin(), changed.end()};
+	}
+}
+
+void tike::ensureTags(const db::Database &db) {
+	if (hasTagIndex(db)) {
+		return;
+	}
+
+	db::Transaction transaction(db);
+	if (!hasTagIndex(db)) {
+		db.execute(tagsSchema);
+		syncTagBitmaps(db);
+	}
+	transaction.commit();
+}
+
+void tike::tagTask(const db::Database &db, const std::int64_t taskId, const std::span<const std::string_view> tags) {
+	db::Statement createTag = db.prepare("INSERT OR IGNORE INTO tags (name) VALUES (?)");
+	db::Statement link = db.prepare(
+		"INSERT OR IGNORE INTO taskTags (taskId, tagId) SELECT ?, id FROM tags WHERE name = ?");
+
+	for (const std::string_view list: tags) {
+		for (const std::string_view tag: splitTags(list)) {
+			if (tag.front() == '!') {
+				throw std::invalid_argument("Tag names can't start with '!': " + std::string(tag));
+			}
+			createTag.reset();
+			createTag.bind(1, std::string(tag));
+			createTag.step();
+
+			link.reset();
+			link.bindInt64(1, taskId).bind(2, std::string(tag));
+			link.step();
+		}
+	}
+}
+
+void tike::untagTask(const db::Database &db, const std::int64_t taskId) {
+	db::Statement &untag = db.prepareCached("DELETE FROM taskTags WHERE taskId = ?");
+	untag.bindInt64(1, taskId);
+	untag.step();
+	untag.reset();
+}
+
+void tike::syncTagBitmaps(const db::Database &db) {
+	if (!hasTagIndex(db)) {
+		return;
+	}
+	db::Statement pending = db.prepare("SELECT 1 FROM tagBitmapChanges LIMIT 1");
+	if (!pending.step()) {
+		return;
+	}
+
+	// Only the bitmaps the changed tasks are or were in get loaded and written back
+	Bitmaps bitmaps;
+	db::Statement store = db.prepare("INSERT OR REPLACE INTO tagBitmaps (tagId, bitmap) VALUES (?, ?)");
+	for (const std::int64_t tagId: applyChanges(db, bitmaps, true)) {
+		store.reset();
+		store.bindInt64(1, tagId).bindBlob(2, bitmaps.at(tagId).serialize());
+		store.step();
+	}
+	db.execute("DELETE FROM tagBitmapChanges");
+}
+
+std::vector<tike::TaggedTask> tike::filterOpenTasks(const db::Database &db,
+                                                    const std::span<const std::string_view> filters) {
+	std::vector<TaggedTask> tasks;
+	if (!db.hasTable("taskTags")) {
+		return tasks;
+	}
+	const bool indexed = hasTagIndex(db);
+
+	// Resolve the names first, a tag nobody uses simply has an empty bitmap
+	struct Term {
+		std::int64_t tagId;
+		bool excluded;
+	};
+	std::vector<std::vector<Term>> groups;
+	Bitmaps bitmaps;
+	readBitmap(db, indexed, openTasks, bitmaps);
+	db::Statement findTag = db.prepare("SELECT id FROM tags WHERE name = ?");
+	for (const std::string_view filter: filters) {
+		std::vector<Term> &group = groups.emplace_back();
+		for (std::string_view tag: splitTags(filter)) {
+			const bool excluded = tag.front() == '!';
+			if (excluded) {
+				tag.remove_prefix(1);
+			}
+			findTag.reset();
+			findTag.bind(1, std::string(tag));
+			const std::int64_t tagId = findTag.step() ? findTag.columnInt64(0) : -1;
+			if (tagId >= 0 && !bitmaps.contains(tagId)) {
+				readBitmap(db, indexed, tagId, bitmaps);
+			}
+			group.push_back({tagId, excluded});
+		}
+	}
+
+	// Writes through tike leave no changes behind, this only catches up on writes made some other way
+	if (indexed) {
+		applyChanges(db, bitmaps, false);
+	}
+
+	const RoaringBitmap &open = bitmaps.at(openTasks);
+	RoaringBitmap matches;
+	for (const auto &group: groups) {
+		RoaringBitmap result = open;
+		for (const auto &[tagId, excluded]: group) {
+			if (tagId < 0) {
+				if (!excluded) {
+					result = {};
+				}
+				continue;
+			}
+			if (excluded) {
+				result -= bitmaps.at(tagId);
+			} else {
+				result &= bitmaps.at(tagId);
+			}
+		}
+		matches |= result;
+	}
+
+	for (const std::uint32_t taskId: matches.values()) {
+		tasks.push_back({static_cast<std::int64_t>(open.rank(taskId)), taskId});
+	}
+	return tasks;
+}
+
+tike::RoaringBitmap tike::openTasksTagged(const db::Database &db, const std::string_view tag) {
+	if (!db.hasTable("taskTags")) {
+		return {};
+	}
+	db::Statement findTag = db.prepare("SELECT id FROM tags WHERE name = ?");
+	findTag.bind(1, std::string(tag));
+	if (!findTag.step()) {
+		return {};
+	}
+
+	const std::int64_t tagId = findTag.columnInt64(0);
+	const bool indexed = hasTagIndex(db);
+	Bitmaps bitmaps;
+	readBitmap(db, indexed, tagId, bitmaps);
+	if (indexed) {
+		applyChanges(db, bitmaps, false);
+	}
+	return std::move(bitmaps.at(tagId));
+}
+
+tike::RoaringBitmap tike::openTaskIds(const db::Database &db) {
+	const bool indexed = hasTagIndex(db);
+	Bitmaps bitmaps;
+	readBitmap(db, indexed, openTasks, bitmaps);
+	if (indexed) {
+		applyChanges(db, bitmaps, false);
+	}
+	return std::move(bitmaps.at(openTasks));
+}
@@ -0,0 +1,165 @@
+#include "TaskSnapshot.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <vector>
+
+namespace {
+	// "TKSN", followed by a layout version so a future change can't be misread
+	constexpr std::uint32_t snapshotMagic = 0x4E534B54;
+	constexpr std::uint32_t snapshotVersion = 1;
+
+	struct SnapshotHeader {
+		std::uint32_t magic;
+		std::uint32_t version;
+		db::StorageStamp stamp;
+		std::uint64_t count;
+		std::int64_t nextRecurrenceDue;
+	};
+
+	// Offsets are relative to the start of the heap, which follows the last record
+	struct SnapshotString {
+		std::uint64_t offset;
+		std::uint64_t length;
+	};
+
+	struct SnapshotRecord {
+		std::int64_t id;
+		SnapshotString title;
+		SnapshotString description;
+		SnapshotString timeCreated;
+	};
+
+	SnapshotString appendString(std::string &heap, const std::string_view text) {
+		const SnapshotString placed{heap.size(), text.size()};
+		heap.append(text);
+		return placed;
+	}
+
+#ifndef _WIN32
+	bool writeAll(const int fd, const void *bytes, std::size_t size) {
+		const auto *next = static_cast<const char *>(bytes);
+		while (size > 0) {
+			const ssize_t written = ::write(fd, next, size);
+			if (written <= 0) {
+				return false;
+			}
+			next += written;
+			size -= static_cast<std::size_t>(written);
+		}
+		return true;
+	}
+#endif
+}
+
+db::TaskSnapshot::~TaskSnapshot() {
+#ifndef _WIN32
+	if (data) {
+		::munmap(const_cast<char *>(data), mappedSize);
+	}
+#endif
+}
+
+bool db::TaskSnapshot::load() {
+#ifdef _WIN32
+	return false;
+#else
+	const int fd = ::open(snapshotPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info{};
+	if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+		::close(fd);
+		return false;
+	}
+
+	const auto size = static_cast<std::size_t>(info.st_size);
+	void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	const auto *header = static_cast<const SnapshotHeader *>(mapping);
+
+	// The records have to fit, the strings are checked as they are read
+	const bool current = header->magic == snapshotMagic && header->version == snapshotVersion &&
+	                     header->count <= (size - sizeof(SnapshotHeader)) / sizeof(SnapshotRecord) &&
+	                     StorageStamp::of(dbPath) == header->stamp;
+	if (!current) {
+		::munmap(mapping, size);
+		return false;
+	}
+
+	if (data) {
+		::munmap(const_cast<char *>(data), mappedSize);
+	}
+	data = static_cast<const char *>(mapping);
+	mappedSize = size;
+	return true;
+#endif
+}
+
+void db::TaskSnapshot::store(Statement &tasks, const std::int64_t nextRecurrenceDue, const StorageStamp &stamp) const {
+#ifndef _WIN32
+	std::vector<SnapshotRecord> records;
+	std::string heap;
+	while (tasks.step()) {
+		SnapshotRecord record{};
+		record.id = tasks.columnInt64(0);
+		record.title = appendString(heap, tasks.columnText(1));
+		record.description = appendString(heap, tasks.columnText(2));
+		record.timeCreated = appendString(heap, tasks.columnText(3));
+		records.push_back(record);
+	}
+	tasks.reset();
+
+	const SnapshotHeader header{snapshotMagic, snapshotVersion, stamp, records.size(), nextRecurrenceDue};
+
+	// Write a temporary file first, renaming it over the sidecar is atomic
+	const std::string temporaryPath = snapshotPath + "." + std::to_string(::getpid());
+	const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return;
+	}
+	const bool written = writeAll(fd, &header, sizeof(header)) &&
+	                     writeAll(fd, records.data(), records.size() * sizeof(SnapshotRecord)) &&
+	                     writeAll(fd, heap.data(), heap.size());
+	::close(fd);
+
+	if (!written || std::rename(temporaryPath.c_str(), snapshotPath.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+	}
+#endif
+}
+
+std::size_t db::TaskSnapshot::size() const {
+	return data ? reinterpret_cast<const SnapshotHeader *>(data)->count : 0;
+}
+
+db::SnapshotTask db::TaskSnapshot::operator[](const std::size_t index) const {
+	const auto *records = reinterpret_cast<const SnapshotRecord *>(data + sizeof(SnapshotHeader));
+	const char *heap = data + sizeof(SnapshotHeader) + size() * sizeof(SnapshotRecord);
+	const std::size_t heapSize = mappedSize - (heap - data);
+
+	// A damaged string reads as empty instead of pointing outside the mapping
+	const auto view = [&](const SnapshotString &text) {
+		if (text.offset > heapSize || text.length > heapSize - text.offset) {
+			return std::string_view();
+		}
+		return std::string_view(heap + text.offset, text.length);
+	};
+
+	const SnapshotRecord &record = records[index];
+	return {record.id, view(record.title), view(record.description), view(record.timeCreated)};
+}
+
+std::int64_t db::TaskSnapshot::nextRecurrenceDue() const {
+	return reinterpret_cast<const SnapshotHeader *>(data)->nextRecurrenceDue;
+}
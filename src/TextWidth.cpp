@@ -0,0 +1,322 @@
+#include "TextWidth.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+
+namespace {
+	struct CodePointRange {
+		char32_t first;
+		char32_t last;
+	};
+
+	// Combining marks, format characters, Hangul vowels and finals, variation selectors and emoji modifiers
+	constexpr std::array zeroWidth = std::to_array<CodePointRange>({
+		{0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+		{0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x061C, 0x061C}, {0x064B, 0x065F},
+		{0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED},
+		{0x0711, 0x0711}, {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x07EB, 0x07F3}, {0x07FD, 0x07FD},
+		{0x0816, 0x0819}, {0x081B, 0x0823}, {0x0825, 0x0827}, {0x0829, 0x082D}, {0x0859, 0x085B},
+		{0x0898, 0x089F}, {0x08CA, 0x08E1}, {0x08E3, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C},
+		{0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0981},
+		{0x09BC, 0x09BC}, {0x09C1, 0x09C4}, {0x09CD, 0x09CD}, {0x09E2, 0x09E3}, {0x09FE, 0x09FE},
+		{0x0A01, 0x0A02}, {0x0A3C, 0x0A3C}, {0x0A41, 0x0A42}, {0x0A47, 0x0A48}, {0x0A4B, 0x0A4D},
+		{0x0A51, 0x0A51}, {0x0A70, 0x0A71}, {0x0A75, 0x0A75}, {0x0A81, 0x0A82}, {0x0ABC, 0x0ABC},
+		{0x0AC1, 0x0AC5}, {0x0AC7, 0x0AC8}, {0x0ACD, 0x0ACD}, {0x0AE2, 0x0AE3}, {0x0AFA, 0x0AFF},
+		{0x0B01, 0x0B01}, {0x0B3C, 0x0B3C}, {0x0B3F, 0x0B3F}, {0x0B41, 0x0B44}, {0x0B4D, 0x0B4D},
+		{0x0B55, 0x0B56}, {0x0B62, 0x0B63}, {0x0B82, 0x0B82}, {0x0BC0, 0x0BC0}, {0x0BCD, 0x0BCD},
+		{0x0C00, 0x0C00}, {0x0C04, 0x0C04}, {0x0C3C, 0x0C3C}, {0x0C3E, 0x0C40}, {0x0C46, 0x0C48},
+		{0x0C4A, 0x0C4D}, {0x0C55, 0x0C56}, {0x0C62, 0x0C63}, {0x0C81, 0x0C81}, {0x0CBC, 0x0CBC},
+		{0x0CBF, 0x0CBF}, {0x0CC6, 0x0CC6}, {0x0CCC, 0x0CCD}, {0x0CE2, 0x0CE3}, {0x0D00, 0x0D01},
+		{0x0D3B, 0x0D3C}, {0x0D41, 0x0D44}, {0x0D4D, 0x0D4D}, {0x0D62, 0x0D63}, {0x0D81, 0x0D81},
+		{0x0DCA, 0x0DCA}, {0x0DD2, 0x0DD4}, {0x0DD6, 0x0DD6}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A},
+		{0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECE}, {0x0F18, 0x0F19},
+		{0x0F35, 0x0F35}, {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F71, 0x0F7E}, {0x0F80, 0x0F84},
+		{0x0F86, 0x0F87}, {0x0F8D, 0x0F97}, {0x0F99, 0x0FBC}, {0x0FC6, 0x0FC6}, {0x102D, 0x1030},
+		{0x1032, 0x1037}, {0x1039, 0x103A}, {0x103D, 0x103E}, {0x1058, 0x1059}, {0x105E, 0x1060},
+		{0x1071, 0x1074}, {0x1082, 0x1082}, {0x1085, 0x1086}, {0x108D, 0x108D}, {0x109D, 0x109D},
+		{0x1160, 0x11FF}, {0x135D, 0x135F}, {0x1712, 0x1714}, {0x1732, 0x1733}, {0x1752, 0x1753},
+		{0x1772, 0x1773}, {0x17B4, 0x17B5}, {0x17B7, 0x17BD}, {0x17C6, 0x17C6}, {0x17C9, 0x17D3},
+		{0x17DD, 0x17DD}, {0x180B, 0x180F}, {0x1885, 0x1886}, {0x18A9, 0x18A9}, {0x1920, 0x1922},
+		{0x1927, 0x1928}, {0x1932, 0x1932}, {0x1939, 0x193B}, {0x1A17, 0x1A18}, {0x1A1B, 0x1A1B},
+		{0x1A56, 0x1A56}, {0x1A58, 0x1A5E}, {0x1A60, 0x1A60}, {0x1A62, 0x1A62}, {0x1A65, 0x1A6C},
+		{0x1A73, 0x1A7C}, {0x1A7F, 0x1A7F}, {0x1AB0, 0x1ACE}, {0x1B00, 0x1B03}, {0x1B34, 0x1B34},
+		{0x1B36, 0x1B3A}, {0x1B3C, 0x1B3C}, {0x1B42, 0x1B42}, {0x1B6B, 0x1B73}, {0x1B80, 0x1B81},
+		{0x1BA2, 0x1BA5}, {0x1BA8, 0x1BA9}, {0x1BAB, 0x1BAD}, {0x1BE6, 0x1BE6}, {0x1BE8, 0x1BE9},
+		{0x1BED, 0x1BED}, {0x1BEF, 0x1BF1}, {0x1C2C, 0x1C33}, {0x1C36, 0x1C37}, {0x1CD0, 0x1CD2},
+		{0x1CD4, 0x1CE0}, {0x1CE2, 0x1CE8}, {0x1CED, 0x1CED}, {0x1CF4, 0x1CF4}, {0x1CF8, 0x1CF9},
+		{0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20F0},
+		{0x2CEF, 0x2CF1}, {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF}, {0x302A, 0x302D}, {0x3099, 0x309A},
+		{0xA66F, 0xA672}, {0xA674, 0xA67D}, {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802},
+		{0xA806, 0xA806}, {0xA80B, 0xA80B}, {0xA825, 0xA826}, {0xA82C, 0xA82C}, {0xA8C4, 0xA8C5},
+		{0xA8E0, 0xA8F1}, {0xA8FF, 0xA8FF}, {0xA926, 0xA92D}, {0xA947, 0xA951}, {0xA980, 0xA982},
+		{0xA9B3, 0xA9B3}, {0xA9B6, 0xA9B9}, {0xA9BC, 0xA9BD}, {0xA9E5, 0xA9E5}, {0xAA29, 0xAA2E},
+		{0xAA31, 0xAA32}, {0xAA35, 0xAA36}, {0xAA43, 0xAA43}, {0xAA4C, 0xAA4C}, {0xAA7C, 0xAA7C},
+		{0xAAB0, 0xAAB0}, {0xAAB2, 0xAAB4}, {0xAAB7, 0xAAB8}, {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1},
+		{0xAAEC, 0xAAED}, {0xAAF6, 0xAAF6}, {0xABE5, 0xABE5}, {0xABE8, 0xABE8}, {0xABED, 0xABED},
+		{0xD7B0, 0xD7FF}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+		{0x101FD, 0x101FD}, {0x102E0, 0x102E0}, {0x10376, 0x1037A}, {0x10A01, 0x10A0F}, {0x10A38, 0x10A3F},
+		{0x10AE5, 0x10AE6}, {0x10D24, 0x10D27}, {0x10EAB, 0x10EAC}, {0x10F46, 0x10F50}, {0x11001, 0x11001},
+		{0x11038, 0x11046}, {0x1107F, 0x11081}, {0x110B3, 0x110B6}, {0x110B9, 0x110BA}, {0x11100, 0x11102},
+		{0x11127, 0x1112B}, {0x1112D, 0x11134}, {0x1D167, 0x1D169}, {0x1D17B, 0x1D182}, {0x1D185, 0x1D18B},
+		{0x1D1AA, 0x1D1AD}, {0x1D242, 0x1D244}, {0x1E8D0, 0x1E8D6}, {0x1E944, 0x1E94A}, {0x1F3FB, 0x1F3FF},
+		{0xE0001, 0xE0001}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF}
+	});
+
+	// East Asian Wide and Fullwidth characters, and the emoji shown as pictures by default
+	constexpr std::array wide = std::to_array<CodePointRange>({
+		{0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+		{0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+		{0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+		{0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+		{0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+		{0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+		{0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+		{0x2E80, 0x2E99}, {0x2E9B, 0x2EF3}, {0x2F00, 0x2FD5}, {0x2FF0, 0x2FFB}, {0x3000, 0x303E},
+		{0x3041, 0x3096}, {0x3099, 0x30FF}, {0x3105, 0x312F}, {0x3131, 0x318E}, {0x3190, 0x31E3},
+		{0x31F0, 0x321E}, {0x3220, 0x3247}, {0x3250, 0x4DBF}, {0x4E00, 0xA48C}, {0xA490, 0xA4C6},
+		{0xA960, 0xA97C}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE52},
+		{0xFE54, 0xFE66}, {0xFE68, 0xFE6B}, {0xFF01, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+		{0x16FF0, 0x16FF1}, {0x17000, 0x187F7}, {0x18800, 0x18CD5}, {0x18D00, 0x18D08}, {0x1AFF0, 0x1AFF3},
+		{0x1AFF5, 0x1AFFB}, {0x1AFFD, 0x1AFFE}, {0x1B000, 0x1B122}, {0x1B132, 0x1B132}, {0x1B150, 0x1B152},
+		{0x1B155, 0x1B155}, {0x1B164, 0x1B167}, {0x1B170, 0x1B2FB}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+		{0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F202}, {0x1F210, 0x1F23B}, {0x1F240, 0x1F248},
+		{0x1F250, 0x1F251}, {0x1F260, 0x1F265}, {0x1F300, 0x1F320}, {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C},
+		{0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4},
+		{0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E},
+		{0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F},
+		{0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7}, {0x1F6DC, 0x1F6DF},
+		{0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB}, {0x1F7F0, 0x1F7F0}, {0x1F90C, 0x1F93A},
+		{0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FA7C}, {0x1FA80, 0x1FA88}, {0x1FA90, 0x1FABD},
+		{0x1FABF, 0x1FAC5}, {0x1FACE, 0x1FADB}, {0x1FAE0, 0x1FAE8}, {0x1FAF0, 0x1FAF8}, {0x20000, 0x2FFFD},
+		{0x30000, 0x3FFFD}
+	});
+
+	constexpr bool sortedAndDisjoint(const std::span<const CodePointRange> ranges) {
+		for (std::size_t index = 0; index < ranges.size(); index++) {
+			if (ranges[index].first > ranges[index].last ||
+			    (index > 0 && ranges[index - 1].last >= ranges[index].first)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(sortedAndDisjoint(zeroWidth) && sortedAndDisjoint(wide), "The width tables are binary searched");
+
+	constexpr char32_t zeroWidthJoiner = 0x200D;
+	constexpr char32_t emojiPresentation = 0xFE0F;
+	constexpr char32_t replacementCharacter = 0xFFFD;
+
+	bool inTable(const std::span<const CodePointRange> ranges, const char32_t codePoint) {
+		// The first range that ends at or after the code point is the only one that can hold it
+		const auto found = std::ranges::lower_bound(ranges, codePoint, {}, &CodePointRange::last);
+		return found != ranges.end() && found->first <= codePoint;
+	}
+
+	std::size_t codePointWidth(const char32_t codePoint) {
+		if (codePoint < 0x20 || (codePoint >= 0x7F && codePoint < 0xA0)) {
+			return 0; // Control characters
+		}
+		if (codePoint < 0x300) {
+			return 1;
+		}
+		if (inTable(zeroWidth, codePoint)) {
+			return 0;
+		}
+		return inTable(wide, codePoint) ? 2 : 1;
+	}
+
+	bool isRegionalIndicator(const char32_t codePoint) {
+		return codePoint >= 0x1F1E6 && codePoint <= 0x1F1FF;
+	}
+
+	struct Decoded {
+		char32_t codePoint;
+		std::size_t length;
+	};
+
+	// Decodes the code point at the start of the text. A malformed sequence is one byte shown as U+FFFD
+	Decoded decode(const std::string_view text, const std::size_t position) {
+		const auto byte = [&](const std::size_t offset) {
+			return static_cast<unsigned char>(text[position + offset]);
+		};
+		const std::size_t left = text.size() - position;
+		const unsigned char lead = byte(0);
+		std::size_t length;
+		char32_t codePoint;
+		if (lead < 0x80) {
+			return {lead, 1};
+		}
+		if (lead >= 0xC2 && lead <= 0xDF) {
+			length = 2;
+			codePoint = lead & 0x1F;
+		} else if (lead >= 0xE0 && lead <= 0xEF) {
+			length = 3;
+			codePoint = lead & 0x0F;
+		} else if (lead >= 0xF0 && lead <= 0xF4) {
+			length = 4;
+			codePoint = lead & 0x07;
+		} else {
+			return {replacementCharacter, 1};
+		}
+		if (left < length) {
+			return {replacementCharacter, 1};
+		}
+		for (std::size_t offset = 1; offset < length; offset++) {
+			if ((byte(offset) & 0xC0) != 0x80) {
+				return {replacementCharacter, 1};
+			}
+			codePoint = codePoint << 6 | (byte(offset) & 0x3F);
+		}
+		// Overlong forms, surrogates and code points past U+10FFFF
+		if ((length == 3 && codePoint < 0x800) || (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) ||
+		    (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+			return {replacementCharacter, 1};
+		}
+		return {codePoint, length};
+	}
+
+	struct Cluster {
+		std::size_t end;
+		std::size_t width;
+	};
+
+	// Reads the grapheme cluster starting at `position`: a character and the zero width characters joined to it
+	Cluster nextCluster(const std::string_view text, const std::size_t position) {
+		const auto [base, baseLength] = decode(text, position);
+		std::size_t end = position + baseLength;
+		std::size_t width = codePointWidth(base);
+
+		// Two regional indicators are a flag
+		if (isRegionalIndicator(base) && end < text.size()) {
+			if (const auto [next, nextLength] = decode(text, end); isRegionalIndicator(next)) {
+				end += nextLength;
+				width = 2;
+			}
+		}
+
+		while (end < text.size()) {
+			const auto [next, nextLength] = decode(text, end);
+			if (next == zeroWidthJoiner) {
+				// Whatever follows a joiner is part of the same picture, like the members of a family emoji
+				end += nextLength;
+				if (end < text.size()) {
+					end += decode(text, end).length;
+				}
+			} else if (next == emojiPresentation) {
+				end += nextLength;
+				width = width == 1 ? 2 : width;
+			} else if (next >= 0x300 && inTable(zeroWidth, next)) {
+				end += nextLength;
+			} else {
+				break;
+			}
+		}
+		return {end, width};
+	}
+
+	// The number of printable ASCII bytes (0x20 to 0x7E) at the start of the text, each of them one column wide
+	std::size_t asciiPrefix(const char *data, const std::size_t size) {
+		std::size_t index = 0;
+#if defined(__AVX2__)
+		const __m256i below32 = _mm256_set1_epi8(0x1F);
+		const __m256i delete32 = _mm256_set1_epi8(0x7F);
+		for (; index + 32 <= size; index += 32) {
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + index));
+			// Signed compares, so bytes of 0x80 and up are negative and fail the first one
+			const __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, below32),
+			                                           _mm256_cmpgt_epi8(delete32, bytes));
+			if (const auto other = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(printable)); other != 0) {
+				return index + std::countr_zero(other);
+			}
+		}
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+		const __m128i below = _mm_set1_epi8(0x1F);
+		const __m128i del = _mm_set1_epi8(0x7F);
+		for (; index + 16 <= size; index += 16) {
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index));
+			const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, below), _mm_cmplt_epi8(bytes, del));
+			if (const auto other = ~static_cast<std::uint32_t>(_mm_movemask_epi8(printable)) & 0xFFFF; other != 0) {
+				return index + std::countr_zero(other);
+			}
+		}
+#elif defined(__ARM_NEON)
+		const uint8x16_t below = vdupq_n_u8(0x20);
+		const uint8x16_t del = vdupq_n_u8(0x7F);
+		for (; index + 16 <= size; index += 16) {
+			const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const std::uint8_t *>(data + index));
+			const uint8x16_t printable = vandq_u8(vcgeq_u8(bytes, below), vcltq_u8(bytes, del));
+			if (vminvq_u8(printable) != 0xFF) {
+				break; // The scalar loop finds where in these 16 bytes the run ends
+			}
+		}
+#endif
+		while (index < size && data[index] >= 0x20 && data[index] < 0x7F) {
+			index++;
+		}
+		return index;
+	}
+}
+
+std::size_t tike::displayWidth(const std::string_view text) {
+	std::size_t width = 0;
+	std::size_t position = 0;
+	while (position < text.size()) {
+		// All but the last byte of an ASCII run are whole clusters, the last one may get combining marks
+		if (const std::size_t run = asciiPrefix(text.data() + position, text.size() - position); run > 1) {
+			width += run - 1;
+			position += run - 1;
+		}
+		const auto [end, clusterWidth] = nextCluster(text, position);
+		width += clusterWidth;
+		position = end;
+	}
+	return width;
+}
+
+tike::TextFit tike::fitToWidth(const std::string_view text, const std::size_t columns) {
+	TextFit fit;
+	while (fit.bytes < text.size()) {
+		if (const std::size_t run = asciiPrefix(text.data() + fit.bytes, text.size() - fit.bytes); run > 1) {
+			// The byte after each of these is ASCII too, so any of them can end the fit
+			const std::size_t take = std::min(run - 1, columns - fit.width);
+			fit.bytes += take;
+			fit.width += take;
+			if (fit.width == columns) {
+				break;
+			}
+		}
+		const auto [end, width] = nextCluster(text, fit.bytes);
+		if (fit.width + width > columns) {
+			break;
+		}
+		fit.bytes = end;
+		fit.width += width;
+	}
+	return fit;
+}
+
+std::string tike::fitCell(const std::string_view text, const std::size_t columns) {
+	if (columns == 0) {
+		return "";
+	}
+	TextFit fit = fitToWidth(text, columns);
+	std::string cell(text.substr(0, fit.bytes));
+	if (fit.bytes < text.size()) {
+		fit = fitToWidth(text, columns - 1);
+		cell.resize(fit.bytes);
+		cell += "…";
+		fit.width++;
+	}
+	cell.append(columns - fit.width, ' ');
+	return cell;
+}
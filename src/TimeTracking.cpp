@@ -0,0 +1,156 @@
+#include "TimeTracking.h"
+
+#include <stdexcept>
+
+namespace {
+	/*
+	 * Ids of the intervals that may overlap [?1, ?2]: finished ones from the R*Tree, plus the running one through
+	 * the partial index. The R*Tree bounds are rounded outwards, callers check the exact times
+	 */
+	constexpr auto overlapCandidates = R"(
+		WITH candidates(id) AS (
+			SELECT id FROM intervalIndex WHERE startedAt <= ?2 AND stoppedAt >= ?1
+			UNION ALL
+			SELECT id FROM intervals WHERE stoppedAt IS NULL
+		)
+	)";
+
+	std::optional<tike::TrackedInterval> runningInterval(const db::Database &db) {
+		db::Statement statement = db.prepare(R"(
+			SELECT i.taskId, COALESCE(t.title, c.title, '(removed task)'), i.startedAt
+			FROM intervals i
+			LEFT JOIN tasks t ON t.id = i.taskId
+			LEFT JOIN completedTasks c ON c.taskId = i.taskId
+			WHERE i.stoppedAt IS NULL
+		)");
+		if (!statement.step()) {
+			return std::nullopt;
+		}
+		tike::TrackedInterval interval;
+		interval.taskId = statement.columnInt64(0);
+		interval.title = statement.columnText(1);
+		interval.startedAt = statement.columnInt64(2);
+		interval.running = true;
+		return interval;
+	}
+}
+
+void tike::ensureTimeTracking(const db::Database &db) {
+	db.execute(R"(
+		CREATE TABLE IF NOT EXISTS intervals (
+			id INTEGER PRIMARY KEY AUTOINCREMENT,
+			taskId INTEGER NOT NULL,
+			startedAt INTEGER NOT NULL,
+			stoppedAt INTEGER
+		);
+		CREATE INDEX IF NOT EXISTS intervalsRunning ON intervals (stoppedAt) WHERE stoppedAt IS NULL;
+		CREATE VIRTUAL TABLE IF NOT EXISTS intervalIndex USING rtree(id, startedAt, stoppedAt);
+
+		CREATE TRIGGER IF NOT EXISTS intervalsIndexInsert AFTER INSERT ON intervals
+		WHEN NEW.stoppedAt IS NOT NULL BEGIN
+			INSERT INTO intervalIndex (id, startedAt, stoppedAt) VALUES (NEW.id, NEW.startedAt, NEW.stoppedAt);
+		END;
+		CREATE TRIGGER IF NOT EXISTS intervalsIndexUpdate AFTER UPDATE OF startedAt, stoppedAt ON intervals BEGIN
+			DELETE FROM intervalIndex WHERE id = OLD.id;
+			INSERT INTO intervalIndex (id, startedAt, stoppedAt)
+			SELECT NEW.id, NEW.startedAt, NEW.stoppedAt WHERE NEW.stoppedAt IS NOT NULL;
+		END;
+		CREATE TRIGGER IF NOT EXISTS intervalsIndexDelete AFTER DELETE ON intervals BEGIN
+			DELETE FROM intervalIndex WHERE id = OLD.id;
+		END;
+	)");
+}
+
+std::int64_t tike::parseLocalTime(const db::Database &db, const std::string_view text) {
+	// A bare "HH:MM" means today. SQLite turns the local time into UTC and yields NULL for anything invalid
+	db::Statement statement = db.prepare(R"(
+		SELECT CAST(strftime('%s', CASE WHEN length(?1) <= 5 THEN date('now', 'localtime') || ' ' || ?1 ELSE ?1 END,
+		                        'utc') AS INTEGER)
+	)");
+	statement.bind(1, std::string(text));
+	if (text.empty() || !statement.step() || statement.columnIsNull(0)) {
+		throw std::invalid_argument("Invalid time, expected HH:MM or YYYY-MM-DD [HH:MM]: " + std::string(text));
+	}
+	return statement.columnInt64(0);
+}
+
+std::optional<tike::TrackedInterval> tike::startInterval(const db::Database &db, const std::int64_t taskId,
+                                                         const std::int64_t now) {
+	std::optional<TrackedInterval> stopped = stopInterval(db, now);
+
+	db::Statement statement = db.prepare("INSERT INTO intervals (taskId, startedAt) VALUES (?, ?)");
+	statement.bindInt64(1, taskId).bindInt64(2, now);
+	statement.step();
+	return stopped;
+}
+
+std::optional<tike::TrackedInterval> tike::stopInterval(const db::Database &db, const std::int64_t now) {
+	std::optional<TrackedInterval> interval = runningInterval(db);
+	if (!interval) {
+		return std::nullopt;
+	}
+
+	// The update trigger moves the interval into the R*Tree
+	db::Statement statement = db.prepare("UPDATE intervals SET stoppedAt = MAX(startedAt, ?) WHERE stoppedAt IS NULL");
+	statement.bindInt64(1, now);
+	statement.step();
+
+	interval->stoppedAt = std::max(interval->startedAt, now);
+	interval->running = false;
+	return interval;
+}
+
+std::vector<tike::TrackedInterval> tike::intervalsBetween(const db::Database &db, const std::int64_t from,
+                                                          const std::int64_t to, const std::int64_t now) {
+	std::vector<TrackedInterval> intervals;
+	if (!db.hasTable("intervals")) {
+		return intervals;
+	}
+
+	db::Statement statement = db.prepare(std::string(overlapCandidates) + R"(
+		SELECT i.taskId, COALESCE(t.title, c.title, '(removed task)'),
+		       MAX(i.startedAt, ?1), MIN(COALESCE(i.stoppedAt, ?3), ?2), i.stoppedAt IS NULL
+		FROM candidates
+		JOIN intervals i ON i.id = candidates.id
+		LEFT JOIN tasks t ON t.id = i.taskId
+		LEFT JOIN completedTasks c ON c.taskId = i.taskId
+		WHERE i.startedAt < ?2 AND COALESCE(i.stoppedAt, ?3) > ?1
+		ORDER BY i.startedAt
+	)");
+	statement.bindInt64(1, from).bindInt64(2, to).bindInt64(3, now);
+	while (statement.step()) {
+		TrackedInterval interval;
+		interval.taskId = statement.columnInt64(0);
+		interval.title = statement.columnText(1);
+		interval.startedAt = statement.columnInt64(2);
+		interval.stoppedAt = statement.columnInt64(3);
+		interval.running = statement.columnInt64(4) != 0;
+		intervals.push_back(std::move(interval));
+	}
+	return intervals;
+}
+
+std::vector<tike::TrackedTotal> tike::totalsBetween(const db::Database &db, const std::int64_t from,
+                                                    const std::int64_t to, const std::int64_t now) {
+	std::vector<TrackedTotal> totals;
+	if (!db.hasTable("intervals")) {
+		return totals;
+	}
+
+	db::Statement statement = db.prepare(std::string(overlapCandidates) + R"(
+		SELECT i.taskId, COALESCE(t.title, c.title, '(removed task)'),
+		       SUM(MIN(COALESCE(i.stoppedAt, ?3), ?2) - MAX(i.startedAt, ?1)) AS seconds
+		FROM candidates
+		JOIN intervals i ON i.id = candidates.id
+		LEFT JOIN tasks t ON t.id = i.taskId
+		LEFT JOIN completedTasks c ON c.taskId = i.taskId
+		WHERE i.startedAt < ?2 AND COALESCE(i.stoppedAt, ?3) > ?1
+		GROUP BY i.taskId
+		ORDER BY seconds DESC
+	)");
+	statement.bindInt64(1, from).bindInt64(2, to).bindInt64(3, now);
+	while (statement.step()) {
+		totals.push_back({statement.columnInt64(0), std::string(statement.columnText(1)), statement.columnInt64(2)});
+	}
+	return totals;
+}
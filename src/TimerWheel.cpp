@@ -0,0 +1,108 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <ranges>
+#include <utility>
+
+tike::TimerWheel::TimerWheel(const std::int64_t now) : current(now) {
+	slots.fill(none);
+}
+
+tike::TimerWheel::Handle tike::TimerWheel::schedule(const std::int64_t deadline, const std::int64_t key) {
+	Handle handle;
+	if (freeList != none) {
+		handle = freeList;
+		freeList = timers[handle].next;
+	} else {
+		handle = static_cast<Handle>(timers.size());
+		timers.emplace_back();
+	}
+	timers[handle] = Timer{.deadline = deadline, .key = key};
+	place(handle);
+	pending++;
+	return handle;
+}
+
+void tike::TimerWheel::cancel(const Handle handle) {
+	unlink(handle);
+	release(handle);
+}
+
+std::vector<std::int64_t> tike::TimerWheel::advance(const std::int64_t now) {
+	std::vector<std::pair<std::int64_t, std::int64_t>> fired;
+	while (current < now && pending > 0) {
+		const std::int64_t tick = current + 1;
+
+		// Bring the timers of every coarser slot the wheel enters on this tick down a level or more
+		for (int level = levelCount - 1; level > 0; level--) {
+			if ((tick & ((std::int64_t{1} << (level * levelBits)) - 1)) != 0) {
+				continue;
+			}
+			const auto slot = static_cast<std::uint32_t>(level * slotCount + ((tick >> (level * levelBits)) & (slotCount - 1)));
+			Handle handle = slots[slot];
+			slots[slot] = none;
+			while (handle != none) {
+				const Handle next = timers[handle].next;
+				place(handle);
+				handle = next;
+			}
+		}
+
+		Handle &due = slots[tick & (slotCount - 1)];
+		while (due != none) {
+			const Handle handle = due;
+			fired.emplace_back(timers[handle].deadline, timers[handle].key);
+			unlink(handle);
+			release(handle);
+		}
+		current = tick;
+	}
+	current = std::max(current, now);
+
+	std::ranges::sort(fired);
+	std::vector<std::int64_t> keys;
+	keys.reserve(fired.size());
+	for (const auto &key: fired | std::views::values) {
+		keys.push_back(key);
+	}
+	return keys;
+}
+
+void tike::TimerWheel::place(const Handle handle) {
+	Timer &timer = timers[handle];
+	const std::int64_t base = current + 1;
+	// Overdue timers go to the next tick, timers past the last level wait in it and are placed again later
+	const std::int64_t target = std::clamp(timer.deadline, base,
+	                                       base + (std::int64_t{1} << (levelCount * levelBits)) - 1);
+
+	// The finest level whose slot the wheel reaches before its field wraps around
+	int level = 0;
+	while (level < levelCount - 1 && (target >> ((level + 1) * levelBits)) != (base >> ((level + 1) * levelBits))) {
+		level++;
+	}
+	timer.slot = static_cast<std::uint32_t>(level * slotCount + ((target >> (level * levelBits)) & (slotCount - 1)));
+	timer.previous = none;
+	timer.next = slots[timer.slot];
+	if (timer.next != none) {
+		timers[timer.next].previous = handle;
+	}
+	slots[timer.slot] = handle;
+}
+
+void tike::TimerWheel::unlink(const Handle handle) {
+	const Timer &timer = timers[handle];
+	if (timer.previous != none) {
+		timers[timer.previous].next = timer.next;
+	} else {
+		slots[timer.slot] = timer.next;
+	}
+	if (timer.next != none) {
+		timers[timer.next].previous = timer.previous;
+	}
+}
+
+void tike::TimerWheel::release(const Handle handle) {
+	timers[handle].next = freeList;
+	freeList = handle;
+	pending--;
+}
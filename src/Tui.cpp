@@ -0,0 +1,532 @@
+#include "Tui.h"
+
+#include "TextWidth.h"
+#include "Watch.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+	constexpr std::size_t maxPages = 64;
+
+	enum class Key {
+		Timeout,
+		Up,
+		Down,
+		PageUp,
+		PageDown,
+		Home,
+		End,
+		Enter,
+		Escape,
+		Backspace,
+		Character
+	};
+
+	struct KeyPress {
+		Key key = Key::Timeout;
+		char character = 0;
+	};
+
+#ifndef _WIN32
+	// Raw input on the alternate screen, restored however the interactive mode ends
+	class RawTerminal {
+	public:
+		RawTerminal() {
+			if (!::isatty(STDIN_FILENO) || ::tcgetattr(STDIN_FILENO, &saved) != 0) {
+				throw std::runtime_error("The interactive mode needs a terminal");
+			}
+			termios raw = saved;
+			// Ctrl+C arrives as a key, so quitting always goes through the destructor
+			raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+			raw.c_iflag &= ~(IXON | ICRNL);
+			raw.c_cc[VMIN] = 1;
+			raw.c_cc[VTIME] = 0;
+			::tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+			std::cout << "\x1b[?1049h\x1b[?25l" << std::flush;
+		}
+
+		~RawTerminal() {
+			std::cout << "\x1b[?25h\x1b[?1049l" << std::flush;
+			::tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+		}
+
+		RawTerminal(const RawTerminal &) = delete;
+
+		RawTerminal &operator=(const RawTerminal &) = delete;
+
+	private:
+		termios saved{};
+	};
+
+	bool readByte(char &byte, const int timeoutMs) {
+		pollfd input{STDIN_FILENO, POLLIN, 0};
+		return ::poll(&input, 1, timeoutMs) > 0 && ::read(STDIN_FILENO, &byte, 1) == 1;
+	}
+
+	// Waits a while for a key, a second unless the caller has something to look at sooner
+	KeyPress readKey(const int timeoutMs = 1000) {
+		char byte;
+		if (!readByte(byte, timeoutMs)) {
+			return {};
+		}
+		if (byte == '\r' || byte == '\n') {
+			return {Key::Enter};
+		}
+		if (byte == 127 || byte == 8) {
+			return {Key::Backspace};
+		}
+		if (byte != '\x1b') {
+			return {Key::Character, byte};
+		}
+
+		// The rest of an escape sequence arrives right away, a lone escape is the Escape key
+		char introducer, final;
+		if (!readByte(introducer, 30) || (introducer != '[' && introducer != 'O') || !readByte(final, 30)) {
+			return {Key::Escape};
+		}
+		switch (final) {
+			case 'A': return {Key::Up};
+			case 'B': return {Key::Down};
+			case 'H': return {Key::Home};
+			case 'F': return {Key::End};
+			default: break;
+		}
+		// "ESC [ n ~" keys
+		char tilde;
+		if (final < '0' || final > '9' || !readByte(tilde, 30) || tilde != '~') {
+			return {Key::Escape};
+		}
+		switch (final) {
+			case '1':
+			case '7': return {Key::Home};
+			case '4':
+			case '8': return {Key::End};
+			case '5': return {Key::PageUp};
+			case '6': return {Key::PageDown};
+			default: return {Key::Escape};
+		}
+	}
+#endif
+}
+
+tike::TaskPager::Reader::Reader(const std::string &dbPath)
+	: db(dbPath, db::OpenMode::ReadOnly),
+	  forward(db.prepare(R"(
+		SELECT id, title, COALESCE(timeCreated, '') FROM tasks
+		WHERE id > ?1 AND (?2 = '' OR instr(lower(title), lower(?2)) > 0)
+		ORDER BY id LIMIT ?3
+	  )")),
+	  backward(db.prepare(R"(
+		SELECT id, title, COALESCE(timeCreated, '') FROM tasks
+		WHERE id < ?1 AND (?2 = '' OR instr(lower(title), lower(?2)) > 0)
+		ORDER BY id DESC LIMIT ?3
+	  )")) {
+}
+
+std::vector<tike::TaskRow> tike::TaskPager::Reader::read(const bool forwards, const std::int64_t id,
+                                                         const std::string &filter, const std::size_t count) {
+	db::Statement &statement = forwards ? forward : backward;
+	statement.bindInt64(1, id).bind(2, filter).bindInt64(3, static_cast<std::int64_t>(count));
+
+	std::vector<TaskRow> rows;
+	try {
+		while (statement.step()) {
+			rows.push_back(TaskRow{
+				statement.columnInt64(0), std::string(statement.columnText(1)), std::string(statement.columnText(2))
+			});
+		}
+	} catch (const std::exception &) {
+		// An interrupted search ends here, the statement has to be reset before it can be bound again
+		statement.reset();
+		throw;
+	}
+	// Done statements hold no lock, but reset anyway so both queries are ready for the next page
+	statement.reset();
+	if (!forwards) {
+		std::ranges::reverse(rows);
+	}
+	return rows;
+}
+
+tike::TaskPager::TaskPager(const std::string &dbPath, const std::size_t pageSize)
+	: reader(dbPath), pageSize(std::max<std::size_t>(pageSize, 1)), dataVersion(reader.db.dataVersion()) {
+	worker = std::thread(&TaskPager::prefetchLoop, this, dbPath);
+}
+
+tike::TaskPager::~TaskPager() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+std::vector<tike::TaskRow> tike::TaskPager::after(const std::int64_t id, const std::size_t count) {
+	return page(true, id, count);
+}
+
+std::vector<tike::TaskRow> tike::TaskPager::before(const std::int64_t id, const std::size_t count) {
+	return page(false, id, count);
+}
+
+void tike::TaskPager::setFilter(std::string text) {
+	filterText = std::move(text);
+	std::lock_guard lock(mutex);
+	sharedFilter = filterText;
+	dropPages();
+}
+
+void tike::TaskPager::search(std::string text, const std::size_t count) {
+	{
+		std::lock_guard lock(mutex);
+		forgetSearch();
+		pendingSearch = std::move(text);
+		searchCount = count;
+	}
+	wake.notify_one();
+}
+
+std::optional<std::vector<tike::TaskRow>> tike::TaskPager::searchResult() {
+	std::lock_guard lock(mutex);
+	if (workerStopped && pendingSearch) {
+		// Without the thread the search runs here, the same as every page does
+		const std::string text = *std::exchange(pendingSearch, std::nullopt);
+		try {
+			searchRows = reader.read(true, 0, text, searchCount);
+		} catch (const std::exception &) {
+			searchError = std::current_exception();
+		}
+		searchDone = true;
+	}
+	if (!searchDone) {
+		return std::nullopt;
+	}
+	searchDone = false;
+	if (searchError) {
+		std::rethrow_exception(std::exchange(searchError, nullptr));
+	}
+	return std::exchange(searchRows, {});
+}
+
+void tike::TaskPager::cancelSearch() {
+	std::lock_guard lock(mutex);
+	forgetSearch();
+	pendingSearch.reset();
+}
+
+bool tike::TaskPager::changed() {
+	const std::int64_t version = reader.db.dataVersion();
+	if (version == dataVersion) {
+		return false;
+	}
+	dataVersion = version;
+	std::lock_guard lock(mutex);
+	dropPages();
+	return true;
+}
+
+void tike::TaskPager::prefetch(const std::int64_t firstId, const std::int64_t lastId) {
+	{
+		std::lock_guard lock(mutex);
+		// Only the neighbours of what is on screen now matter, older requests are dropped
+		requests.clear();
+		for (const PageKey &key: {PageKey{true, lastId}, PageKey{false, firstId}}) {
+			if (!pages.contains(key)) {
+				requests.push_back(key);
+			}
+		}
+	}
+	wake.notify_one();
+}
+
+void tike::TaskPager::prefetchLoop(const std::string dbPath) {
+	try {
+		Reader own(dbPath);
+		std::unique_lock lock(mutex);
+		for (;;) {
+			wake.wait(lock, [this] { return stopping || pendingSearch || !requests.empty(); });
+			if (stopping) {
+				return;
+			}
+			// Someone is waiting for a search, pages are only ever a guess
+			if (pendingSearch) {
+				runSearch(own, lock);
+				continue;
+			}
+			const PageKey key = requests.front();
+			requests.pop_front();
+			const std::uint64_t startedAt = generation;
+			const std::string filter = sharedFilter;
+
+			lock.unlock();
+			std::vector<TaskRow> rows = own.read(key.first, key.second, filter, pageSize);
+			lock.lock();
+
+			// A page read while the data or the filter changed is of no use
+			if (generation == startedAt) {
+				if (pages.size() >= maxPages) {
+					pages.clear();
+				}
+				pages.insert_or_assign(key, std::move(rows));
+			}
+		}
+	} catch (const std::exception &) {
+		// Without prefetching every page is read when it is needed, which still works. So are searches
+		std::lock_guard lock(mutex);
+		workerStopped = true;
+	}
+}
+
+void tike::TaskPager::runSearch(Reader &own, std::unique_lock<std::mutex> &lock) {
+	const std::uint64_t number = searchNumber;
+	const std::string text = *std::exchange(pendingSearch, std::nullopt);
+	const std::size_t count = searchCount;
+	runningSearch = number;
+	searchDb = &own.db;
+
+	lock.unlock();
+	std::vector<TaskRow> rows;
+	std::exception_ptr error;
+	try {
+		rows = own.read(true, 0, text, count);
+	} catch (const std::exception &) {
+		error = std::current_exception();
+	}
+	lock.lock();
+
+	runningSearch = 0;
+	searchDb = nullptr;
+	// An interrupted search always has a newer one after it, only that one is reported
+	if (number == searchNumber) {
+		searchRows = std::move(rows);
+		searchError = error;
+		searchDone = true;
+	}
+}
+
+void tike::TaskPager::forgetSearch() {
+	searchNumber++;
+	searchDone = false;
+	searchRows.clear();
+	searchError = nullptr;
+	// Called with the mutex held, so the connection can't finish the search and go away meanwhile. When it has
+	// just finished the interrupt does nothing, and the result is dropped by its number instead
+	if (runningSearch != 0) {
+		searchDb->interrupt();
+	}
+}
+
+void tike::TaskPager::dropPages() {
+	generation++;
+	pages.clear();
+	requests.clear();
+}
+
+std::vector<tike::TaskRow> tike::TaskPager::page(const bool forwards, const std::int64_t id, const std::size_t count) {
+	if (count <= pageSize) {
+		std::lock_guard lock(mutex);
+		if (const auto found = pages.find({forwards, id}); found != pages.end()) {
+			const std::vector<TaskRow> &rows = found->second;
+			const std::size_t take = std::min(count, rows.size());
+			// A page before an id ends right before it, so the rows closest to the id are at its end
+			return forwards
+				       ? std::vector(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(take))
+				       : std::vector(rows.end() - static_cast<std::ptrdiff_t>(take), rows.end());
+		}
+	}
+	return reader.read(forwards, id, filterText, count);
+}
+
+void tike::runTui(TaskPager &pager, const TuiActions &actions) {
+#ifdef _WIN32
+	throw std::runtime_error("The interactive mode is not available on Windows");
+#else
+	RawTerminal terminal;
+	TerminalDiff screen;
+	constexpr std::int64_t lastId = std::numeric_limits<std::int64_t>::max();
+
+	std::vector<TaskRow> rows;
+	std::size_t cursor = 0;
+	std::size_t height = 0;
+	std::string status = "j/k or arrows move, / search, c complete, d remove, q quit";
+
+	// Reads the window again from its first row, after the data, the filter or the screen size changed
+	const auto reload = [&] {
+		const std::int64_t first = rows.empty() ? 0 : rows.front().id - 1;
+		rows = pager.after(first, height);
+		if (rows.size() < height) {
+			std::vector<TaskRow> earlier = pager.before(rows.empty() ? lastId : rows.front().id, height - rows.size());
+			rows.insert(rows.begin(), earlier.begin(), earlier.end());
+		}
+		cursor = rows.empty() ? 0 : std::min(cursor, rows.size() - 1);
+	};
+
+	TerminalSize size;
+	// The rows under a heading for the filter, with the given status line below
+	const auto render = [&](const std::string &filter, const std::string &bottom) {
+		std::vector<std::string> frame;
+		frame.push_back(filter.empty() ? "Open tasks" : "Open tasks containing \"" + filter + "\"");
+		const std::size_t titleWidth = size.columns > 24 ? size.columns - 24 : 10;
+		for (std::size_t index = 0; index < height; index++) {
+			if (index < rows.size()) {
+				frame.push_back((index == cursor ? "> " : "  ") + fitCell(rows[index].title, titleWidth) + " " +
+				                rows[index].timeCreated);
+			} else {
+				frame.emplace_back(index == 0 ? "  No tasks" : "");
+			}
+		}
+		frame.push_back(bottom);
+		return frame;
+	};
+
+	for (;;) {
+		size = terminalSize();
+		if (const std::size_t rowsOnScreen = std::max<std::size_t>(size.rows, 3) - 2; rowsOnScreen != height) {
+			height = rowsOnScreen;
+			reload();
+		}
+
+		std::cout << screen.update(render(pager.filter(), status)) << std::flush;
+		if (!rows.empty()) {
+			pager.prefetch(rows.front().id, rows.back().id);
+		}
+
+		const auto [key, character] = readKey();
+		if (key == Key::Timeout) {
+			// Nothing pressed, pick up what other tike processes changed meanwhile
+			if (pager.changed()) {
+				reload();
+			}
+			continue;
+		}
+
+		if (key == Key::Character && (character == 'q' || character == 3)) {
+			return;
+		}
+		if (key == Key::Up || (key == Key::Character && character == 'k')) {
+			if (cursor > 0) {
+				cursor--;
+			} else if (!rows.empty()) {
+				if (const std::vector<TaskRow> previous = pager.before(rows.front().id, 1); !previous.empty()) {
+					rows.insert(rows.begin(), previous.front());
+					rows.pop_back();
+				}
+			}
+		} else if (key == Key::Down || (key == Key::Character && character == 'j')) {
+			if (cursor + 1 < rows.size()) {
+				cursor++;
+			} else if (!rows.empty()) {
+				if (const std::vector<TaskRow> next = pager.after(rows.back().id, 1); !next.empty()) {
+					rows.push_back(next.front());
+					rows.erase(rows.begin());
+				}
+			}
+		} else if (key == Key::PageDown || (key == Key::Character && character == ' ')) {
+			const std::vector<TaskRow> next = rows.empty() ? std::vector<TaskRow>() : pager.after(rows.back().id, height);
+			if (next.empty()) {
+				cursor = rows.empty() ? 0 : rows.size() - 1;
+			} else {
+				rows.insert(rows.end(), next.begin(), next.end());
+				rows.erase(rows.begin(), rows.end() - static_cast<std::ptrdiff_t>(std::min(rows.size(), height)));
+			}
+		} else if (key == Key::PageUp) {
+			const std::vector<TaskRow> previous = rows.empty() ? std::vector<TaskRow>() : pager.before(rows.front().id, height);
+			if (previous.empty()) {
+				cursor = 0;
+			} else {
+				rows.insert(rows.begin(), previous.begin(), previous.end());
+				rows.resize(std::min(rows.size(), height));
+			}
+		} else if (key == Key::Home || (key == Key::Character && character == 'g')) {
+			rows = pager.after(0, height);
+			cursor = 0;
+		} else if (key == Key::End || (key == Key::Character && character == 'G')) {
+			rows = pager.before(lastId, height);
+			cursor = rows.empty() ? 0 : rows.size() - 1;
+		} else if (key == Key::Character && character == '/') {
+			// The status line turns into the search prompt until Enter or Escape. Each key starts a search on the
+			// prefetch thread, which interrupts the one for the text before, and its rows show up while typing
+			const std::vector<TaskRow> shownBefore = rows;
+			const std::size_t cursorBefore = cursor;
+			std::string search = pager.filter();
+			bool searching = false;
+			bool started = false;
+			bool accepted = false;
+			for (;;) {
+				if (searching) {
+					try {
+						if (std::optional<std::vector<TaskRow>> found = pager.searchResult()) {
+							rows = std::move(*found);
+							cursor = 0;
+							searching = false;
+						}
+					} catch (const std::exception &error) {
+						status = error.what();
+						rows = shownBefore;
+						cursor = cursorBefore;
+						break;
+					}
+				}
+				if (accepted && !searching) {
+					pager.setFilter(search);
+					status = search.empty() ? "Showing all tasks" : "Searching for \"" + search + "\"";
+					break;
+				}
+
+				std::cout << screen.update(render(search, "Search: " + search + (searching ? "  ..." : ""))) <<
+					std::flush;
+				// Looks for the rows often while a search runs
+				const auto [searchKey, searchCharacter] = readKey(searching ? 50 : 1000);
+				if (searchKey == Key::Escape) {
+					pager.cancelSearch();
+					rows = shownBefore;
+					cursor = cursorBefore;
+					break;
+				}
+				if (searchKey == Key::Enter) {
+					// Enter right away still starts over from the first match
+					accepted = true;
+					if (started) {
+						continue;
+					}
+				} else if (searchKey == Key::Backspace && !search.empty()) {
+					search.pop_back();
+				} else if (searchKey == Key::Character && static_cast<unsigned char>(searchCharacter) >= ' ') {
+					search += searchCharacter;
+				} else {
+					continue;
+				}
+				pager.search(search, height);
+				searching = true;
+				started = true;
+			}
+		} else if (key == Key::Character && (character == 'c' || character == 'd') && !rows.empty()) {
+			const TaskRow row = rows[cursor];
+			try {
+				if (character == 'c') {
+					status = actions.complete(row);
+				} else {
+					std::cout << screen.update(render(pager.filter(), "Remove \"" + row.title + "\"? (y/n)")) << std::flush;
+					KeyPress answer;
+					while ((answer = readKey()).key == Key::Timeout) {
+					}
+					status = answer.key == Key::Character && answer.character == 'y' ? actions.remove(row) : "Not removed";
+				}
+			} catch (const std::exception &error) {
+				status = error.what();
+			}
+			pager.changed();
+			reload();
+		}
+	}
+#endif
+}
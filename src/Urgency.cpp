@@ -0,0 +1,299 @@
+#include "Urgency.h"
+
+#include "Tags.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+	constexpr std::size_t chunkSize = 4096;
+	constexpr double secondsPerDay = 86400;
+	constexpr double secondsPerYear = 365 * secondsPerDay;
+	constexpr std::string_view tagPrefix = "tag.";
+
+	// One array per input of the score, index i of every array belongs to the same task
+	struct UrgencyColumns {
+		std::vector<double> created;
+		std::vector<double> due;
+		std::vector<double> hasDue;
+		std::vector<double> tagBonus;
+		std::vector<double> score;
+
+		explicit UrgencyColumns(const std::size_t size)
+			: created(size), due(size), hasDue(size), tagBonus(size), score(size) {
+		}
+	};
+
+	/*
+	 * The scoring kernel. No branches and no aliasing between the arrays, so the compiler turns the loop into
+	 * SIMD code (with -fno-trapping-math, see CMakeLists.txt). Tasks without a due date have hasDue 0, which zeroes
+	 * their due term. The blocking term is added afterwards, only for the few tasks that have dependencies
+	 */
+	void scoreChunk(const std::size_t size, const double *__restrict created, const double *__restrict due,
+	                const double *__restrict hasDue, const double *__restrict tagBonus, double *__restrict score,
+	                const double now, const tike::UrgencyWeights &weights) {
+		const double ageWeight = weights.age;
+		const double dueWeight = weights.due;
+		for (std::size_t index = 0; index < size; index++) {
+			const double age = std::min((now - created[index]) / secondsPerYear, 1.0);
+			const double daysLeft = (due[index] - now) / secondsPerDay;
+			const double dueTerm = std::clamp(0.2 + (14.0 - daysLeft) * (0.8 / 21.0), 0.2, 1.0) * hasDue[index];
+			score[index] = ageWeight * age + dueWeight * dueTerm + tagBonus[index];
+		}
+	}
+
+	/*
+	 * Seconds since the epoch of a "YYYY-MM-DD HH:MM:SS" timestamp, the format CURRENT_TIMESTAMP stores.
+	 * Parsing it here is several times cheaper than unixepoch() in the query. Other formats give std::nullopt
+	 */
+	std::optional<double> parseTimestamp(const std::string_view text) {
+		if (text.size() != 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' ||
+		    text[16] != ':') {
+			return std::nullopt;
+		}
+		bool valid = true;
+		const auto field = [&text, &valid](const std::size_t position, const std::size_t length) {
+			int value = 0;
+			for (std::size_t index = position; index < position + length; index++) {
+				valid = valid && text[index] >= '0' && text[index] <= '9';
+				value = value * 10 + (text[index] - '0');
+			}
+			return value;
+		};
+		const std::chrono::year_month_day date{
+			std::chrono::year(field(0, 4)), std::chrono::month(field(5, 2)), std::chrono::day(field(8, 2))
+		};
+		const int seconds = field(11, 2) * 3600 + field(14, 2) * 60 + field(17, 2);
+		if (!valid || !date.ok()) {
+			return std::nullopt;
+		}
+		return static_cast<double>(std::chrono::sys_days(date).time_since_epoch() / std::chrono::days(1)) *
+		       secondsPerDay + seconds;
+	}
+
+	/*
+	 * The dependency edges and the tasks they touch, read from the edge table alone so the cost follows the
+	 * number of edges rather than the number of tasks. Whether a task on either end is still open is learnt
+	 * while the cursor walks past it
+	 */
+	struct Dependencies {
+		std::vector<std::pair<std::int64_t, std::int64_t>> edges;
+		std::vector<std::int64_t> tasks;
+
+		explicit Dependencies(const db::Database &db) {
+			if (!db.hasTable("taskDependencies")) {
+				return;
+			}
+			db::Statement statement = db.prepare("SELECT taskId, blockedBy FROM taskDependencies");
+			while (statement.step()) {
+				const std::int64_t taskId = statement.columnInt64(0);
+				const std::int64_t blockedBy = statement.columnInt64(1);
+				edges.emplace_back(taskId, blockedBy);
+				tasks.push_back(taskId);
+				tasks.push_back(blockedBy);
+			}
+			std::ranges::sort(tasks);
+			tasks.erase(std::ranges::unique(tasks).begin(), tasks.end());
+		}
+
+		[[nodiscard]] std::size_t indexOf(const std::int64_t taskId) const {
+			return static_cast<std::size_t>(std::ranges::lower_bound(tasks, taskId) - tasks.begin());
+		}
+	};
+
+	// Heap order: the more urgent task, or the older one on a tie, compares as smaller
+	bool moreUrgent(const tike::RankedTask &a, const tike::RankedTask &b) {
+		return a.urgency != b.urgency ? a.urgency > b.urgency : a.taskId < b.taskId;
+	}
+}
+
+void tike::ensureUrgency(const db::Database &db) {
+	db.execute(R"(
+		CREATE TABLE IF NOT EXISTS urgencyWeights (
+			name TEXT PRIMARY KEY,
+			weight REAL NOT NULL
+		) WITHOUT ROWID;
+	)");
+}
+
+tike::UrgencyWeights tike::loadUrgencyWeights(const db::Database &db) {
+	UrgencyWeights weights;
+	if (!db.hasTable("urgencyWeights")) {
+		return weights;
+	}
+
+	db::Statement statement = db.prepare("SELECT name, weight FROM urgencyWeights ORDER BY name");
+	while (statement.step()) {
+		const std::string_view name = statement.columnText(0);
+		const double weight = statement.columnDouble(1);
+		if (name == "age") {
+			weights.age = weight;
+		} else if (name == "due") {
+			weights.due = weight;
+		} else if (name == "blocking") {
+			weights.blocking = weight;
+		} else if (name.starts_with(tagPrefix)) {
+			weights.tags.emplace_back(name.substr(tagPrefix.size()), weight);
+		}
+	}
+	return weights;
+}
+
+void tike::setUrgencyWeight(const db::Database &db, const std::string_view name, const std::optional<double> weight) {
+	const bool tagWeight = name.starts_with(tagPrefix) && name.size() > tagPrefix.size();
+	if (name != "age" && name != "due" && name != "blocking" && !tagWeight) {
+		throw std::invalid_argument("Unknown weight, expected age, due, blocking or tag.<name>: " + std::string(name));
+	}
+
+	if (!weight) {
+		db::Statement statement = db.prepare("DELETE FROM urgencyWeights WHERE name = ?");
+		statement.bind(1, std::string(name));
+		statement.step();
+		return;
+	}
+	db::Statement statement = db.prepare("INSERT OR REPLACE INTO urgencyWeights (name, weight) VALUES (?, ?)");
+	statement.bind(1, std::string(name)).bind(2, *weight);
+	statement.step();
+}
+
+std::vector<tike::RankedTask> tike::mostUrgent(const db::Database &db, const std::size_t count,
+                                               const std::int64_t now) {
+	std::vector<RankedTask> heap;
+	if (count == 0) {
+		return heap;
+	}
+
+	const UrgencyWeights weights = loadUrgencyWeights(db);
+	const Dependencies dependencies(db);
+	std::vector<std::pair<RoaringBitmap, double>> tagged;
+	for (const auto &[tag, weight]: weights.tags) {
+		tagged.emplace_back(openTasksTagged(db, tag), weight);
+	}
+
+	/*
+	 * Due dates only exist in databases that have the dueAt column, and usually on few tasks. They are read
+	 * through the partial index on dueAt and walked along with the cursor, which then only reads two columns
+	 */
+	std::vector<std::pair<std::int64_t, double>> dueDates;
+	if (db.hasColumn("tasks", "dueAt")) {
+		db::Statement due = db.prepare("SELECT id, dueAt FROM tasks WHERE dueAt IS NOT NULL");
+		while (due.step()) {
+			dueDates.emplace_back(due.columnInt64(0), due.columnDouble(1));
+		}
+		std::ranges::sort(dueDates);
+	}
+	db::Statement cursor = db.prepare("SELECT id, timeCreated FROM tasks ORDER BY id");
+	db::Statement convertTime = db.prepare("SELECT unixepoch(?)");
+
+	UrgencyColumns columns(chunkSize);
+	std::vector<std::int64_t> taskIds(chunkSize);
+	std::vector<bool> hasDependencies(chunkSize);
+	std::int64_t rowsSeen = 0;
+	const auto nowSeconds = static_cast<double>(now);
+
+	// Tasks with dependencies wait until the cursor is done, by then it is known which tasks on the other end are open
+	std::size_t nextDue = 0;
+	std::size_t nextDependency = 0;
+	std::vector<bool> open(dependencies.tasks.size());
+	std::vector<std::pair<RankedTask, std::size_t>> waiting;
+
+	const auto offer = [&heap, count](const RankedTask &task) {
+		if (heap.size() < count) {
+			heap.push_back(task);
+			std::ranges::push_heap(heap, moreUrgent);
+		} else if (moreUrgent(task, heap.front())) {
+			std::ranges::pop_heap(heap, moreUrgent);
+			heap.back() = task;
+			std::ranges::push_heap(heap, moreUrgent);
+		}
+	};
+
+	// Scores a filled chunk and offers every task without dependencies to the heap of the best `count`
+	const auto flush = [&](const std::size_t size) {
+		std::fill_n(columns.tagBonus.begin(), size, 0.0);
+		for (const auto &[bitmap, weight]: tagged) {
+			for (std::size_t index = 0; index < size; index++) {
+				if (bitmap.contains(static_cast<std::uint32_t>(taskIds[index]))) {
+					columns.tagBonus[index] += weight;
+				}
+			}
+		}
+
+		scoreChunk(size, columns.created.data(), columns.due.data(), columns.hasDue.data(), columns.tagBonus.data(),
+		           columns.score.data(), nowSeconds, weights);
+
+		for (std::size_t index = 0; index < size; index++) {
+			const RankedTask task{
+				taskIds[index], rowsSeen - static_cast<std::int64_t>(size) + static_cast<std::int64_t>(index) + 1,
+				columns.score[index]
+			};
+			if (hasDependencies[index]) {
+				waiting.emplace_back(task, dependencies.indexOf(task.taskId));
+			} else {
+				offer(task);
+			}
+		}
+	};
+
+	std::size_t filled = 0;
+	while (cursor.step()) {
+		const std::int64_t taskId = cursor.columnInt64(0);
+		taskIds[filled] = taskId;
+		if (cursor.columnIsNull(1)) {
+			columns.created[filled] = nowSeconds;
+		} else if (const std::optional<double> created = parseTimestamp(cursor.columnText(1))) {
+			columns.created[filled] = *created;
+		} else {
+			// Written some other way, let SQLite make sense of it
+			convertTime.reset();
+			convertTime.bind(1, std::string(cursor.columnText(1)));
+			convertTime.step();
+			columns.created[filled] = convertTime.columnIsNull(0) ? nowSeconds : convertTime.columnDouble(0);
+		}
+
+		// Due dates and the tasks with dependencies are ordered by id like the cursor, so they are walked along with it
+		while (nextDue < dueDates.size() && dueDates[nextDue].first < taskId) {
+			nextDue++;
+		}
+		const bool hasDue = nextDue < dueDates.size() && dueDates[nextDue].first == taskId;
+		columns.hasDue[filled] = hasDue ? 1.0 : 0.0;
+		columns.due[filled] = hasDue ? dueDates[nextDue].second : nowSeconds;
+		while (nextDependency < dependencies.tasks.size() && dependencies.tasks[nextDependency] < taskId) {
+			nextDependency++;
+		}
+		hasDependencies[filled] = nextDependency < dependencies.tasks.size() &&
+		                          dependencies.tasks[nextDependency] == taskId;
+		if (hasDependencies[filled]) {
+			open[nextDependency] = true;
+		}
+
+		rowsSeen++;
+		if (++filled == chunkSize) {
+			flush(filled);
+			filled = 0;
+		}
+	}
+	flush(filled);
+
+	// Only edges between two open tasks count: they block the one and add to the other's blocking term
+	std::vector<bool> blocked(dependencies.tasks.size());
+	std::vector<double> blocking(dependencies.tasks.size());
+	for (const auto &[taskId, blockedBy]: dependencies.edges) {
+		const std::size_t task = dependencies.indexOf(taskId);
+		const std::size_t blocker = dependencies.indexOf(blockedBy);
+		if (open[task] && open[blocker]) {
+			blocked[task] = true;
+			blocking[blocker]++;
+		}
+	}
+	for (auto &[task, index]: waiting) {
+		if (!blocked[index]) {
+			task.urgency += weights.blocking * blocking[index];
+			offer(task);
+		}
+	}
+
+	std::ranges::sort_heap(heap, moreUrgent);
+	return heap;
+}
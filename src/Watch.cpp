@@ -0,0 +1,197 @@
+#include "Watch.h"
+
+#include "TextWidth.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#endif
+#ifndef _WIN32
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#if !defined(__linux__) && !defined(_WIN32)
+namespace {
+	volatile std::sig_atomic_t resized = 0;
+
+	void onResize(int) {
+		resized = 1;
+	}
+}
+#endif
+
+tike::TerminalSize tike::terminalSize() {
+	TerminalSize size;
+#ifndef _WIN32
+	winsize window{};
+	if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) == 0 && window.ws_col > 0 && window.ws_row > 0) {
+		size.columns = window.ws_col;
+		size.rows = window.ws_row;
+	}
+#endif
+	return size;
+}
+
+tike::DatabaseWatcher::DatabaseWatcher(const std::string &dbPath)
+	: dbPath(dbPath), fileName(std::filesystem::path(dbPath).filename().string()) {
+#ifdef __linux__
+	std::filesystem::path directory = std::filesystem::path(dbPath).parent_path();
+	if (directory.empty()) {
+		directory = ".";
+	}
+	fd = ::inotify_init1(IN_CLOEXEC);
+	if (fd < 0 || ::inotify_add_watch(fd, directory.c_str(),
+	                                   IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_TO) < 0) {
+		const std::string error = std::strerror(errno);
+		if (fd >= 0) {
+			::close(fd);
+		}
+		throw std::runtime_error("Failed to watch " + directory.string() + ": " + error);
+	}
+
+	// Blocked, SIGWINCH is only ever seen through the signalfd, so a resize can't slip in between two waits
+	sigset_t resize;
+	sigemptyset(&resize);
+	sigaddset(&resize, SIGWINCH);
+	::sigprocmask(SIG_BLOCK, &resize, nullptr);
+	signalFd = ::signalfd(-1, &resize, SFD_CLOEXEC);
+#else
+	lastStamp = db::StorageStamp::of(dbPath);
+#ifndef _WIN32
+	struct sigaction action{};
+	action.sa_handler = onResize;
+	sigemptyset(&action.sa_mask);
+	::sigaction(SIGWINCH, &action, nullptr);
+#endif
+#endif
+}
+
+tike::DatabaseWatcher::~DatabaseWatcher() {
+#ifdef __linux__
+	if (fd >= 0) {
+		::close(fd);
+	}
+	if (signalFd >= 0) {
+		::close(signalFd);
+	}
+	sigset_t resize;
+	sigemptyset(&resize);
+	sigaddset(&resize, SIGWINCH);
+	::sigprocmask(SIG_UNBLOCK, &resize, nullptr);
+#elif !defined(_WIN32)
+	::signal(SIGWINCH, SIG_DFL);
+#endif
+}
+
+tike::WatchEvent tike::DatabaseWatcher::wait() {
+#ifdef __linux__
+	const std::string walName = fileName + "-wal";
+	const std::string journalName = fileName + "-journal";
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		pollfd fds[2] = {{fd, POLLIN, 0}, {signalFd, POLLIN, 0}};
+		if (::poll(fds, signalFd >= 0 ? 2 : 1, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::runtime_error("Failed to wait for file events: " + std::string(std::strerror(errno)));
+		}
+		if (signalFd >= 0 && (fds[1].revents & POLLIN) != 0) {
+			signalfd_siginfo info{};
+			if (::read(signalFd, &info, sizeof(info)) > 0) {
+				return WatchEvent::Resized;
+			}
+		}
+		if ((fds[0].revents & POLLIN) == 0) {
+			continue;
+		}
+
+		const ssize_t length = ::read(fd, buffer, sizeof(buffer));
+		if (length < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::runtime_error("Failed to read file events: " + std::string(std::strerror(errno)));
+		}
+
+		// Other files in the directory, like the counter sidecar, are skipped
+		for (ssize_t offset = 0; offset < length;) {
+			const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+			if (event->len > 0) {
+				const std::string_view name(event->name);
+				if (name == fileName || name == walName || name == journalName) {
+					return WatchEvent::Written;
+				}
+			}
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+		}
+	}
+#else
+	for (;;) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+#ifndef _WIN32
+		if (resized) {
+			resized = 0;
+			return WatchEvent::Resized;
+		}
+#endif
+		if (const std::optional<db::StorageStamp> stamp = db::StorageStamp::of(dbPath); stamp != lastStamp) {
+			lastStamp = stamp;
+			return WatchEvent::Written;
+		}
+	}
+#endif
+}
+
+std::string tike::TerminalDiff::update(const std::vector<std::string> &lines) {
+	std::string output;
+	if (!cleared) {
+		output += "\x1b[H\x1b[2J";
+		cleared = true;
+	}
+
+	// Lines that don't fit make way for a footer saying how many there are, writing past the last row would scroll
+	const TerminalSize size = terminalSize();
+	const std::size_t visible = lines.size() > size.rows ? size.rows - 1 : lines.size();
+	std::vector<std::string> frame;
+	frame.reserve(std::min(lines.size(), size.rows));
+	for (std::size_t row = 0; row < visible; row++) {
+		frame.push_back(lines[row].substr(0, fitToWidth(lines[row], size.columns).bytes));
+	}
+	if (visible < lines.size()) {
+		const std::string footer = "+" + std::to_string(lines.size() - visible) + " more";
+		frame.push_back(footer.substr(0, fitToWidth(footer, size.columns).bytes));
+	}
+
+	for (std::size_t row = 0; row < frame.size(); row++) {
+		if (row >= shown.size() || shown[row] != frame[row]) {
+			// Move to the start of the row, write it and clear what is left of the old one
+			output += "\x1b[" + std::to_string(row + 1) + ";1H" + frame[row] + "\x1b[K";
+		}
+	}
+	if (frame.size() < shown.size()) {
+		output += "\x1b[" + std::to_string(frame.size() + 1) + ";1H\x1b[J";
+	}
+	if (!output.empty()) {
+		output += "\x1b[" + std::to_string(std::min(frame.size() + 1, size.rows)) + ";1H";
+	}
+
+	shown = std::move(frame);
+	return output;
+}
+
+void tike::TerminalDiff::reset() {
+	shown.clear();
+	cleared = false;
+}
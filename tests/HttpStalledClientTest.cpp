@@ -0,0 +1,253 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/*
+ * A client that asks for a long task list and then stops reading must not hold up writes: while its list is
+ * stuck, a POST from another client has to be answered well within SQLite's busy timeout of 5 seconds. A client
+ * that stays stuck past the send timeout is disconnected, and the server goes on answering everyone else.
+ *
+ *     tike_http_test <path of tike>
+ */
+namespace {
+	constexpr int bigTasks = 24;
+	constexpr std::size_t descriptionBytes = 512 * 1024;
+	constexpr auto postDeadline = std::chrono::seconds(3);
+	constexpr auto sendTimeout = std::chrono::seconds(2);
+
+	void check(const bool condition, const std::string &message) {
+		if (!condition) {
+			throw std::runtime_error(message);
+		}
+	}
+
+	// tike http on a free port, with HOME in a directory of its own
+	class Server {
+	public:
+		Server(const std::string &tike, const std::filesystem::path &home) {
+			int output[2];
+			check(::pipe(output) == 0, "pipe failed");
+			pid = ::fork();
+			check(pid >= 0, "fork failed");
+			if (pid == 0) {
+				::dup2(output[1], STDOUT_FILENO);
+				::close(output[0]);
+				::setenv("HOME", home.c_str(), 1);
+				const std::string timeout = std::to_string(sendTimeout.count());
+				::execl(tike.c_str(), "tike", "http", "127.0.0.1:0", "--send-timeout", timeout.c_str(), nullptr);
+				::_exit(127);
+			}
+			::close(output[1]);
+
+			// "Serving on http://127.0.0.1:port"
+			FILE *lines = ::fdopen(output[0], "r");
+			char line[256] = {};
+			const bool served = std::fgets(line, sizeof(line), lines) != nullptr;
+			std::fclose(lines);
+			const std::string address = line;
+			check(served && address.rfind(':') != std::string::npos, "tike http didn't start");
+			port = static_cast<std::uint16_t>(std::stoi(address.substr(address.rfind(':') + 1)));
+		}
+
+		~Server() {
+			::kill(pid, SIGTERM);
+			::waitpid(pid, nullptr, 0);
+		}
+
+		Server(const Server &) = delete;
+
+		Server &operator=(const Server &) = delete;
+
+		std::uint16_t port = 0;
+
+	private:
+		pid_t pid;
+	};
+
+	class Client {
+	public:
+		// A small receive buffer makes a client that stops reading push back on the server right away
+		explicit Client(const std::uint16_t port, const int receiveBuffer = 0) : fd(::socket(AF_INET, SOCK_STREAM, 0)) {
+			check(fd >= 0, "socket failed");
+			if (receiveBuffer > 0) {
+				::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+			}
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			check(::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0, "connect failed");
+		}
+
+		~Client() {
+			::close(fd);
+		}
+
+		Client(const Client &) = delete;
+
+		Client &operator=(const Client &) = delete;
+
+		void send(const std::string &bytes) const {
+			for (std::size_t sent = 0; sent < bytes.size();) {
+				const ssize_t written = ::send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+				check(written > 0, "send failed");
+				sent += static_cast<std::size_t>(written);
+			}
+		}
+
+		// Appends what one read returns, false if nothing arrived before the deadline
+		bool readSome(std::string &received, const std::chrono::steady_clock::time_point deadline) const {
+			const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now()).count();
+			pollfd input{fd, POLLIN, 0};
+			if (left <= 0 || ::poll(&input, 1, static_cast<int>(left)) <= 0) {
+				return false;
+			}
+			char buffer[64 * 1024];
+			const ssize_t read = ::recv(fd, buffer, sizeof(buffer), 0);
+			check(read > 0, "the server closed the connection");
+			received.append(buffer, static_cast<std::size_t>(read));
+			return true;
+		}
+
+		// Reads until the received text ends with the marker, false if the deadline passes first
+		bool readUntil(std::string &received, const std::string &marker,
+		               const std::chrono::steady_clock::time_point deadline) const {
+			while (!received.ends_with(marker)) {
+				if (!readSome(received, deadline)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Reads until the server closes the connection, false if the deadline passes first
+		bool readUntilClosed(std::string &received, const std::chrono::steady_clock::time_point deadline) const {
+			for (;;) {
+				const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+					deadline - std::chrono::steady_clock::now()).count();
+				pollfd input{fd, POLLIN, 0};
+				if (left <= 0 || ::poll(&input, 1, static_cast<int>(left)) <= 0) {
+					return false;
+				}
+				char buffer[64 * 1024];
+				const ssize_t read = ::recv(fd, buffer, sizeof(buffer), 0);
+				if (read == 0 || (read < 0 && errno == ECONNRESET)) {
+					return true;
+				}
+				check(read > 0, "recv failed");
+				received.append(buffer, static_cast<std::size_t>(read));
+			}
+		}
+
+		// Sends a POST /tasks and waits for the whole response, which ends with the JSON object
+		std::string post(const std::string &body, const std::chrono::steady_clock::time_point deadline) const {
+			send("POST /tasks HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + std::to_string(body.size()) +
+			     "\r\n\r\n" + body);
+			std::string response;
+			readUntil(response, "}", deadline);
+			return response;
+		}
+
+	private:
+		int fd;
+	};
+}
+
+int main(const int argc, const char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <path of tike>" << std::endl;
+		return 1;
+	}
+
+	char directory[] = "/tmp/tike_http_test_XXXXXX";
+	if (::mkdtemp(directory) == nullptr) {
+		std::cerr << "mkdtemp failed" << std::endl;
+		return 1;
+	}
+	const std::filesystem::path home = directory;
+
+	int result = 0;
+	try {
+		const Server server(argv[1], home);
+
+		// Enough for the list to fill the socket buffers and the queue of the response many times over
+		{
+			const Client seeder(server.port);
+			const std::string description(descriptionBytes, 'x');
+			for (int index = 0; index < bigTasks; index++) {
+				const std::string response = seeder.post(
+					R"({"title": "big )" + std::to_string(index) + R"(", "description": ")" + description + "\"}",
+					std::chrono::steady_clock::now() + std::chrono::seconds(10));
+				check(response.starts_with("HTTP/1.1 201"), "adding a task failed: " + response.substr(0, 40));
+			}
+		}
+
+		// Reads the start of the list and then nothing, the reader thread ends up waiting for it
+		const Client stalled(server.port, 4096);
+		stalled.send("GET /tasks HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::string list;
+		stalled.readSome(list, std::chrono::steady_clock::now() + std::chrono::seconds(5));
+		check(list.starts_with("HTTP/1.1 200"), "the list didn't start");
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+		const auto start = std::chrono::steady_clock::now();
+		const std::string response = Client(server.port).post(R"({"title": "added while a list is stuck"})",
+		                                                      start + postDeadline);
+		const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+		check(response.starts_with("HTTP/1.1 201"),
+		      "a POST during a stalled list took " + std::to_string(took.count()) + " ms and got: " +
+		      (response.empty() ? "nothing" : response.substr(0, 40)));
+
+		// The stalled list still arrives whole once its client reads again
+		check(stalled.readUntil(list, "]\r\n0\r\n\r\n", std::chrono::steady_clock::now() + std::chrono::seconds(30)),
+		      "the stalled list didn't finish");
+		check(list.find(R"("title":"big )" + std::to_string(bigTasks - 1) + "\"") != std::string::npos,
+		      "the stalled list is missing its last task");
+		// A client that stays stuck past the send timeout is cut off before its list is complete
+		const Client abandoned(server.port, 4096);
+		abandoned.send("GET /tasks HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::string partial;
+		abandoned.readSome(partial, std::chrono::steady_clock::now() + std::chrono::seconds(5));
+		check(partial.starts_with("HTTP/1.1 200"), "the second list didn't start");
+		std::this_thread::sleep_for(sendTimeout + std::chrono::seconds(2));
+		check(abandoned.readUntilClosed(partial, std::chrono::steady_clock::now() + std::chrono::seconds(10)),
+		      "the server didn't close a connection stalled past the send timeout");
+		check(!partial.ends_with("]\r\n0\r\n\r\n"), "the list of the stalled connection was sent whole");
+
+		// Its reader gave up on it, so lists and single tasks keep being answered
+		for (int round = 0; round < 3; round++) {
+			const Client reader(server.port);
+			reader.send("GET /tasks HTTP/1.1\r\nHost: localhost\r\n\r\n");
+			std::string whole;
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			check(reader.readUntil(whole, "]\r\n0\r\n\r\n", deadline), "a list after the cut off connection didn't finish");
+		}
+		const Client single(server.port);
+		single.send("GET /tasks/1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		std::string task;
+		check(single.readUntil(task, "}", std::chrono::steady_clock::now() + std::chrono::seconds(5)) &&
+		      task.starts_with("HTTP/1.1 200"), "a GET after the cut off connection failed");
+
+		std::cout << "POST answered in " << took.count() << " ms while a list was stalled" << std::endl;
+	} catch (const std::exception &error) {
+		std::cerr << "FAIL: " << error.what() << std::endl;
+		result = 1;
+	}
+	std::filesystem::remove_all(home);
+	return result;
+}
@@ -0,0 +1,155 @@
+#include <fcntl.h>
+#include <sqlite3.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Holds `tike -L` to a budget of heap allocations per listed task. Runs a TIKE_ALLOC_STATS build with
+ * --perf-counters over two table sizes and divides the difference of the allocations by the difference of the
+ * rows, so what every run allocates once doesn't count. Each size is listed twice, the first run rebuilds the
+ * snapshot sidecar and the second answers from it, both have to stay within the budget.
+ *
+ *     tike_list_allocations_test <path of a TIKE_ALLOC_STATS build of tike>
+ */
+namespace {
+	constexpr std::int64_t fewerTasks = 2000;
+	constexpr std::int64_t moreTasks = 20000;
+	// Each of the three cells of a row is a string from fitCell that grows once more for its trailing space, six
+	// allocations per row now. The budget leaves room for another standard library, not for another copy per cell
+	constexpr int allocationsPerRow = 8;
+
+	void check(const bool condition, const std::string &message) {
+		if (!condition) {
+			throw std::runtime_error(message);
+		}
+	}
+
+	std::string readFile(const std::filesystem::path &path) {
+		std::ifstream in(path);
+		std::stringstream text;
+		text << in.rdbuf();
+		return text.str();
+	}
+
+	// Runs tike with HOME in the test directory, and returns what it wrote to stderr. Stdout goes to a file
+	std::string runTike(const std::string &tike, const std::filesystem::path &home,
+	                    const std::vector<std::string> &arguments) {
+		const std::filesystem::path out = home / "stdout";
+		const std::filesystem::path err = home / "stderr";
+		const pid_t pid = ::fork();
+		check(pid >= 0, "fork failed");
+		if (pid == 0) {
+			::dup2(::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644), STDOUT_FILENO);
+			::dup2(::open(err.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644), STDERR_FILENO);
+			::setenv("HOME", home.c_str(), 1);
+			std::vector<char *> argv{const_cast<char *>("tike")};
+			for (const std::string &argument: arguments) {
+				argv.push_back(const_cast<char *>(argument.c_str()));
+			}
+			argv.push_back(nullptr);
+			::execv(tike.c_str(), argv.data());
+			::_exit(127);
+		}
+		int status = 0;
+		::waitpid(pid, &status, 0);
+		check(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+		      "tike failed: " + readFile(err) + readFile(out).substr(0, 200));
+		return readFile(err);
+	}
+
+	// Adds tasks straight to the tasks table until it holds `count`, the sidecars notice the change by its stamp
+	void fillTasks(const std::filesystem::path &dbPath, const std::int64_t count) {
+		sqlite3 *db = nullptr;
+		check(sqlite3_open(dbPath.c_str(), &db) == SQLITE_OK, "can't open the database");
+		const std::string sql = R"(
+			WITH RECURSIVE number(n) AS (SELECT count(*) + 1 FROM tasks UNION ALL SELECT n + 1 FROM number WHERE n < )" +
+		                        std::to_string(count) + R"()
+			INSERT INTO tasks (title, description) SELECT 'Task number ' || n, 'Description of task ' || n FROM number
+		)";
+		char *error = nullptr;
+		const int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error);
+		const std::string message = error ? error : "";
+		sqlite3_free(error);
+		sqlite3_close(db);
+		check(result == SQLITE_OK, "adding tasks failed: " + message);
+	}
+
+	// Adds up the Allocations column over the phases of a --perf-counters report
+	std::uint64_t allocations(const std::string &report) {
+		check(report.find("Allocations") != std::string::npos, "the report has no allocation counts, is this a "
+		      "TIKE_ALLOC_STATS build?");
+		std::uint64_t total = 0;
+		std::istringstream lines(report);
+		for (std::string line; std::getline(lines, line);) {
+			// "<phase> <time> ms <counters...> <allocations> <bytes> <IPC>"
+			std::istringstream words(line);
+			std::vector<std::string> columns;
+			for (std::string word; words >> word;) {
+				columns.push_back(word);
+			}
+			if (columns.size() > 5 && columns[2] == "ms") {
+				total += std::stoull(columns[columns.size() - 3]);
+			}
+		}
+		return total;
+	}
+
+	// The allocations of a cold and a warm listing
+	std::pair<std::uint64_t, std::uint64_t> listAllocations(const std::string &tike, const std::filesystem::path &home,
+	                                                        const std::int64_t tasks) {
+		const std::uint64_t cold = allocations(runTike(tike, home, {"-L", "--perf-counters"}));
+		const std::uint64_t warm = allocations(runTike(tike, home, {"-L", "--perf-counters"}));
+		const std::string listing = readFile(home / "stdout");
+		check(listing.find("Task number " + std::to_string(tasks - 1) + " ") != std::string::npos,
+		      "the listing is missing tasks");
+		return {cold, warm};
+	}
+}
+
+int main(const int argc, const char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <path of a TIKE_ALLOC_STATS build of tike>" << std::endl;
+		return 1;
+	}
+
+	char directory[] = "/tmp/tike_alloc_test_XXXXXX";
+	if (::mkdtemp(directory) == nullptr) {
+		std::cerr << "mkdtemp failed" << std::endl;
+		return 1;
+	}
+	const std::filesystem::path home = directory;
+
+	int result = 0;
+	try {
+		// Creates the database with its schema
+		runTike(argv[1], home, {"add", "-t", "Task number 0"});
+
+		fillTasks(home / ".tike.db", fewerTasks);
+		const auto [fewerCold, fewerWarm] = listAllocations(argv[1], home, fewerTasks);
+		fillTasks(home / ".tike.db", moreTasks);
+		const auto [moreCold, moreWarm] = listAllocations(argv[1], home, moreTasks);
+
+		constexpr auto rows = static_cast<double>(moreTasks - fewerTasks);
+		const double cold = (static_cast<double>(moreCold) - static_cast<double>(fewerCold)) / rows;
+		const double warm = (static_cast<double>(moreWarm) - static_cast<double>(fewerWarm)) / rows;
+		std::cout << "Allocations per listed task: " << cold << " rebuilding the snapshot, " << warm << " from it"
+				<< std::endl;
+		check(cold <= allocationsPerRow && warm <= allocationsPerRow,
+		      "tike -L allocates more than " + std::to_string(allocationsPerRow) + " times per task");
+	} catch (const std::exception &error) {
+		std::cerr << "FAIL: " << error.what() << std::endl;
+		result = 1;
+	}
+	std::filesystem::remove_all(home);
+	return result;
+}